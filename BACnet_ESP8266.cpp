@@ -1,4 +1,5 @@
 #include "BACnet_ESP8266.h"
+#include "StringGuard.h"
 
 BACnet_ESP8266::BACnet_ESP8266() {
     objects = nullptr;
@@ -15,7 +16,7 @@ bool BACnet_ESP8266::begin(uint32_t deviceInstance) {
     this->deviceInstance = deviceInstance;
     
     if (udp.begin(localPort)) {
-        Serial.println("BACnet: UDP server started on port " + String(localPort));
+        Serial.printf("BACnet: UDP server started on port %u\n", localPort);
         return true;
     }
     return false;
@@ -34,18 +35,40 @@ bool BACnet_ESP8266::addObject(uint8_t objectType, uint32_t objectId, const char
     objects[objectCount].objectId = objectId;
     objects[objectCount].objectType = objectType;
     strncpy(objects[objectCount].objectName, objectName, 31);
+    objects[objectCount].objectName[31] = '\0';
     objects[objectCount].presentValue = initialValue;
+    objects[objectCount].stateText = nullptr;
+    objects[objectCount].stateCount = 0;
     
     objectCount++;
-    Serial.println("BACnet: Added object " + String(objectName) + " (ID: " + String(objectId) + ")");
+    Serial.printf("BACnet: Added object %s (ID: %lu)\n", objectName, (unsigned long)objectId);
     return true;
 }
 
+bool BACnet_ESP8266::addMultiStateObject(uint8_t objectType, uint32_t objectId, const char* objectName,
+                                         const char* const* stateText, uint8_t stateCount, uint8_t initialState) {
+    if (!BACNET_IS_MULTI_STATE(objectType) || stateCount == 0) return false;
+    
+    addObject(objectType, objectId, objectName, initialState);
+    objects[objectCount - 1].stateText = stateText;
+    objects[objectCount - 1].stateCount = stateCount;
+    return true;
+}
+
+BACnet_ESP8266::BACnetObject* BACnet_ESP8266::findObject(uint32_t objectId) {
+    for (uint8_t i = 0; i < objectCount; i++) {
+        if (objects[i].objectId == objectId) {
+            return &objects[i];
+        }
+    }
+    return nullptr;
+}
+
 bool BACnet_ESP8266::setPresentValue(uint32_t objectId, float value) {
     for (uint8_t i = 0; i < objectCount; i++) {
         if (objects[i].objectId == objectId) {
             objects[i].presentValue = value;
-            Serial.println("BACnet: Object " + String(objectId) + " value set to " + String(value));
+            Serial.printf("BACnet: Object %lu value set to %.2f\n", (unsigned long)objectId, value);
             return true;
         }
     }
@@ -61,14 +84,31 @@ float BACnet_ESP8266::getPresentValue(uint32_t objectId) {
     return 0.0;
 }
 
+// Checked on every datagram before it is decoded: BVLC type and function,
+// BVLC length against the datagram size, and the length the service needs
+static inline bool isAcceptableFrame(const uint8_t* frame, int len) {
+    if (len < BACNET_READ_REQUEST_LENGTH || frame[0] != 0x81) return false;
+    if (frame[1] != 0x0A && frame[1] != 0x0B) return false; // Original-Unicast/Broadcast-NPDU
+    if (((frame[2] << 8) | frame[3]) != len) return false;
+    if (frame[4] == BACNET_SERVICE_READ_PROPERTY) return true;
+    return frame[4] == BACNET_SERVICE_WRITE_PROPERTY && len >= BACNET_WRITE_REQUEST_LENGTH;
+}
+
 void BACnet_ESP8266::update() {
     int packetSize = udp.parsePacket();
     if (packetSize) {
+        int len = udp.read(buffer, sizeof(buffer));
+        
+        uint32_t checkStart = ESP.getCycleCount();
+        if (!isAcceptableFrame(buffer, len)) {
+            rejectedFrames++;
+            rejectCycles += ESP.getCycleCount() - checkStart;
+            return;
+        }
+        
         IPAddress remoteIP = udp.remoteIP();
         uint16_t remotePort = udp.remotePort();
         
-        int len = udp.read(buffer, sizeof(buffer));
-        
         uint32_t invokingDevice;
         uint8_t serviceChoice;
         uint32_t objectId;
@@ -77,32 +117,32 @@ void BACnet_ESP8266::update() {
         float value;
         
         if (decodeAPDU(buffer, len, &invokingDevice, &serviceChoice, &objectId, &objectType, &propertyId, &value)) {
+            BACnetObject* object = findObject(objectId);
+            if (object == nullptr) return;
+            uint16_t responseLength = 0;
+            
             switch (serviceChoice) {
                 case BACNET_SERVICE_READ_PROPERTY:
-                    Serial.println("BACnet: ReadProperty request for object " + String(objectId));
-                    // Handle read property - simplified implementation
-                    for (uint8_t i = 0; i < objectCount; i++) {
-                        if (objects[i].objectId == objectId) {
-                            // Send response with present value
-                            uint16_t responseLength = 0;
-                            encodeReadProperty(buffer, &responseLength, deviceInstance, objectId, objectType, propertyId);
-                            udp.beginPacket(remoteIP, remotePort);
-                            udp.write(buffer, responseLength);
-                            udp.endPacket();
-                            break;
-                        }
+                    Serial.printf("BACnet: ReadProperty request for object %lu\n", (unsigned long)objectId);
+                    if (!encodeReadProperty(buffer, &responseLength, deviceInstance, objectId, objectType, propertyId)) {
+                        sendErrorResponse(buffer, &responseLength, serviceChoice, BACNET_ERROR_CODE_UNKNOWN_PROPERTY);
                     }
+                    sendPacket(remoteIP, remotePort, responseLength);
                     break;
                     
                 case BACNET_SERVICE_WRITE_PROPERTY:
-                    Serial.println("BACnet: WriteProperty request for object " + String(objectId) + " value: " + String(value));
-                    if (setPresentValue(objectId, value)) {
-                        // Send success response
-                        uint16_t responseLength = 0;
-                        encodeWriteProperty(buffer, &responseLength, deviceInstance, objectId, objectType, propertyId, value);
-                        udp.beginPacket(remoteIP, remotePort);
-                        udp.write(buffer, responseLength);
-                        udp.endPacket();
+                    Serial.printf("BACnet: WriteProperty request for object %lu value: %.2f\n", (unsigned long)objectId, value);
+                    // Multi-state values must name one of the object's states
+                    if (object->stateCount > 0 && (value != (int)value || value < 1 || value > object->stateCount)) {
+                        sendErrorResponse(buffer, &responseLength, serviceChoice, BACNET_ERROR_CODE_VALUE_OUT_OF_RANGE);
+                        sendPacket(remoteIP, remotePort, responseLength);
+                        break;
+                    }
+                    setPresentValue(objectId, value);
+                    encodeWriteProperty(buffer, &responseLength, deviceInstance, objectId, objectType, propertyId, value);
+                    sendPacket(remoteIP, remotePort, responseLength);
+                    if (writeCallback != nullptr) {
+                        writeCallback(objectId, value);
                     }
                     break;
             }
@@ -110,52 +150,184 @@ void BACnet_ESP8266::update() {
     }
 }
 
+void BACnet_ESP8266::sendPacket(IPAddress remoteIP, uint16_t remotePort, uint16_t length) {
+    udp.beginPacket(remoteIP, remotePort);
+    udp.write(buffer, length);
+    udp.endPacket();
+}
+
 // Simplified BACnet PDU encoding/decoding (minimal implementation)
-void BACnet_ESP8266::encodeReadProperty(uint8_t* buffer, uint16_t* length, 
+bool BACnet_ESP8266::encodeReadProperty(uint8_t* buffer, uint16_t* length, 
                                        uint32_t deviceId, uint32_t objectId, 
                                        uint8_t objectType, uint32_t propertyId) {
-    // Simplified BACnet ReadProperty response
+    BACnetObject* object = findObject(objectId);
+    if (object == nullptr) return false;
+    
     uint16_t idx = 0;
+    uint32_t objectIdentifier = ((uint32_t)object->objectType << 22) | (objectId & 0x3FFFFF);
     
-    // BVLC header (simplified)
+    // BVLC header, length filled in once the value is encoded
     buffer[idx++] = 0x81; // BACnet/IP
     buffer[idx++] = 0x0A; // Original Unicast NPDU
-    buffer[idx++] = 0x00; // Length high
-    buffer[idx++] = 0x0C; // Length low
+    buffer[idx++] = 0x00;
+    buffer[idx++] = 0x00;
     
-    // APDU
-    buffer[idx++] = 0x00; // Version
-    buffer[idx++] = 0x00; // Reserved
+    // NPDU
+    buffer[idx++] = 0x01; // Version
+    buffer[idx++] = 0x00; // Control
+    
+    // APDU: Complex-ACK for ReadProperty
+    buffer[idx++] = 0x30;
+    buffer[idx++] = 0x00; // Invoke ID
+    buffer[idx++] = BACNET_SERVICE_READ_PROPERTY;
+    buffer[idx++] = 0x0C; // Context 0, object identifier
+    buffer[idx++] = objectIdentifier >> 24;
+    buffer[idx++] = objectIdentifier >> 16;
+    buffer[idx++] = objectIdentifier >> 8;
+    buffer[idx++] = objectIdentifier;
+    buffer[idx++] = 0x19; // Context 1, property identifier
+    buffer[idx++] = propertyId;
+    buffer[idx++] = 0x3E; // Opening tag 3, property value
+    
+    switch (propertyId) {
+        case BACNET_PROP_PRESENT_VALUE:
+            if (object->stateCount > 0) {
+                encodeUnsigned(buffer, &idx, (uint32_t)object->presentValue);
+            } else if (object->objectType == BACNET_OBJECT_BINARY_INPUT || object->objectType == BACNET_OBJECT_BINARY_OUTPUT) {
+                buffer[idx++] = 0x91; // Enumerated, active/inactive
+                buffer[idx++] = object->presentValue != 0 ? 1 : 0;
+            } else {
+                uint32_t bits;
+                memcpy(&bits, &object->presentValue, sizeof(bits));
+                buffer[idx++] = 0x44; // Real
+                buffer[idx++] = bits >> 24;
+                buffer[idx++] = bits >> 16;
+                buffer[idx++] = bits >> 8;
+                buffer[idx++] = bits;
+            }
+            break;
+            
+        case BACNET_PROP_OBJECT_ID:
+            buffer[idx++] = 0xC4; // Object identifier
+            buffer[idx++] = objectIdentifier >> 24;
+            buffer[idx++] = objectIdentifier >> 16;
+            buffer[idx++] = objectIdentifier >> 8;
+            buffer[idx++] = objectIdentifier;
+            break;
+            
+        case BACNET_PROP_OBJECT_NAME:
+            encodeCharacterString(buffer, &idx, object->objectName);
+            break;
+            
+        case BACNET_PROP_NUMBER_OF_STATES:
+            if (object->stateCount == 0) return false;
+            encodeUnsigned(buffer, &idx, object->stateCount);
+            break;
+            
+        case BACNET_PROP_STATE_TEXT:
+            if (object->stateCount == 0) return false;
+            for (uint8_t i = 0; i < object->stateCount; i++) {
+                encodeCharacterString(buffer, &idx, object->stateText[i]);
+            }
+            break;
+            
+        default:
+            return false;
+    }
     
+    buffer[idx++] = 0x3F; // Closing tag 3
+    buffer[2] = idx >> 8;
+    buffer[3] = idx & 0xFF;
     *length = idx;
+    return true;
 }
 
 void BACnet_ESP8266::encodeWriteProperty(uint8_t* buffer, uint16_t* length,
                                        uint32_t deviceId, uint32_t objectId,
                                        uint8_t objectType, uint32_t propertyId,
                                        float value) {
-    // Simplified BACnet WriteProperty response
+    // BACnet WriteProperty Simple-ACK
     uint16_t idx = 0;
     
-    // BVLC header (simplified)
+    // BVLC header
     buffer[idx++] = 0x81; // BACnet/IP
     buffer[idx++] = 0x0A; // Original Unicast NPDU
     buffer[idx++] = 0x00; // Length high
-    buffer[idx++] = 0x0C; // Length low
+    buffer[idx++] = 0x09; // Length low
+    
+    // NPDU
+    buffer[idx++] = 0x01; // Version
+    buffer[idx++] = 0x00; // Control
     
     // APDU
-    buffer[idx++] = 0x00; // Version
-    buffer[idx++] = 0x00; // Reserved
+    buffer[idx++] = 0x20; // Simple-ACK
+    buffer[idx++] = 0x00; // Invoke ID
+    buffer[idx++] = BACNET_SERVICE_WRITE_PROPERTY;
     
     *length = idx;
 }
 
+void BACnet_ESP8266::sendErrorResponse(uint8_t* buffer, uint16_t* length, uint8_t serviceChoice, uint8_t errorCode) {
+    uint16_t idx = 0;
+    
+    // BVLC header
+    buffer[idx++] = 0x81;
+    buffer[idx++] = 0x0A;
+    buffer[idx++] = 0x00;
+    buffer[idx++] = 0x0D;
+    
+    // NPDU
+    buffer[idx++] = 0x01;
+    buffer[idx++] = 0x00;
+    
+    // APDU: Error, class property
+    buffer[idx++] = 0x50;
+    buffer[idx++] = 0x00; // Invoke ID
+    buffer[idx++] = serviceChoice;
+    buffer[idx++] = 0x91; // Enumerated error class
+    buffer[idx++] = 0x02; // Property
+    buffer[idx++] = 0x91; // Enumerated error code
+    buffer[idx++] = errorCode;
+    
+    *length = idx;
+}
+
+void BACnet_ESP8266::encodeUnsigned(uint8_t* buffer, uint16_t* idx, uint32_t value) {
+    if (value <= 0xFF) {
+        buffer[(*idx)++] = 0x21;
+    } else if (value <= 0xFFFF) {
+        buffer[(*idx)++] = 0x22;
+        buffer[(*idx)++] = value >> 8;
+    } else {
+        buffer[(*idx)++] = 0x24;
+        buffer[(*idx)++] = value >> 24;
+        buffer[(*idx)++] = value >> 16;
+        buffer[(*idx)++] = value >> 8;
+    }
+    buffer[(*idx)++] = value;
+}
+
+void BACnet_ESP8266::encodeCharacterString(uint8_t* buffer, uint16_t* idx, const char* text) {
+    uint8_t textLength = strnlen(text, 31);
+    
+    // Length includes the character set byte
+    if (textLength + 1 <= 4) {
+        buffer[(*idx)++] = 0x70 | (textLength + 1);
+    } else {
+        buffer[(*idx)++] = 0x75;
+        buffer[(*idx)++] = textLength + 1;
+    }
+    buffer[(*idx)++] = 0x00; // UTF-8
+    memcpy(&buffer[*idx], text, textLength);
+    *idx += textLength;
+}
+
 bool BACnet_ESP8266::decodeAPDU(uint8_t* apdu, uint16_t apduLen, 
                                uint32_t* invokingDevice, uint8_t* serviceChoice,
                                uint32_t* objectId, uint8_t* objectType,
                                uint32_t* propertyId, float* value) {
     // Simplified BACnet APDU decoding
-    if (apduLen < 10) return false;
+    if (apduLen < BACNET_READ_REQUEST_LENGTH) return false;
     
     // Skip BVLC header (simplified)
     uint16_t idx = 4;
@@ -11,16 +11,33 @@
 #define BACNET_OBJECT_ANALOG_OUTPUT 1
 #define BACNET_OBJECT_BINARY_INPUT 3
 #define BACNET_OBJECT_BINARY_OUTPUT 4
+#define BACNET_OBJECT_MULTI_STATE_OUTPUT 14
+#define BACNET_OBJECT_MULTI_STATE_VALUE 19
 
 // BACnet Property Identifiers
 #define BACNET_PROP_OBJECT_ID 75
 #define BACNET_PROP_OBJECT_NAME 77
 #define BACNET_PROP_PRESENT_VALUE 85
+#define BACNET_PROP_NUMBER_OF_STATES 74
+#define BACNET_PROP_STATE_TEXT 110
+
+// BACnet Error Codes
+#define BACNET_ERROR_CODE_UNKNOWN_PROPERTY 32
+#define BACNET_ERROR_CODE_VALUE_OUT_OF_RANGE 37
 
 // BACnet Services
 #define BACNET_SERVICE_READ_PROPERTY 12
 #define BACNET_SERVICE_WRITE_PROPERTY 15
 
+// Request frame: BVLC header, service choice, object id (4), object type, property id, value (4, writes only)
+#define BACNET_READ_REQUEST_LENGTH 11
+#define BACNET_WRITE_REQUEST_LENGTH 15
+
+#define BACNET_IS_MULTI_STATE(type) ((type) == BACNET_OBJECT_MULTI_STATE_OUTPUT || (type) == BACNET_OBJECT_MULTI_STATE_VALUE)
+
+// Called after a WriteProperty has been accepted for an object's present value
+typedef void (*BACnetWriteCallback)(uint32_t objectId, float value);
+
 class BACnet_ESP8266 {
 private:
     WiFiUDP udp;
@@ -35,13 +52,23 @@ private:
         uint8_t objectType;
         char objectName[32];
         float presentValue;
+        // Multi-state objects only; present value runs 1..stateCount
+        const char* const* stateText;
+        uint8_t stateCount;
     } BACnetObject;
     
     BACnetObject* objects;
     uint8_t objectCount;
+    BACnetWriteCallback writeCallback = nullptr;
+    uint32_t rejectedFrames = 0;
+    uint64_t rejectCycles = 0;
+    
+    BACnetObject* findObject(uint32_t objectId);
+    void encodeUnsigned(uint8_t* buffer, uint16_t* idx, uint32_t value);
+    void encodeCharacterString(uint8_t* buffer, uint16_t* idx, const char* text);
     
     // BACnet PDU functions
-    void encodeReadProperty(uint8_t* buffer, uint16_t* length, 
+    bool encodeReadProperty(uint8_t* buffer, uint16_t* length, 
                            uint32_t deviceId, uint32_t objectId, 
                            uint8_t objectType, uint32_t propertyId);
     
@@ -55,7 +82,8 @@ private:
                    uint32_t* objectId, uint8_t* objectType,
                    uint32_t* propertyId, float* value);
     
-    void sendErrorResponse(uint8_t* buffer, uint16_t* length, uint8_t errorCode);
+    void sendErrorResponse(uint8_t* buffer, uint16_t* length, uint8_t serviceChoice, uint8_t errorCode);
+    void sendPacket(IPAddress remoteIP, uint16_t remotePort, uint16_t length);
 
 public:
     BACnet_ESP8266();
@@ -66,29 +94,19 @@ public:
     
     // Object management
     bool addObject(uint8_t objectType, uint32_t objectId, const char* objectName, float initialValue = 0.0);
+    bool addMultiStateObject(uint8_t objectType, uint32_t objectId, const char* objectName,
+                             const char* const* stateText, uint8_t stateCount, uint8_t initialState = 1);
+    void onWrite(BACnetWriteCallback callback) { writeCallback = callback; }
     bool setPresentValue(uint32_t objectId, float value);
     float getPresentValue(uint32_t objectId);
     
-    // Object management for building automation
-    void updateBuildingObjects(bool lightState, float lightBrightness, float temperature, 
-                              bool acState, const String& acMode, int fanSpeed) {
-        setPresentValue(LIGHT_OBJECT_ID, lightState ? 1.0 : 0.0);
-        setPresentValue(LIGHT_BRIGHTNESS_OBJECT_ID, lightBrightness);
-        setPresentValue(TEMPERATURE_OBJECT_ID, temperature);
-        setPresentValue(AC_STATE_OBJECT_ID, acState ? 1.0 : 0.0);
-        
-        // Convert AC mode to numeric value
-        float modeValue = 1.0; // cool
-        if (acMode == "heat") modeValue = 2.0;
-        else if (acMode == "auto") modeValue = 3.0;
-        setPresentValue(AC_MODE_OBJECT_ID, modeValue);
-        
-        setPresentValue(FAN_SPEED_OBJECT_ID, (float)fanSpeed);
-    }
-    
     // Network configuration
     void setDeviceInstance(uint32_t instance) { deviceInstance = instance; }
     uint32_t getDeviceInstance() { return deviceInstance; }
+    
+    // Datagrams dropped by the framing check, and its average cost in CPU cycles
+    uint32_t getRejectedFrames() { return rejectedFrames; }
+    uint32_t getRejectCost() { return rejectedFrames ? rejectCycles / rejectedFrames : 0; }
 };
 
 #endif
\ No newline at end of file
@@ -2,38 +2,87 @@
 #include "src/config/pins.h"
 #include "src/config/credentials.h"
 #include "src/BACnet/BACnetProtocol.h"
-#include "src/Firebase/FirebaseManager.h"
+#include "src/Firebase/CloudTransport.h"
+#include "src/Firebase/CloudJournal.h"
 #include "src/Sensors/SensorManager.h"
 #include "src/DeviceControl/DeviceManager.h"
 #include "src/Network/WiFiManager.h"
+#include "src/TrendLog/TrendLogManager.h"
+#include "src/Web/WebServerManager.h"
+#include "src/System/BootManager.h"
+#include "src/Storage/ConfigStore.h"
+#include "src/Control/ThermostatManager.h"
+#include "src/Rules/RulesEngine.h"
+#include "src/System/TimeService.h"
+#include "src/System/HeapMonitor.h"
+#include "src/System/StringGuard.h"
 
 WiFiManager wifiManager;
-FirebaseManager firebaseManager;
+CloudTransport cloudSync;
+CloudJournal cloudJournal;
 SensorManager sensorManager;
 DeviceManager deviceManager;
 BACnetProtocol bacnetProtocol;
+TrendLogManager trendLogManager;
+BootManager bootManager;
+TimeService timeService;
+ConfigStore configStore;
+ThermostatManager thermostatManager;
+RulesEngine rulesEngine;
+HeapMonitor heapMonitor;
+WebServerManager webServer(&trendLogManager, &bootManager, &bacnetProtocol, &deviceManager, &thermostatManager,
+                           &rulesEngine, &timeService, &heapMonitor);
 
 void setup() {
   Serial.begin(115200);
   Serial.println();
   Serial.println("=== Smart Building Controller System Initialization ===");
 
-  // Initialize all starts
-  deviceManager.begin();
-  sensorManager.begin();
+  // Stage 1: outputs back to their last commanded state straight away. DeviceManager
+  // is the one persisted owner of that state; BACnet only mirrors it (see loop)
+  configStore.begin();
+  deviceManager.begin(&configStore);
+  thermostatManager.begin(&configStore);
+  bootManager.markPhase(BOOT_PHASE_OUTPUTS_RESTORED);
+
+  // SNTP runs on its own once the link is up
+  timeService.begin(&configStore);
+
+  // Stage 2: start association in the background using the cached access point
+  cloudSync.onRemoteChange(applyCloudValue);
+  wifiManager.onLinkStateChange(onNetworkLinkChange);
   wifiManager.connect();
-  firebaseManager.begin();
+
+  // Stage 3: BACnet before anything else that talks to the network
+  bacnetProtocol.setTrendLogManager(&trendLogManager);
+  bacnetProtocol.setConfigStore(&configStore);
+  bacnetProtocol.setTimeService(&timeService);
+  bacnetProtocol.setHeapMonitor(&heapMonitor);
+  bacnetProtocol.onOutputWrite(applyBACnetOutput);
+  registerClimateZone();
   bacnetProtocol.begin();
+  bootManager.markPhase(BOOT_PHASE_BACNET_STARTED);
 
-  // Initial data synchronization
-  firebaseManager.syncInitialData();
+  // Stage 4: local services; cloud setup waits for link-up (see onNetworkLinkChange)
+  sensorManager.begin(&timeService);
+  trendLogManager.begin(&timeService);
+  cloudJournal.begin();
+  cloudSync.setJournal(&cloudJournal);
+  rulesEngine.onAction(applyRuleAction);
+  rulesEngine.begin();
+  webServer.begin();
+  bootManager.markPhase(BOOT_PHASE_SERVICES_STARTED);
 
   Serial.println("=== System Initialization Complete ===");
   Serial.println("Smart Building Controller is now operational");
-  Serial.println("Device Name: SBMCon, Device ID: 1010, Vendor: Sachithra");
+  Serial.printf("Device ID: %lu, Vendor: Sachithra\n", (unsigned long)bacnetProtocol.getDeviceInstance());
   Serial.println("BACnet Protocol: Enabled and Listening on Port 47808");
-  Serial.println("Firebase Integration: Active and Synchronized");
+  Serial.println("Cloud Sync: Synchronizes once the network is up");
   Serial.println("Manual Control: Button input enabled");
+  Serial.println("Thermostat: Local AC control, HTTP /api/thermostat");
+  Serial.printf("Climate Zone: BACnet device %u on network %u\n", BACNET_CLIMATE_DEVICE_ID, BACNET_VIRTUAL_NETWORK);
+  Serial.println("Trend Logs: Temperature and Humidity, HTTP /api/trend");
+  Serial.printf("Rules: %u installed, HTTP /api/rules\n", rulesEngine.getRuleCount());
   Serial.println("======================================");
 }
 
@@ -41,10 +90,37 @@ void loop() {
   unsigned long currentTime = millis();
 
   // Handle all system tasks
+  wifiManager.handle();
+  timeService.handle();
   deviceManager.handleButton();
+  configStore.handle();
   bacnetProtocol.handle();
-  firebaseManager.syncData();
+  heapMonitor.handle();
+
+  // Local output changes are queued for the cloud even while offline
+  cloudSync.reportLocal(CLOUD_POINT_DIGITAL_LED, deviceManager.getLedState() ? 1 : 0);
+  cloudSync.reportLocal(CLOUD_POINT_BRIGHTNESS, deviceManager.getCurrentBrightness());
+  if (wifiManager.isConnected()) {
+    cloudSync.handle();
+    if (cloudSync.isInitialSyncComplete()) {
+      bootManager.markPhase(BOOT_PHASE_CLOUD_SYNCED);
+    }
+  }
   sensorManager.readAndUploadData();
+  thermostatManager.handle(sensorManager.getFilteredTemperature());
+  trendLogManager.handle(sensorManager.getTemperature(), sensorManager.getHumidity());
+  journalTelemetry(currentTime);
+  updateRuleInputs();
+  rulesEngine.handle();
+  webServer.handleClient();
+
+  // Keep BACnet present values in step with local control and sensors
+  bacnetProtocol.updateBinaryOutput(1, deviceManager.getLedState() ? FIXED_ONE : 0);
+  bacnetProtocol.updateAnalogOutput(2, fixedFromInt(deviceManager.getCurrentBrightness()));
+  bacnetProtocol.updateAnalogInput(3, sensorManager.getTemperature());
+  bacnetProtocol.updateAnalogInput(4, sensorManager.getHumidity());
+  bacnetProtocol.updateBinaryInput(5, deviceManager.isButtonPressed() ? FIXED_ONE : 0);
+  updateClimateZone();
 
   // Periodic tasks
   bacnetProtocol.broadcastPresence();
@@ -53,6 +129,110 @@ void loop() {
   delay(10);
 }
 
+void onNetworkLinkChange(bool connected) {
+  if (connected) {
+    bootManager.markPhase(BOOT_PHASE_NETWORK_UP);
+
+    // Announce immediately; cloud state is refreshed over the next loop passes
+    bacnetProtocol.announcePresence();
+    bootManager.markPhase(BOOT_PHASE_FIRST_IAM);
+    cloudSync.requestInitialSync();
+  } else {
+    Serial.println("Network Down: Running on local BACnet and button control");
+  }
+}
+
+void applyBACnetOutput(uint32_t instance, fixed_t value) {
+  if (instance == 1) {
+    deviceManager.setDigitalLed(value != 0);
+  } else if (instance == 2) {
+    deviceManager.setLEDBrightness(constrain(fixedToInt(value), 0, 255));
+  }
+}
+
+// The thermostat is also served as its own device behind the BACnet virtual network
+void registerClimateZone() {
+  BACnetRouter& router = bacnetProtocol.getRouter();
+  uint8_t zone = router.addDevice(BACNET_CLIMATE_DEVICE_ID, "SBMCon_Climate");
+  router.addObject(zone, OBJECT_ANALOG_VALUE, 1, "Zone_Setpoint", true,
+                   fixedFromFloat(THERMOSTAT_SETPOINT_MIN), fixedFromFloat(THERMOSTAT_SETPOINT_MAX));
+  router.addObject(zone, OBJECT_ANALOG_INPUT, 2, "Zone_Temperature", false);
+  router.addObject(zone, OBJECT_ANALOG_INPUT, 3, "Zone_Demand", false);
+  router.addObject(zone, OBJECT_BINARY_INPUT, 4, "AC_Relay", false);
+  router.onWrite(applyClimateZoneWrite);
+}
+
+void updateClimateZone() {
+  BACnetRouter& router = bacnetProtocol.getRouter();
+  router.setPresentValue(0, OBJECT_ANALOG_VALUE, 1, thermostatManager.getSetpoint());
+  router.setPresentValue(0, OBJECT_ANALOG_INPUT, 2, sensorManager.getFilteredTemperature());
+  router.setPresentValue(0, OBJECT_ANALOG_INPUT, 3, thermostatManager.getDemand());
+  router.setPresentValue(0, OBJECT_BINARY_INPUT, 4, thermostatManager.isRelayOn() ? FIXED_ONE : 0);
+}
+
+void applyClimateZoneWrite(uint32_t deviceInstance, uint16_t objectType, uint32_t objectInstance, fixed_t value) {
+  if (deviceInstance == BACNET_CLIMATE_DEVICE_ID && objectType == OBJECT_ANALOG_VALUE && objectInstance == 1) {
+    thermostatManager.setSetpoint(value);
+  }
+}
+
+// Readings are journaled whether or not the cloud is reachable and sent on the next sync
+void journalTelemetry(unsigned long currentTime) {
+  static unsigned long lastTelemetry = 0;
+
+  if (currentTime - lastTelemetry >= CLOUD_TELEMETRY_INTERVAL && fixedIsValid(sensorManager.getTemperature())) {
+    lastTelemetry = currentTime;
+    cloudSync.recordSensorData(fixedToFloat(sensorManager.getTemperature()), fixedToFloat(sensorManager.getHumidity()),
+                                     sensorManager.getSampleTime());
+  }
+}
+
+void applyCloudValue(CloudPoint point, float value) {
+  if (point == CLOUD_POINT_DIGITAL_LED) {
+    deviceManager.setDigitalLed(value != 0);
+  } else if (point == CLOUD_POINT_BRIGHTNESS) {
+    deviceManager.setLEDBrightness(constrain(value, 0.0f, 255.0f));
+  }
+}
+
+// Rules only re-evaluate when one of these values actually changes
+void updateRuleInputs() {
+  // The rules VM works in float; invalid readings reach it as NAN
+  rulesEngine.setInput(RULE_POINT_TEMPERATURE, toRuleValue(sensorManager.getFilteredTemperature()));
+  rulesEngine.setInput(RULE_POINT_HUMIDITY, toRuleValue(sensorManager.getHumidity()));
+  rulesEngine.setInput(RULE_POINT_BUTTON, deviceManager.isButtonPressed() ? 1 : 0);
+  rulesEngine.setInput(RULE_POINT_LED, deviceManager.getLedState() ? 1 : 0);
+  rulesEngine.setInput(RULE_POINT_BRIGHTNESS, deviceManager.getCurrentBrightness());
+  rulesEngine.setInput(RULE_POINT_MODE, thermostatManager.getMode());
+  rulesEngine.setInput(RULE_POINT_SETPOINT, fixedToFloat(thermostatManager.getSetpoint()));
+
+  // Schedules stay idle until the wall clock has been set
+  struct tm local;
+  if (timeService.getLocalTime(&local)) {
+    rulesEngine.setInput(RULE_POINT_TIME, local.tm_hour * 60 + local.tm_min);
+    rulesEngine.setInput(RULE_POINT_DAY, local.tm_wday);
+  } else {
+    rulesEngine.setInput(RULE_POINT_TIME, NAN);
+    rulesEngine.setInput(RULE_POINT_DAY, NAN);
+  }
+}
+
+float toRuleValue(fixed_t value) {
+  return fixedIsValid(value) ? fixedToFloat(value) : NAN;
+}
+
+void applyRuleAction(RulePoint point, float value) {
+  if (point == RULE_POINT_LED) {
+    deviceManager.setDigitalLed(value != 0);
+  } else if (point == RULE_POINT_BRIGHTNESS) {
+    deviceManager.setLEDBrightness(constrain(value, 0.0f, 255.0f));
+  } else if (point == RULE_POINT_MODE) {
+    thermostatManager.setMode((ThermostatMode)(uint8_t)value);
+  } else if (point == RULE_POINT_SETPOINT) {
+    thermostatManager.setSetpoint(fixedFromFloat(value));
+  }
+}
+
 void printSystemStatus(unsigned long currentTime) {
   static unsigned long lastStatusPrint = 0;
   
@@ -62,9 +242,17 @@ void printSystemStatus(unsigned long currentTime) {
     Serial.println("=== System Status Report ===");
     deviceManager.printStatus();
     sensorManager.printStatus();
+    thermostatManager.printStatus();
+    timeService.printStatus();
+    rulesEngine.printStatus();
     bacnetProtocol.printStatus();
+    trendLogManager.printStatus();
+    configStore.printStatus();
     wifiManager.printStatus();
-    firebaseManager.printStatus();
+    cloudSync.printStatus();
+    cloudJournal.printStatus();
+    bootManager.printStatus();
+    heapMonitor.printStatus();
     Serial.println("=== End Status Report ===");
   }
 }
\ No newline at end of file
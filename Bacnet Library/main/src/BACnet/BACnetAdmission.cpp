@@ -0,0 +1,102 @@
+#include <Arduino.h>
+#include "BACnetAdmission.h"
+#include "../System/StringGuard.h"
+
+typedef struct {
+    uint16_t rate;  // Requests per second
+    uint16_t burst; // Requests accepted back to back
+} BACnetRateLimit;
+
+static const BACnetRateLimit RATE_LIMITS[BACNET_CLASS_COUNT] = {
+    {BACNET_RATE_DISCOVERY, BACNET_BURST_DISCOVERY},
+    {BACNET_RATE_READ, BACNET_BURST_READ},
+    {BACNET_RATE_WRITE, BACNET_BURST_WRITE}
+};
+
+static const char* const CLASS_NAMES[BACNET_CLASS_COUNT] = {"discovery", "read", "write"};
+
+static_assert(BACNET_BURST_DISCOVERY * 1000UL <= 0xFFFF && BACNET_BURST_READ * 1000UL <= 0xFFFF &&
+              BACNET_BURST_WRITE * 1000UL <= 0xFFFF, "Token buckets hold at most 65 requests");
+
+BACnetAdmissionResult BACnetAdmission::admit(uint32_t address, BACnetServiceClass serviceClass) {
+    unsigned long now = millis();
+    BACnetSource& source = findSource(address, now);
+    source.lastSeen = now;
+    refill(source, now);
+
+    uint8_t classBit = 1 << serviceClass;
+    if (source.tokens[serviceClass] >= 1000) {
+        source.tokens[serviceClass] -= 1000;
+        source.throttledMask &= ~classBit;
+        stats.admitted++;
+        return BACNET_ADMIT;
+    }
+
+    stats.dropped[serviceClass]++;
+    if (source.throttledMask & classBit) return BACNET_DROP;
+    source.throttledMask |= classBit;
+    stats.throttleEvents++;
+    return BACNET_THROTTLE;
+}
+
+void BACnetAdmission::printStatus() {
+    Serial.printf("  Admission: %lu admitted, %u/%u sources tracked, %lu evicted\n", (unsigned long)stats.admitted,
+                  sourceCount, BACNET_RATE_SOURCES, (unsigned long)stats.evictions);
+    if (stats.throttleEvents > 0) {
+        Serial.printf("  Rate Limited: %lu discovery, %lu read, %lu write dropped over %lu episodes\n",
+                      (unsigned long)stats.dropped[BACNET_CLASS_DISCOVERY], (unsigned long)stats.dropped[BACNET_CLASS_READ],
+                      (unsigned long)stats.dropped[BACNET_CLASS_WRITE], (unsigned long)stats.throttleEvents);
+    }
+}
+
+const BACnetAdmissionStats& BACnetAdmission::getStats() {
+    return stats;
+}
+
+uint8_t BACnetAdmission::getSourceCount() {
+    return sourceCount;
+}
+
+const char* BACnetAdmission::getClassName(BACnetServiceClass serviceClass) {
+    return serviceClass < BACNET_CLASS_COUNT ? CLASS_NAMES[serviceClass] : "unknown";
+}
+
+BACnetSource& BACnetAdmission::findSource(uint32_t address, unsigned long now) {
+    uint8_t oldest = 0;
+    for (uint8_t i = 0; i < sourceCount; i++) {
+        if (sources[i].address == address) return sources[i];
+        if (now - sources[i].lastSeen > now - sources[oldest].lastSeen) oldest = i;
+    }
+
+    uint8_t slot = oldest;
+    if (sourceCount < BACNET_RATE_SOURCES) {
+        slot = sourceCount++;
+    } else {
+        stats.evictions++;
+    }
+
+    // New sources start with a full burst allowance
+    BACnetSource& source = sources[slot];
+    source.address = address;
+    source.lastRefill = now;
+    source.lastSeen = now;
+    source.throttledMask = 0;
+    for (uint8_t i = 0; i < BACNET_CLASS_COUNT; i++) {
+        source.tokens[i] = RATE_LIMITS[i].burst * 1000;
+    }
+    return source;
+}
+
+void BACnetAdmission::refill(BACnetSource& source, unsigned long now) {
+    unsigned long elapsed = now - source.lastRefill;
+    if (elapsed == 0) return;
+    source.lastRefill = now;
+
+    // Any bucket is full again after a minute, which also keeps the product below overflow
+    if (elapsed > 60000) elapsed = 60000;
+    for (uint8_t i = 0; i < BACNET_CLASS_COUNT; i++) {
+        uint32_t tokens = source.tokens[i] + elapsed * RATE_LIMITS[i].rate;
+        uint32_t capacity = RATE_LIMITS[i].burst * 1000UL;
+        source.tokens[i] = tokens > capacity ? capacity : tokens;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BACNET_ADMISSION_H
+#define BACNET_ADMISSION_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Requests are metered per source in classes of similar cost
+enum BACnetServiceClass : uint8_t {
+    BACNET_CLASS_DISCOVERY, // Unconfirmed services such as Who-Is
+    BACNET_CLASS_READ,      // ReadProperty, ReadRange and other confirmed reads
+    BACNET_CLASS_WRITE,     // WriteProperty
+    BACNET_CLASS_COUNT
+};
+
+enum BACnetAdmissionResult : uint8_t {
+    BACNET_ADMIT,
+    BACNET_DROP,     // Over the limit, discard silently
+    BACNET_THROTTLE  // First request over the limit, the sender may be told once
+};
+
+typedef struct {
+    uint32_t address;
+    unsigned long lastRefill;
+    unsigned long lastSeen;
+    uint16_t tokens[BACNET_CLASS_COUNT]; // Thousandths of a request
+    uint8_t throttledMask;               // Classes currently over their limit
+} BACnetSource;
+
+typedef struct {
+    uint32_t admitted;
+    uint32_t dropped[BACNET_CLASS_COUNT];
+    uint32_t throttleEvents;
+    uint32_t evictions;
+} BACnetAdmissionStats;
+
+// Fixed-size table of token buckets keyed by source IP. The least recently
+// seen source is evicted when a new one arrives, so memory and lookup cost
+// stay bounded however many hosts are on the wire.
+class BACnetAdmission {
+public:
+    BACnetAdmissionResult admit(uint32_t address, BACnetServiceClass serviceClass);
+    void printStatus();
+    const BACnetAdmissionStats& getStats();
+    uint8_t getSourceCount();
+
+    static const char* getClassName(BACnetServiceClass serviceClass);
+
+private:
+    BACnetSource sources[BACNET_RATE_SOURCES];
+    uint8_t sourceCount = 0;
+    BACnetAdmissionStats stats = {0};
+
+    BACnetSource& findSource(uint32_t address, unsigned long now);
+    void refill(BACnetSource& source, unsigned long now);
+};
+
+#endif
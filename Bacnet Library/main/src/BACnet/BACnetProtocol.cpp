@@ -1,18 +1,79 @@
 #include <Arduino.h>
 #include "BACnetProtocol.h"
+#include "../System/StringGuard.h"
+
+// Framing checks run on every datagram before anything is logged or
+// dispatched. In this stack byte 1 carries the PDU type in its high nibble:
+// 0x00 for unconfirmed and 0x10 for confirmed requests. The BVLC length must
+// match the datagram exactly, which also rejects datagrams cut short by the
+// receive buffer.
+static inline bool isAcceptableFrame(const uint8_t* buffer, int len) {
+    if (len < BACNET_MIN_FRAME_LENGTH || buffer[0] != 0x81) return false;
+    if (((buffer[2] << 8) | buffer[3]) != len) return false;
+    if (buffer[1] == 0x00) return true;
+    return buffer[1] == 0x10 && len >= BACNET_MIN_CONFIRMED_LENGTH;
+}
+
+// Service class used for rate limiting, from a frame that passed the checks above
+static inline BACnetServiceClass classifyFrame(const uint8_t* buffer) {
+    if (buffer[1] == 0x00) return BACNET_CLASS_DISCOVERY;
+    return buffer[6] == 0x0F ? BACNET_CLASS_WRITE : BACNET_CLASS_READ;
+}
+
+// Property values that never change are encoded by the compiler, so
+// responses only copy them. These produce the same bytes as the
+// encodeBACnet* functions below.
+template <size_t N>
+struct EncodedCharacterString {
+    uint8_t bytes[N + 1];
+    
+    constexpr EncodedCharacterString(const char (&text)[N]) : bytes{0x75, N - 1} {
+        for (size_t i = 0; i + 1 < N; i++) bytes[i + 2] = text[i];
+    }
+};
+
+struct EncodedUnsigned {
+    uint8_t bytes[5];
+    uint8_t length;
+    
+    constexpr EncodedUnsigned(uint32_t value) : bytes{}, length(value <= 255 ? 2 : value <= 65535 ? 3 : 5) {
+        bytes[0] = 0x20 | (length - 1);
+        for (uint8_t i = 1; i < length; i++) bytes[i] = (value >> (8 * (length - 1 - i))) & 0xFF;
+    }
+};
+
+static constexpr EncodedCharacterString<sizeof(BACNET_VENDOR_NAME)> VENDOR_NAME_VALUE(BACNET_VENDOR_NAME);
+static constexpr EncodedUnsigned VENDOR_ID_VALUE(VENDOR_ID);
+static constexpr EncodedUnsigned MAX_APDU_VALUE(MAX_APDU);
+static constexpr EncodedUnsigned SYSTEM_STATUS_OPERATIONAL(0);
+
+// BVLC, NPDU and APDU header of a ComplexACK, followed by the invoke ID
+static const uint8_t COMPLEX_ACK_HEADER[] = {0x81, 0x0a, 0x00, 0x00, 0x01, 0x00, 0x04};
+// BVLC, broadcast NPDU and service choice of the I-Am message
+static const uint8_t I_AM_HEADER[] = {0x81, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0xFF, 0xFF, 0x10};
+// Reply-shaped header and Unconfirmed-Request I-Am of a virtual device; the router adds its NPDU addressing
+static const uint8_t VIRTUAL_I_AM_HEADER[] = {0x81, 0x0a, 0x00, 0x00, 0x01, 0x00, 0x10, 0x00};
+
+static_assert(sizeof(I_AM_HEADER) + 4 + MAX_APDU_VALUE.length + 1 + VENDOR_ID_VALUE.length <= BACNET_I_AM_FRAME_SIZE,
+              "I-Am frame buffer too small");
 
 void BACnetProtocol::begin() {
     Serial.println("Initializing BACnet Protocol Stack");
+    loadConfiguration();
+    encodeIAm();
+    for (uint8_t i = 0; i < BACNET_OBJECT_COUNT; i++) {
+        encodeObjectName(i);
+    }
     
     if (bacnetUDP.begin(BACNET_PORT)) {
         Serial.println("BACnet UDP Service Started Successfully");
-        Serial.println("Listening Port: " + String(BACNET_PORT));
+        Serial.printf("Listening Port: %u\n", BACNET_PORT);
         Serial.println("Device Configuration:");
-        Serial.println("  Device ID: " + String(DEVICE_ID));
-        Serial.println("  Device Name: " + String(deviceObject.object_name));
-        Serial.println("  Vendor ID: " + String(VENDOR_ID));
-        Serial.println("  Vendor Name: Sachithra");
-        Serial.println("  Maximum APDU: " + String(MAX_APDU) + " bytes");
+        Serial.printf("  Device ID: %lu\n", (unsigned long)deviceObject.object_id);
+        Serial.printf("  Device Name: %s\n", deviceObject.object_name);
+        Serial.printf("  Vendor ID: %u\n", VENDOR_ID);
+        Serial.println("  Vendor Name: " BACNET_VENDOR_NAME);
+        Serial.printf("  Maximum APDU: %u bytes\n", MAX_APDU);
     } else {
         Serial.println("BACnet UDP Service Failed to Start");
         Serial.println("Critical Error: BACnet functionality will not be available");
@@ -24,12 +85,68 @@ void BACnetProtocol::handle() {
     if (packetSize) {
         uint8_t packetBuffer[512];
         int packetLength = bacnetUDP.read(packetBuffer, sizeof(packetBuffer));
+        route.active = false;
+        
+        uint32_t checkStart = ESP.getCycleCount();
+        bool routed = packetLength > 0 && BACnetRouter::isNetworkFrame(packetBuffer, packetLength);
+        if (!routed && !isAcceptableFrame(packetBuffer, packetLength)) {
+            rejectedFrames++;
+            rejectCycles += ESP.getCycleCount() - checkStart;
+            return;
+        }
+        
         IPAddress remoteAddress = bacnetUDP.remoteIP();
         uint16_t remotePort = bacnetUDP.remotePort();
         
+        // Frames with an NPDU only concern the virtual network. Their hash is
+        // taken as received, so the same request to two devices is never
+        // answered from the other's cached reply.
+        uint32_t requestHash = 0;
+        if (routed) {
+            requestHash = BACnetReplyCache::hashRequest(packetBuffer, packetLength);
+            uint8_t routerReply[16];
+            size_t routerReplyLength;
+            packetLength = router.accept(packetBuffer, packetLength, &route, routerReply, &routerReplyLength);
+            if (routerReplyLength > 0 &&
+                admission.admit((uint32_t)remoteAddress, BACNET_CLASS_DISCOVERY) == BACNET_ADMIT) {
+                sendBroadcast(routerReply, routerReplyLength);
+            }
+            if (packetLength == 0) return;
+            if (!isAcceptableFrame(packetBuffer, packetLength)) {
+                rejectedFrames++;
+                return;
+            }
+        }
+        
+        // Only one datagram is taken per loop pass, so dropping over-limit
+        // requests here bounds the time BACnet can take from the rest of the loop
+        BACnetAdmissionResult admitted = admission.admit((uint32_t)remoteAddress, classifyFrame(packetBuffer));
+        if (admitted != BACNET_ADMIT) {
+            // Confirmed requests get a single Abort per episode so a well-behaved
+            // client backs off instead of retrying; everything else is dropped silently
+            if (admitted == BACNET_THROTTLE && packetBuffer[1] == 0x10) {
+                sendAbort(remoteAddress, remotePort, packetBuffer[5], ABORT_REASON_OUT_OF_RESOURCES);
+            }
+            return;
+        }
+        
+        // A retried write gets the reply already sent, so it is applied only
+        // once; reads are answered again, so they never evict a write reply
+        if (packetBuffer[1] == 0x10 && BACnetReplyCache::isCached(packetBuffer[6])) {
+            if (!routed) requestHash = BACnetReplyCache::hashRequest(packetBuffer, packetLength);
+            BACnetCachedReply* cached = replyCache.find(remoteAddress, remotePort, packetBuffer[5], packetBuffer[6], requestHash);
+            if (cached != nullptr) {
+                bacnetUDP.beginPacket(remoteAddress, remotePort);
+                bacnetUDP.write(cached->frame, cached->length);
+                bacnetUDP.endPacket();
+                return;
+            }
+            pendingReply = replyCache.reserve(remoteAddress, remotePort, packetBuffer[5], packetBuffer[6], requestHash);
+        }
+        
         Serial.println("BACnet Packet Received");
-        Serial.println("  Source: " + remoteAddress.toString() + ":" + String(remotePort));
-        Serial.println("  Packet Size: " + String(packetLength) + " bytes");
+        Serial.printf("  Source: " IP_FORMAT ":%u\n", IP_ARGS(remoteAddress), remotePort);
+        Serial.printf("  Packet Size: %d bytes\n", packetLength);
         
         Serial.print("  Packet Data (Hex): ");
         for(int i = 0; i < (packetLength < 16 ? packetLength : 16); i++) {
@@ -38,6 +155,7 @@ void BACnetProtocol::handle() {
         Serial.println();
         
         processBACnetPacket(packetBuffer, packetLength, remoteAddress, remotePort);
+        pendingReply = nullptr;
     }
 }
 
@@ -50,12 +168,54 @@ void BACnetProtocol::broadcastPresence() {
     }
 }
 
+void BACnetProtocol::announcePresence() {
+    lastBACnetDiscovery = millis();
+    sendIAm();
+    
+    // Routers announce their networks on startup so clients learn the path to the virtual devices
+    if (router.getDeviceCount() > 0) {
+        uint8_t frame[16];
+        sendBroadcast(frame, router.encodeIAmRouter(frame));
+    }
+}
+
 void BACnetProtocol::printStatus() {
     Serial.println("BACnet Protocol Status:");
-    Serial.println("  Service: Running on Port " + String(BACNET_PORT));
-    Serial.println("  Device ID: " + String(DEVICE_ID));
-    Serial.println("  Device Name: " + String(deviceObject.object_name));
-    Serial.println("  Objects Available: 6 (Device, 2 Outputs, 2 Inputs, 1 Binary Input)");
+    Serial.printf("  Service: Running on Port %u\n", BACNET_PORT);
+    Serial.printf("  Device ID: %lu\n", (unsigned long)deviceObject.object_id);
+    Serial.printf("  Device Name: %s\n", deviceObject.object_name);
+    Serial.println("  Objects Available: 8 (Device, 2 Outputs, 2 Inputs, 1 Binary Input, 2 Trend Logs)");
+    if (readPropertyResponses > 0) {
+        Serial.printf("  ReadProperty Responses: %lu, %lu CPU cycles each to assemble\n", (unsigned long)readPropertyResponses,
+                      (unsigned long)(readPropertyCycles / readPropertyResponses));
+    }
+    if (rejectedFrames > 0) {
+        Serial.printf("  Malformed Frames Dropped: %lu, %lu CPU cycles each\n", (unsigned long)rejectedFrames,
+                      (unsigned long)(rejectCycles / rejectedFrames));
+    }
+    admission.printStatus();
+    replyCache.printStatus();
+    router.printStatus();
+}
+
+uint32_t BACnetProtocol::getRejectedFrames() {
+    return rejectedFrames;
+}
+
+BACnetAdmission& BACnetProtocol::getAdmission() {
+    return admission;
+}
+
+uint32_t BACnetProtocol::getRetriesAnswered() {
+    return replyCache.getHits();
+}
+
+uint32_t BACnetProtocol::getReadPropertyCycles() {
+    return readPropertyResponses > 0 ? readPropertyCycles / readPropertyResponses : 0;
+}
+
+BACnetRouter& BACnetProtocol::getRouter() {
+    return router;
 }
 
 void BACnetProtocol::processBACnetPacket(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort) {
@@ -71,7 +231,7 @@ void BACnetProtocol::processBACnetPacket(uint8_t* buffer, size_t len, IPAddress
     }
     
     uint8_t pduType = (buffer[1] >> 4) & 0x0F;
-    Serial.println("BACnet PDU Type Identified: " + String(pduType));
+    Serial.printf("BACnet PDU Type Identified: %u\n", pduType);
     
     //Hhandler based on PDU type
     switch (pduType) {
@@ -84,7 +244,7 @@ void BACnetProtocol::processBACnetPacket(uint8_t* buffer, size_t len, IPAddress
             handleConfirmedRequest(buffer, len, remoteIP, remotePort);
             break;
         default:
-            Serial.println("BACnet Warning: Unsupported PDU type received: " + String(pduType));
+            Serial.printf("BACnet Warning: Unsupported PDU type received: %u\n", pduType);
             break;
     }
 }
@@ -96,19 +256,32 @@ void BACnetProtocol::handleUnconfirmedRequest(uint8_t* buffer, size_t len, IPAdd
     }
     
     uint8_t serviceChoice = buffer[4];
-    Serial.println("Unconfirmed Service Request: " + String(serviceChoice));
+    Serial.printf("Unconfirmed Service Request: %u\n", serviceChoice);
     
     switch (serviceChoice) {
         case 0x08: // Who-Is service
             Serial.println("BACnet Who-Is Request Received");
+            if (route.active) {
+                // Routed Who-Is: the addressed virtual devices answer for themselves
+                for (uint8_t i = 0; i < router.getDeviceCount(); i++) {
+                    if (route.device == BACNET_ROUTE_ALL || route.device == i) sendVirtualIAm(i);
+                }
+                break;
+            }
             Serial.println("Responding with I-Am broadcast");
             sendIAm();
             break;
         case 0x00: // I-Am service
             Serial.println("BACnet I-Am Received from another device (ignored)");
             break;
+        case 0x06: // TimeSynchronization, local time
+            handleTimeSynchronization(buffer, len, false);
+            break;
+        case 0x09: // UTCTimeSynchronization
+            handleTimeSynchronization(buffer, len, true);
+            break;
         default:
-            Serial.println("BACnet Warning: Unsupported unconfirmed service: " + String(serviceChoice));
+            Serial.printf("BACnet Warning: Unsupported unconfirmed service: %u\n", serviceChoice);
             break;
     }
 }
@@ -123,8 +296,8 @@ void BACnetProtocol::handleConfirmedRequest(uint8_t* buffer, size_t len, IPAddre
     uint8_t serviceChoice = buffer[6];
     
     Serial.println("Confirmed Service Request Details:");
-    Serial.println("  Invocation ID: " + String(invokeId));
-    Serial.println("  Service Type: " + String(serviceChoice));
+    Serial.printf("  Invocation ID: %u\n", invokeId);
+    Serial.printf("  Service Type: %u\n", serviceChoice);
     
     switch (serviceChoice) {
         case 0x0C: // ReadProperty
@@ -135,6 +308,10 @@ void BACnetProtocol::handleConfirmedRequest(uint8_t* buffer, size_t len, IPAddre
             Serial.println("Processing WriteProperty Request");
             handleWriteProperty(buffer, len, remoteIP, remotePort, invokeId);
             break;
+        case 0x1A: // ReadRange
+            Serial.println("Processing ReadRange Request");
+            handleReadRange(buffer, len, remoteIP, remotePort, invokeId);
+            break;
         default:
             Serial.println("BACnet Error: Unsupported confirmed service");
             sendError(remoteIP, remotePort, invokeId, 0, 0); // Service not supported
@@ -142,6 +319,21 @@ void BACnetProtocol::handleConfirmedRequest(uint8_t* buffer, size_t len, IPAddre
     }
 }
 
+void BACnetProtocol::handleTimeSynchronization(uint8_t* buffer, size_t len, bool utc) {
+    uint32_t timestamp = 0;
+    if (timeService == nullptr || decodeBACnetDateTime(&buffer[5], len - 5, &timestamp) == 0) {
+        Serial.println("BACnet Error: Malformed TimeSynchronization request");
+        return;
+    }
+    
+    if (!utc) {
+        timestamp = timeService->localToEpoch(timestamp);
+    }
+    uint8_t hundredths = buffer[14] < 100 ? buffer[14] : 0;
+    timeService->synchronize((uint64_t)timestamp * 1000000 + hundredths * 10000, TIME_SOURCE_BACNET);
+    Serial.printf("BACnet %s Time Synchronization Applied: %lu\n", utc ? "UTC" : "Local", (unsigned long)timestamp);
+}
+
 void BACnetProtocol::handleReadProperty(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId) {
     if (len < 10) {
         Serial.println("BACnet Error: ReadProperty request packet too short");
@@ -164,87 +356,404 @@ void BACnetProtocol::handleReadProperty(uint8_t* buffer, size_t len, IPAddress r
     uint32_t requestedPropertyId = decodeBACnetUnsigned(&buffer[propertyTagPosition], len - propertyTagPosition);
     
     Serial.println("ReadProperty Request Details:");
-    Serial.println("  Object Type: " + String(requestedObjectType));
-    Serial.println("  Object Instance: " + String(requestedObjectInstance));
-    Serial.println("  Property ID: " + String(requestedPropertyId));
+    Serial.printf("  Object Type: %u\n", requestedObjectType);
+    Serial.printf("  Object Instance: %lu\n", (unsigned long)requestedObjectInstance);
+    Serial.printf("  Property ID: %lu\n", (unsigned long)requestedPropertyId);
     
+    if (route.active) {
+        sendVirtualReadPropertyACK(remoteIP, remotePort, invokeId, requestedObjectType, requestedObjectInstance, requestedPropertyId);
+        return;
+    }
     sendReadPropertyACK(remoteIP, remotePort, invokeId, requestedObjectType, requestedObjectInstance, requestedPropertyId);
 }
 
 void BACnetProtocol::handleWriteProperty(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId) {
-    Serial.println("WriteProperty Request Received - Feature Not Fully Implemented");
-    Serial.println("Sending Error Response: Service Not Implemented");
-    sendError(remoteIP, remotePort, invokeId, 0, 0);
+    if (len < 15) {
+        Serial.println("BACnet Error: WriteProperty request packet too short");
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_SERVICES, ERROR_CODE_INVALID_TAG);
+        return;
+    }
+    
+    uint16_t requestedObjectType;
+    uint32_t requestedObjectInstance = decodeBACnetObjectId(&buffer[7], &requestedObjectType);
+    uint32_t requestedPropertyId = decodeBACnetUnsigned(&buffer[11], len - 11);
+    size_t position = 11 + 1 + (buffer[11] & 0x07);
+    
+    // Optional [2] array index is not used by any writable property here
+    if (position < len && (buffer[position] & 0xF8) == 0x28) {
+        position += 1 + (buffer[position] & 0x07);
+    }
+    
+    // [3] property value, then optional [4] priority
+    BACnetValue value;
+    uint8_t consumed = 0;
+    if (position < len && buffer[position] == 0x3E) {
+        position++;
+        consumed = decodeBACnetValue(&buffer[position], len - position, &value);
+        position += consumed;
+    }
+    if (consumed == 0 || position >= len || buffer[position] != 0x3F) {
+        Serial.println("BACnet Error: Malformed WriteProperty value");
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_SERVICES, ERROR_CODE_INVALID_TAG);
+        return;
+    }
+    position++;
+    
+    uint8_t priority = BACNET_PRIORITY_LEVELS;
+    if (position + 1 < len && buffer[position] == 0x49) {
+        priority = buffer[position + 1];
+    }
+    if (priority < 1 || priority > BACNET_PRIORITY_LEVELS) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_VALUE_OUT_OF_RANGE);
+        return;
+    }
+    
+    Serial.println("WriteProperty Request Details:");
+    Serial.printf("  Object Type: %u\n", requestedObjectType);
+    Serial.printf("  Object Instance: %lu\n", (unsigned long)requestedObjectInstance);
+    Serial.printf("  Property ID: %lu\n", (unsigned long)requestedPropertyId);
+    Serial.printf("  Priority: %u\n", priority);
+    
+    if (route.active) {
+        writeVirtualProperty(remoteIP, remotePort, invokeId, requestedObjectType, requestedObjectInstance, requestedPropertyId, value);
+        return;
+    }
+    
+    BACnetObject* object = findObject(requestedObjectType, requestedObjectInstance);
+    if (object == nullptr) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
+        return;
+    }
+    
+    bool isNumeric = value.tag == 1 || value.tag == 2 || value.tag == 4 || value.tag == 9;
+    BACnetPriorityArray* priorityArray = findPriorityArray(object);
+    
+    switch (requestedPropertyId) {
+        case PROP_PRESENT_VALUE:
+            if (priorityArray == nullptr) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_WRITE_ACCESS_DENIED);
+                return;
+            }
+            if (!isNumeric && value.tag != 0) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_DATA_TYPE);
+                return;
+            }
+            if (value.tag != 0 && !isOutputValueInRange(object, value.number)) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_VALUE_OUT_OF_RANGE);
+                return;
+            }
+            writeCommandableValue(object, priorityArray, value, priority);
+            break;
+            
+        case PROP_OBJECT_NAME:
+            if (value.tag != 7 || value.text[0] == '\0') {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_DATA_TYPE);
+                return;
+            }
+            setObjectName(requestedObjectType, requestedObjectInstance, value.text);
+            break;
+            
+        case PROP_COV_INCREMENT:
+            if (requestedObjectType != OBJECT_ANALOG_INPUT && requestedObjectType != OBJECT_ANALOG_OUTPUT) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            if (!isNumeric || value.number < 0) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_VALUE_OUT_OF_RANGE);
+                return;
+            }
+            setCOVIncrement(requestedObjectType, requestedObjectInstance, fixedFromFloat(value.number));
+            break;
+            
+        case PROP_OBJECT_IDENTIFIER: {
+            // Renumbering the device; the identifier is in this stack's 16-bit type, 16-bit instance layout
+            uint8_t identifier[4] = {(uint8_t)(value.unsignedValue >> 24), (uint8_t)(value.unsignedValue >> 16),
+                                     (uint8_t)(value.unsignedValue >> 8), (uint8_t)value.unsignedValue};
+            uint16_t identifierType = 0;
+            uint32_t instance = value.tag == 12 ? decodeBACnetObjectId(identifier, &identifierType) : 0;
+            if (requestedObjectType != OBJECT_DEVICE || identifierType != OBJECT_DEVICE) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_WRITE_ACCESS_DENIED);
+                return;
+            }
+            if (!setDeviceInstance(instance)) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_VALUE_OUT_OF_RANGE);
+                return;
+            }
+            break;
+        }
+            
+        default:
+            Serial.println("BACnet Error: Property is not writable");
+            sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_WRITE_ACCESS_DENIED);
+            return;
+    }
+    
+    sendSimpleACK(remoteIP, remotePort, invokeId, 0x0F);
 }
 
-void BACnetProtocol::sendIAm() {
-    Serial.println("Preparing BACnet I-Am Broadcast Message");
+void BACnetProtocol::handleReadRange(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId) {
+    if (len < 13) {
+        Serial.println("BACnet Error: ReadRange request packet too short");
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_SERVICES, ERROR_CODE_INVALID_TAG);
+        return;
+    }
+    
+    uint16_t requestedObjectType;
+    uint32_t requestedObjectInstance = decodeBACnetObjectId(&buffer[7], &requestedObjectType);
+    uint32_t requestedPropertyId = decodeBACnetUnsigned(&buffer[11], len - 11);
+    
+    // Virtual devices have no Trend Logs
+    if (route.active || requestedObjectType != OBJECT_TRENDLOG || trendLogManager == nullptr ||
+        !trendLogManager->hasLog(requestedObjectInstance)) {
+        Serial.println("BACnet Error: ReadRange target is not a Trend Log");
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
+        return;
+    }
+    if (requestedPropertyId != PROP_LOG_BUFFER) {
+        Serial.println("BACnet Error: ReadRange only supports Log_Buffer");
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+        return;
+    }
+    
+    // Resolve the optional range into [firstIndex, firstIndex + itemCount)
+    uint32_t totalRecords = trendLogManager->getRecordCount(requestedObjectInstance);
+    uint32_t firstSequence = trendLogManager->getFirstSequence(requestedObjectInstance);
+    uint32_t firstIndex = 0;
+    uint32_t itemCount = totalRecords;
+    bool reportSequence = false;
+    
+    size_t position = 11 + 1 + (buffer[11] & 0x07);
+    if (position < len) {
+        uint8_t rangeTag = buffer[position++];
+        uint32_t reference = 0;
+        uint32_t rawCount = 0;
+        uint8_t consumed = 0;
+        
+        if (rangeTag == 0x3E || rangeTag == 0x6E) { // byPosition / bySequenceNumber
+            consumed = decodeBACnetApplicationValue(&buffer[position], len - position, 2, &reference);
+        } else if (rangeTag == 0x7E) { // byTime
+            consumed = decodeBACnetDateTime(&buffer[position], len - position, &reference);
+        }
+        if (consumed > 0) {
+            position += consumed;
+            consumed = decodeBACnetApplicationValue(&buffer[position], len - position, 3, &rawCount);
+        }
+        if (consumed == 0) {
+            Serial.println("BACnet Error: Malformed ReadRange range parameter");
+            sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_SERVICES, ERROR_CODE_INVALID_TAG);
+            return;
+        }
+        
+        // Sign-extend the count from its encoded width
+        uint8_t countBytes = consumed - 1;
+        int32_t count = (int32_t)(rawCount << (32 - 8 * countBytes)) >> (32 - 8 * countBytes);
+        uint32_t span = count < 0 ? (uint32_t)(-count) : (uint32_t)count;
+        
+        if (rangeTag == 0x7E) {
+            reportSequence = true;
+            if (count > 0) {
+                firstIndex = trendLogManager->findIndexByTime(requestedObjectInstance, reference + 1);
+                itemCount = min(span, totalRecords - firstIndex);
+            } else {
+                uint32_t endIndex = trendLogManager->findIndexByTime(requestedObjectInstance, reference);
+                firstIndex = endIndex > span ? endIndex - span : 0;
+                itemCount = endIndex - firstIndex;
+            }
+        } else {
+            // Reference index is 1-based for byPosition, a sequence number otherwise
+            int64_t reference0 = rangeTag == 0x3E ? (int64_t)reference - 1 : (int64_t)reference - firstSequence;
+            reportSequence = rangeTag == 0x6E;
+            if (reference0 < 0 || reference0 >= (int64_t)totalRecords) {
+                itemCount = 0;
+            } else if (count > 0) {
+                firstIndex = reference0;
+                itemCount = min(span, totalRecords - firstIndex);
+            } else {
+                firstIndex = (uint32_t)reference0 + 1 > span ? (uint32_t)reference0 + 1 - span : 0;
+                itemCount = (uint32_t)reference0 + 1 - firstIndex;
+            }
+        }
+    }
+    
+    Serial.println("ReadRange Request Details:");
+    Serial.printf("  Trend Log: %lu\n", (unsigned long)requestedObjectInstance);
+    Serial.printf("  First Index: %lu, Requested Items: %lu\n", (unsigned long)firstIndex, (unsigned long)itemCount);
     
-    uint8_t broadcastBuffer[50];
+    uint8_t responseBuffer[512];
     int bufferPosition = 0;
     
-    // BACnet/IP BVLC Header
-    broadcastBuffer[bufferPosition++] = 0x81; 
-    broadcastBuffer[bufferPosition++] = 0x00; 
-    broadcastBuffer[bufferPosition++] = 0x00; 
-    broadcastBuffer[bufferPosition++] = 0x16; 
+    // BVLC Header
+    responseBuffer[bufferPosition++] = 0x81;
+    responseBuffer[bufferPosition++] = 0x0a;
+    responseBuffer[bufferPosition++] = 0x00;
+    responseBuffer[bufferPosition++] = 0x00;
+    
+    // NPDU
+    responseBuffer[bufferPosition++] = 0x01;
+    responseBuffer[bufferPosition++] = 0x00;
+    
+    // APDU
+    responseBuffer[bufferPosition++] = 0x04;
+    responseBuffer[bufferPosition++] = invokeId;
+    responseBuffer[bufferPosition++] = 0x1a;
+    
+    // [0] Object identifier, [1] property identifier
+    responseBuffer[bufferPosition++] = 0x0c;
+    encodeBACnetObjectId(&responseBuffer[bufferPosition], OBJECT_TRENDLOG, requestedObjectInstance);
+    bufferPosition += 4;
+    responseBuffer[bufferPosition++] = 0x19;
+    responseBuffer[bufferPosition++] = PROP_LOG_BUFFER;
+    
+    // Fit as many records as the datagram allows; each record is 19 bytes
+    const int recordSize = 19;
+    const int trailerSize = 1 + 5 + 6 + 6;
+    uint32_t fitCount = (sizeof(responseBuffer) - bufferPosition - trailerSize) / recordSize;
+    uint32_t returnedCount = min(itemCount, fitCount);
+    
+    // [3] Result flags: FIRST_ITEM, LAST_ITEM, MORE_ITEMS
+    uint8_t resultFlags = 0;
+    if (returnedCount > 0 && firstIndex == 0) resultFlags |= 0x80;
+    if (returnedCount > 0 && firstIndex + returnedCount == totalRecords) resultFlags |= 0x40;
+    if (returnedCount < itemCount) resultFlags |= 0x20;
+    responseBuffer[bufferPosition++] = 0x3a;
+    responseBuffer[bufferPosition++] = 0x05;
+    responseBuffer[bufferPosition++] = resultFlags;
     
-    // NPDU (Network Protocol Data Unit)
-    broadcastBuffer[bufferPosition++] = 0x01; 
-    broadcastBuffer[bufferPosition++] = 0x00;
-    broadcastBuffer[bufferPosition++] = 0x00; 
-    broadcastBuffer[bufferPosition++] = 0xFF; 
-    broadcastBuffer[bufferPosition++] = 0xFF;
+    // [4] Item count
+    bufferPosition += encodeBACnetContextUnsigned(&responseBuffer[bufferPosition], 4, returnedCount);
     
-    // APDU (Application Protocol Data Unit)
-    broadcastBuffer[bufferPosition++] = 0x10; // I-Am service send Message
+    // [5] Item data
+    responseBuffer[bufferPosition++] = 0x5e;
+    TrendRecord records[8];
+    uint32_t emitted = 0;
+    while (emitted < returnedCount) {
+        uint16_t batch = trendLogManager->readRecords(requestedObjectInstance, firstIndex + emitted, records,
+                                                     min(returnedCount - emitted, (uint32_t)8));
+        if (batch == 0) break;
+        for (uint16_t i = 0; i < batch; i++) {
+            responseBuffer[bufferPosition++] = 0x0e;
+            bufferPosition += encodeBACnetDateTime(&responseBuffer[bufferPosition], records[i].timestamp);
+            responseBuffer[bufferPosition++] = 0x0f;
+            responseBuffer[bufferPosition++] = 0x1e;
+            encodeBACnetReal(&responseBuffer[bufferPosition], records[i].value);
+            responseBuffer[bufferPosition] = 0x2c; // Context tag 2, real-value choice
+            bufferPosition += 5;
+            responseBuffer[bufferPosition++] = 0x1f;
+        }
+        emitted += batch;
+    }
+    if (emitted < returnedCount) {
+        // The item count is already encoded; a log that cannot be read gets an error instead
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_DEVICE, ERROR_CODE_OPERATIONAL_PROBLEM);
+        return;
+    }
+    responseBuffer[bufferPosition++] = 0x5f;
+    
+    // [6] First sequence number for by-sequence and by-time requests
+    if (reportSequence && emitted > 0) {
+        bufferPosition += encodeBACnetContextUnsigned(&responseBuffer[bufferPosition], 6, firstSequence + firstIndex);
+    }
+    
+    responseBuffer[2] = (bufferPosition >> 8) & 0xFF;
+    responseBuffer[3] = bufferPosition & 0xFF;
+    
+    sendResponse(remoteIP, remotePort, responseBuffer, bufferPosition);
+    
+    Serial.printf("ReadRange Acknowledgement Sent: %u records, %u bytes\n", (unsigned)emitted, (unsigned)bufferPosition);
+}
+
+void BACnetProtocol::sendIAm() {
+    sendBroadcast(iAmFrame, iAmLength);
+    
+    Serial.println("BACnet I-Am Broadcast Sent Successfully");
+    Serial.printf("  Device: %s\n", deviceObject.object_name);
+    Serial.printf("  Device ID: %lu\n", (unsigned long)deviceObject.object_id);
+    Serial.println("  Vendor: " BACNET_VENDOR_NAME);
+    Serial.printf("  Maximum APDU: %u\n", MAX_APDU);
+}
+
+void BACnetProtocol::sendVirtualIAm(uint8_t device) {
+    BACnetVirtualDevice* virtualDevice = router.getDevice(device);
+    uint8_t frame[BACNET_I_AM_FRAME_SIZE];
+    memcpy(frame, VIRTUAL_I_AM_HEADER, sizeof(VIRTUAL_I_AM_HEADER));
+    uint8_t length = sizeof(VIRTUAL_I_AM_HEADER) + encodeIAmBody(&frame[sizeof(VIRTUAL_I_AM_HEADER)], virtualDevice->instance);
+    
+    uint8_t routedFrame[BACNET_I_AM_FRAME_SIZE + BACNET_ROUTE_HEADER_MAX];
+    sendBroadcast(routedFrame, router.wrap(frame, length, route, device, true, routedFrame, sizeof(routedFrame)));
+    Serial.printf("BACnet I-Am Sent for Virtual Device %lu (%s)\n", (unsigned long)virtualDevice->instance, virtualDevice->name);
+}
+
+void BACnetProtocol::sendBroadcast(const uint8_t* frame, size_t length) {
+    if (length == 0) return;
+    IPAddress broadcastAddress(255, 255, 255, 255);
+    bacnetUDP.beginPacket(broadcastAddress, BACNET_PORT);
+    bacnetUDP.write(frame, length);
+    bacnetUDP.endPacket();
+}
+
+void BACnetProtocol::encodeIAm() {
+    memcpy(iAmFrame, I_AM_HEADER, sizeof(I_AM_HEADER));
+    iAmLength = sizeof(I_AM_HEADER) + encodeIAmBody(&iAmFrame[sizeof(I_AM_HEADER)], deviceObject.object_id);
+    iAmFrame[3] = iAmLength;
+}
+
+// Device identifier, maximum APDU, segmentation and vendor of an I-Am
+uint8_t BACnetProtocol::encodeIAmBody(uint8_t* buffer, uint32_t instance) {
+    uint8_t bufferPosition = 0;
     
     // device object identifier
-    encodeBACnetObjectId(&broadcastBuffer[bufferPosition], OBJECT_DEVICE, DEVICE_ID);
+    encodeBACnetObjectId(&buffer[bufferPosition], OBJECT_DEVICE, instance);
     bufferPosition += 4;
     
     // maximum APDU size
-    encodeBACnetUnsigned(&broadcastBuffer[bufferPosition], MAX_APDU);
-    bufferPosition += 3;
+    memcpy(&buffer[bufferPosition], MAX_APDU_VALUE.bytes, MAX_APDU_VALUE.length);
+    bufferPosition += MAX_APDU_VALUE.length;
     
-    broadcastBuffer[bufferPosition++] = 0x00; 
+    buffer[bufferPosition++] = 0x00; 
     
     // Vendor identifier
-    encodeBACnetUnsigned(&broadcastBuffer[bufferPosition], VENDOR_ID);
-    bufferPosition += 2;
+    memcpy(&buffer[bufferPosition], VENDOR_ID_VALUE.bytes, VENDOR_ID_VALUE.length);
+    bufferPosition += VENDOR_ID_VALUE.length;
     
-    // Send broadcast to entire network
-    IPAddress broadcastAddress(255, 255, 255, 255);
-    bacnetUDP.beginPacket(broadcastAddress, BACNET_PORT);
-    bacnetUDP.write(broadcastBuffer, bufferPosition);
+    return bufferPosition;
+}
+
+void BACnetProtocol::encodeObjectName(uint8_t index) {
+    encodeBACnetCharacterString(encodedNames[index], objects[index]->object_name);
+}
+
+void BACnetProtocol::sendResponse(IPAddress remoteIP, uint16_t remotePort, const uint8_t* frame, size_t length) {
+    // Replies from a virtual device carry its network address
+    uint8_t routedFrame[128 + BACNET_ROUTE_HEADER_MAX];
+    if (route.active) {
+        length = router.wrap(frame, length, route, route.device, false, routedFrame, sizeof(routedFrame));
+        if (length == 0) return;
+        frame = routedFrame;
+    }
+    
+    bacnetUDP.beginPacket(remoteIP, remotePort);
+    bacnetUDP.write(frame, length);
     bacnetUDP.endPacket();
     
-    Serial.println("BACnet I-Am Broadcast Sent Successfully");
-    Serial.println("  Device: " + String(deviceObject.object_name));
-    Serial.println("  Device ID: " + String(DEVICE_ID));
-    Serial.println("  Vendor: Sachithra");
-    Serial.println("  Maximum APDU: " + String(MAX_APDU));
+    if (pendingReply != nullptr) {
+        replyCache.store(pendingReply, frame, length);
+        pendingReply = nullptr;
+    }
 }
 
 void BACnetProtocol::sendReadPropertyACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, 
                         uint16_t objectType, uint32_t objectInstance, uint32_t propertyId) {
     Serial.println("Preparing ReadProperty Acknowledgement Response");
+    Serial.printf("Processing Property Request: %lu\n", (unsigned long)propertyId);
     
-    uint8_t responseBuffer[128];
-    int bufferPosition = 0;
-    
-    // BVLC Header
-    responseBuffer[bufferPosition++] = 0x81; 
-    responseBuffer[bufferPosition++] = 0x0a;
-    responseBuffer[bufferPosition++] = 0x00;
-    responseBuffer[bufferPosition++] = 0x00;
+    // Timed up to the send, with tracing kept out so the count is the assembly alone
+    uint32_t assemblyStart = ESP.getCycleCount();
     
-    // NPDU
-    responseBuffer[bufferPosition++] = 0x01; 
-    responseBuffer[bufferPosition++] = 0x00; 
+    uint8_t responseBuffer[128];
+    int bufferPosition = sizeof(COMPLEX_ACK_HEADER);
     
-    // APDU
-    responseBuffer[bufferPosition++] = 0x04;
+    // BVLC, NPDU and APDU header
+    memcpy(responseBuffer, COMPLEX_ACK_HEADER, sizeof(COMPLEX_ACK_HEADER));
     responseBuffer[bufferPosition++] = invokeId;
     responseBuffer[bufferPosition++] = 0x0c;
     
@@ -259,91 +768,170 @@ void BACnetProtocol::sendReadPropertyACK(IPAddress remoteIP, uint16_t remotePort
     // Requested property value
     bool propertyAvailable = true;
     
-    Serial.println("Processing Property Request: " + String(propertyId));
-    
     switch (propertyId) {
         case PROP_OBJECT_IDENTIFIER:
-            Serial.println("Property: Object Identifier");
             encodeBACnetObjectId(&responseBuffer[bufferPosition], objectType, objectInstance);
             bufferPosition += 4;
             break;
             
-        case PROP_OBJECT_NAME:
-            Serial.println("Property: Object Name");
-            if (objectType == OBJECT_DEVICE && objectInstance == DEVICE_ID) {
-                encodeBACnetCharacterString(&responseBuffer[bufferPosition], deviceObject.object_name);
-                bufferPosition += strlen(deviceObject.object_name) + 2;
-                Serial.println("  Value: " + String(deviceObject.object_name));
-            } else if (objectType == OBJECT_BINARY_OUTPUT && objectInstance == 1) {
-                encodeBACnetCharacterString(&responseBuffer[bufferPosition], binaryOutput1.object_name);
-                bufferPosition += strlen(binaryOutput1.object_name) + 2;
-                Serial.println("  Value: " + String(binaryOutput1.object_name));
-            } else if (objectType == OBJECT_ANALOG_OUTPUT && objectInstance == 2) {
-                encodeBACnetCharacterString(&responseBuffer[bufferPosition], analogOutput1.object_name);
-                bufferPosition += strlen(analogOutput1.object_name) + 2;
-                Serial.println("  Value: " + String(analogOutput1.object_name));
-            } else if (objectType == OBJECT_ANALOG_INPUT && objectInstance == 3) {
-                encodeBACnetCharacterString(&responseBuffer[bufferPosition], analogInput1.object_name);
-                bufferPosition += strlen(analogInput1.object_name) + 2;
-                Serial.println("  Value: " + String(analogInput1.object_name));
-            } else if (objectType == OBJECT_ANALOG_INPUT && objectInstance == 4) {
-                encodeBACnetCharacterString(&responseBuffer[bufferPosition], analogInput2.object_name);
-                bufferPosition += strlen(analogInput2.object_name) + 2;
-                Serial.println("  Value: " + String(analogInput2.object_name));
+        case PROP_OBJECT_NAME: {
+            uint8_t index = findObjectIndex(objectType, objectInstance);
+            if (index < BACNET_OBJECT_COUNT) {
+                uint8_t nameLength = encodedNames[index][1] + 2;
+                memcpy(&responseBuffer[bufferPosition], encodedNames[index], nameLength);
+                bufferPosition += nameLength;
+            } else if (objectType == OBJECT_TRENDLOG && trendLogManager != nullptr && trendLogManager->hasLog(objectInstance)) {
+                const char* logName = trendLogManager->getObjectName(objectInstance);
+                encodeBACnetCharacterString(&responseBuffer[bufferPosition], logName);
+                bufferPosition += strlen(logName) + 2;
             }
             break;
+        }
             
         case PROP_OBJECT_TYPE:
-            Serial.println("Property: Object Type");
             encodeBACnetUnsigned(&responseBuffer[bufferPosition], objectType);
             bufferPosition += (objectType <= 255) ? 2 : 3;
-            Serial.println("  Value: " + String(objectType));
             break;
             
         case PROP_PRESENT_VALUE:
-            Serial.println("Property: Present Value");
             if (objectType == OBJECT_BINARY_OUTPUT && objectInstance == 1) {
-                encodeBACnetReal(&responseBuffer[bufferPosition], binaryOutput1.present_value);
-                bufferPosition += 4;
-                Serial.println("  Value: " + String(binaryOutput1.present_value));
+                encodeBACnetFixed(&responseBuffer[bufferPosition], binaryOutput1.present_value);
+                bufferPosition += 5;
             } else if (objectType == OBJECT_ANALOG_OUTPUT && objectInstance == 2) {
-                encodeBACnetReal(&responseBuffer[bufferPosition], analogOutput1.present_value);
-                bufferPosition += 4;
-                Serial.println("  Value: " + String(analogOutput1.present_value));
+                encodeBACnetFixed(&responseBuffer[bufferPosition], analogOutput1.present_value);
+                bufferPosition += 5;
             } else if (objectType == OBJECT_ANALOG_INPUT && objectInstance == 3) {
-                encodeBACnetReal(&responseBuffer[bufferPosition], analogInput1.present_value);
-                bufferPosition += 4;
-                Serial.println("  Value: " + String(analogInput1.present_value));
+                encodeBACnetFixed(&responseBuffer[bufferPosition], analogInput1.present_value);
+                bufferPosition += 5;
             } else if (objectType == OBJECT_ANALOG_INPUT && objectInstance == 4) {
-                encodeBACnetReal(&responseBuffer[bufferPosition], analogInput2.present_value);
-                bufferPosition += 4;
-                Serial.println("  Value: " + String(analogInput2.present_value));
+                encodeBACnetFixed(&responseBuffer[bufferPosition], analogInput2.present_value);
+                bufferPosition += 5;
+            } else if (objectType == OBJECT_BINARY_INPUT && objectInstance == 5) {
+                responseBuffer[bufferPosition++] = 0x91; // Enumerated, active/inactive
+                responseBuffer[bufferPosition++] = binaryInput1.present_value != 0 ? 1 : 0;
+            }
+            break;
+            
+        case PROP_COV_INCREMENT: {
+            BACnetObject* object = findObject(objectType, objectInstance);
+            if (object == nullptr || (objectType != OBJECT_ANALOG_INPUT && objectType != OBJECT_ANALOG_OUTPUT)) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            encodeBACnetFixed(&responseBuffer[bufferPosition], object->cov_increment);
+            bufferPosition += 5;
+            break;
+        }
+            
+        case PROP_PRIORITY_ARRAY:
+        case PROP_RELINQUISH_DEFAULT: {
+            BACnetObject* object = findObject(objectType, objectInstance);
+            BACnetPriorityArray* priorityArray = object ? findPriorityArray(object) : nullptr;
+            if (priorityArray == nullptr) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            bool isBinary = objectType == OBJECT_BINARY_OUTPUT;
+            if (propertyId == PROP_RELINQUISH_DEFAULT) {
+                if (isBinary) {
+                    responseBuffer[bufferPosition++] = 0x91; // Enumerated, inactive
+                    responseBuffer[bufferPosition++] = 0;
+                } else {
+                    encodeBACnetReal(&responseBuffer[bufferPosition], 0.0);
+                    bufferPosition += 5;
+                }
+                break;
+            }
+            for (uint8_t slot = 0; slot < BACNET_PRIORITY_LEVELS; slot++) {
+                if (!(priorityArray->active_mask & (1 << slot))) {
+                    responseBuffer[bufferPosition++] = 0x00; // NULL
+                } else if (isBinary) {
+                    responseBuffer[bufferPosition++] = 0x91;
+                    responseBuffer[bufferPosition++] = priorityArray->values[slot] != 0 ? 1 : 0;
+                } else {
+                    encodeBACnetReal(&responseBuffer[bufferPosition], priorityArray->values[slot]);
+                    bufferPosition += 5;
+                }
+            }
+            break;
+        }
+            
+        case PROP_LOCAL_DATE:
+        case PROP_LOCAL_TIME: {
+            if (objectType != OBJECT_DEVICE) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            // Fields stay unspecified (0xFF) until the clock is synchronized
+            struct tm local;
+            bool known = timeService != nullptr && timeService->getLocalTime(&local);
+            if (propertyId == PROP_LOCAL_DATE) {
+                responseBuffer[bufferPosition++] = 0xA4; // Application tag, date
+                responseBuffer[bufferPosition++] = known ? local.tm_year : 0xFF;
+                responseBuffer[bufferPosition++] = known ? local.tm_mon + 1 : 0xFF;
+                responseBuffer[bufferPosition++] = known ? local.tm_mday : 0xFF;
+                responseBuffer[bufferPosition++] = known ? (local.tm_wday == 0 ? 7 : local.tm_wday) : 0xFF;
+            } else {
+                responseBuffer[bufferPosition++] = 0xB4; // Application tag, time
+                responseBuffer[bufferPosition++] = known ? local.tm_hour : 0xFF;
+                responseBuffer[bufferPosition++] = known ? local.tm_min : 0xFF;
+                responseBuffer[bufferPosition++] = known ? local.tm_sec : 0xFF;
+                responseBuffer[bufferPosition++] = known ? 0 : 0xFF; // Hundredths
             }
             break;
+        }
             
         case PROP_SYSTEM_STATUS:
-            Serial.println("Property: System Status");
-            encodeBACnetUnsigned(&responseBuffer[bufferPosition], 0);
-            bufferPosition += 2;
-            Serial.println("  Value: Operational (0)");
+            memcpy(&responseBuffer[bufferPosition], SYSTEM_STATUS_OPERATIONAL.bytes, SYSTEM_STATUS_OPERATIONAL.length);
+            bufferPosition += SYSTEM_STATUS_OPERATIONAL.length;
             break;
             
         case PROP_VENDOR_NAME:
-            Serial.println("Property: Vendor Name");
-            encodeBACnetCharacterString(&responseBuffer[bufferPosition], "Sachithra");
-            bufferPosition += strlen("Sachithra") + 2;
-            Serial.println("  Value: Sachithra");
+            memcpy(&responseBuffer[bufferPosition], VENDOR_NAME_VALUE.bytes, sizeof(VENDOR_NAME_VALUE.bytes));
+            bufferPosition += sizeof(VENDOR_NAME_VALUE.bytes);
             break;
             
         case PROP_VENDOR_IDENTIFIER:
-            Serial.println("Property: Vendor Identifier");
-            encodeBACnetUnsigned(&responseBuffer[bufferPosition], VENDOR_ID);
-            bufferPosition += 2;
-            Serial.println("  Value: " + String(VENDOR_ID));
+            memcpy(&responseBuffer[bufferPosition], VENDOR_ID_VALUE.bytes, VENDOR_ID_VALUE.length);
+            bufferPosition += VENDOR_ID_VALUE.length;
+            break;
+            
+        case PROP_FREE_HEAP:
+        case PROP_LARGEST_FREE_BLOCK:
+        case PROP_HEAP_FRAGMENTATION:
+        case PROP_MIN_LARGEST_FREE_BLOCK: {
+            if (objectType != OBJECT_DEVICE || heapMonitor == nullptr) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            uint32_t heapValue = heapMonitor->getFreeHeap();
+            if (propertyId == PROP_LARGEST_FREE_BLOCK) heapValue = heapMonitor->getLargestFreeBlock();
+            else if (propertyId == PROP_HEAP_FRAGMENTATION) heapValue = heapMonitor->getFragmentation();
+            else if (propertyId == PROP_MIN_LARGEST_FREE_BLOCK) heapValue = heapMonitor->getMinLargestFreeBlock();
+            bufferPosition += encodeBACnetUnsigned(&responseBuffer[bufferPosition], heapValue);
             break;
+        }
+            
+        case PROP_RECORD_COUNT:
+        case PROP_TOTAL_RECORD_COUNT:
+        case PROP_BUFFER_SIZE:
+        case PROP_LOG_INTERVAL: {
+            if (objectType != OBJECT_TRENDLOG || trendLogManager == nullptr || !trendLogManager->hasLog(objectInstance)) {
+                Serial.println("Property Error: Trend Log property requested on non Trend Log object");
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            uint32_t logValue = 0;
+            if (propertyId == PROP_RECORD_COUNT) logValue = trendLogManager->getRecordCount(objectInstance);
+            else if (propertyId == PROP_TOTAL_RECORD_COUNT) logValue = trendLogManager->getTotalRecordCount(objectInstance);
+            else if (propertyId == PROP_BUFFER_SIZE) logValue = trendLogManager->getBufferSize();
+            else logValue = TREND_LOG_INTERVAL / 10; // Log_Interval is in hundredths of a second
+            bufferPosition += encodeBACnetUnsigned(&responseBuffer[bufferPosition], logValue);
+            break;
+        }
             
         default:
-            Serial.println("Property Error: Unknown property requested - " + String(propertyId));
+            Serial.printf("Property Error: Unknown property requested - %lu\n", (unsigned long)propertyId);
             propertyAvailable = false;
             sendError(remoteIP, remotePort, invokeId, 0, 0); // Unknown property error
             return;
@@ -354,16 +942,141 @@ void BACnetProtocol::sendReadPropertyACK(IPAddress remoteIP, uint16_t remotePort
         uint16_t totalPacketLength = bufferPosition;
         responseBuffer[2] = (totalPacketLength >> 8) & 0xFF;
         responseBuffer[3] = totalPacketLength & 0xFF;
+        readPropertyCycles += ESP.getCycleCount() - assemblyStart;
+        readPropertyResponses++;
         
         // Send response to requesting device
-        bacnetUDP.beginPacket(remoteIP, remotePort);
-        bacnetUDP.write(responseBuffer, bufferPosition);
-        bacnetUDP.endPacket();
+        sendResponse(remoteIP, remotePort, responseBuffer, bufferPosition);
         
         Serial.println("ReadProperty Acknowledgement Sent Successfully");
-        Serial.println("  Destination: " + remoteIP.toString() + ":" + String(remotePort));
-        Serial.println("  Total Packet Size: " + String(totalPacketLength) + " bytes");
+        Serial.printf("  Object: %u:%lu, Property: %lu\n", objectType, (unsigned long)objectInstance, (unsigned long)propertyId);
+        Serial.printf("  Destination: " IP_FORMAT ":%u\n", IP_ARGS(remoteIP), remotePort);
+        Serial.printf("  Total Packet Size: %u bytes\n", totalPacketLength);
+    }
+}
+
+// ReadProperty on a virtual device: its Device object and points, encoded as for the physical device
+void BACnetProtocol::sendVirtualReadPropertyACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId,
+                                                uint16_t objectType, uint32_t objectInstance, uint32_t propertyId) {
+    BACnetVirtualDevice* device = router.getDevice(route.device);
+    bool isDevice = objectType == OBJECT_DEVICE && objectInstance == device->instance;
+    BACnetVirtualObject* object = isDevice ? nullptr : router.findObject(route.device, objectType, objectInstance);
+    if (!isDevice && object == nullptr) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
+        return;
+    }
+    
+    uint8_t responseBuffer[128];
+    int bufferPosition = sizeof(COMPLEX_ACK_HEADER);
+    memcpy(responseBuffer, COMPLEX_ACK_HEADER, sizeof(COMPLEX_ACK_HEADER));
+    responseBuffer[bufferPosition++] = invokeId;
+    responseBuffer[bufferPosition++] = 0x0c;
+    encodeBACnetObjectId(&responseBuffer[bufferPosition], objectType, objectInstance);
+    bufferPosition += 4;
+    encodeBACnetUnsigned(&responseBuffer[bufferPosition], propertyId);
+    bufferPosition += (propertyId <= 255) ? 2 : 3;
+    
+    switch (propertyId) {
+        case PROP_OBJECT_IDENTIFIER:
+            encodeBACnetObjectId(&responseBuffer[bufferPosition], objectType, objectInstance);
+            bufferPosition += 4;
+            break;
+            
+        case PROP_OBJECT_NAME: {
+            const char* name = isDevice ? device->name : object->name;
+            encodeBACnetCharacterString(&responseBuffer[bufferPosition], name);
+            bufferPosition += strlen(name) + 2;
+            break;
+        }
+            
+        case PROP_OBJECT_TYPE:
+            encodeBACnetUnsigned(&responseBuffer[bufferPosition], objectType);
+            bufferPosition += (objectType <= 255) ? 2 : 3;
+            break;
+            
+        case PROP_PRESENT_VALUE:
+            if (isDevice) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            if (objectType == OBJECT_BINARY_INPUT || objectType == OBJECT_BINARY_OUTPUT) {
+                responseBuffer[bufferPosition++] = 0x91; // Enumerated, active/inactive
+                responseBuffer[bufferPosition++] = fixedIsValid(object->present_value) && object->present_value != 0 ? 1 : 0;
+            } else {
+                encodeBACnetFixed(&responseBuffer[bufferPosition], object->present_value);
+                bufferPosition += 5;
+            }
+            break;
+            
+        case PROP_SYSTEM_STATUS:
+        case PROP_VENDOR_NAME:
+        case PROP_VENDOR_IDENTIFIER:
+            if (!isDevice) {
+                sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+                return;
+            }
+            if (propertyId == PROP_SYSTEM_STATUS) {
+                memcpy(&responseBuffer[bufferPosition], SYSTEM_STATUS_OPERATIONAL.bytes, SYSTEM_STATUS_OPERATIONAL.length);
+                bufferPosition += SYSTEM_STATUS_OPERATIONAL.length;
+            } else if (propertyId == PROP_VENDOR_NAME) {
+                memcpy(&responseBuffer[bufferPosition], VENDOR_NAME_VALUE.bytes, sizeof(VENDOR_NAME_VALUE.bytes));
+                bufferPosition += sizeof(VENDOR_NAME_VALUE.bytes);
+            } else {
+                memcpy(&responseBuffer[bufferPosition], VENDOR_ID_VALUE.bytes, VENDOR_ID_VALUE.length);
+                bufferPosition += VENDOR_ID_VALUE.length;
+            }
+            break;
+            
+        default:
+            sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY);
+            return;
+    }
+    
+    responseBuffer[2] = (bufferPosition >> 8) & 0xFF;
+    responseBuffer[3] = bufferPosition & 0xFF;
+    sendResponse(remoteIP, remotePort, responseBuffer, bufferPosition);
+    Serial.printf("ReadProperty Answered for Virtual Device %lu\n", (unsigned long)device->instance);
+}
+
+// Only the present value of points the application marked writable can be
+// written, and only within the point's range
+void BACnetProtocol::writeVirtualProperty(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint16_t objectType,
+                                          uint32_t objectInstance, uint32_t propertyId, BACnetValue& value) {
+    BACnetVirtualObject* object = router.findObject(route.device, objectType, objectInstance);
+    if (object == nullptr) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
+        return;
+    }
+    if (propertyId != PROP_PRESENT_VALUE || !object->writable) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_WRITE_ACCESS_DENIED);
+        return;
     }
+    bool isNumeric = value.tag == 1 || value.tag == 2 || value.tag == 4 || value.tag == 9;
+    if (!isNumeric) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_DATA_TYPE);
+        return;
+    }
+    // Checked before conversion, which would saturate; NaN fails both comparisons
+    if (!(value.number >= fixedToFloat(object->minimum) && value.number <= fixedToFloat(object->maximum))) {
+        sendError(remoteIP, remotePort, invokeId, ERROR_CLASS_PROPERTY, ERROR_CODE_VALUE_OUT_OF_RANGE);
+        return;
+    }
+    
+    router.writePresentValue(route.device, object, fixedFromFloat(value.number));
+    Serial.printf("  Virtual Point %s = %.2f\n", object->name, fixedToFloat(object->present_value));
+    sendSimpleACK(remoteIP, remotePort, invokeId, 0x0F);
+}
+
+void BACnetProtocol::sendSimpleACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t serviceChoice) {
+    uint8_t ackBuffer[9] = {
+        0x81, 0x0a, 0x00, 0x09, // BVLC Header
+        0x01, 0x00,             // NPDU
+        0x20, invokeId, serviceChoice // APDU - Simple ACK
+    };
+    
+    sendResponse(remoteIP, remotePort, ackBuffer, sizeof(ackBuffer));
+    
+    Serial.printf("BACnet Simple ACK Sent for Service %u\n", serviceChoice);
 }
 
 void BACnetProtocol::sendError(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t errorClass, uint8_t errorCode) {
@@ -391,14 +1104,26 @@ void BACnetProtocol::sendError(IPAddress remoteIP, uint16_t remotePort, uint8_t
     errorBuffer[bufferPosition++] = errorClass;
     errorBuffer[bufferPosition++] = errorCode;
     
-    bacnetUDP.beginPacket(remoteIP, remotePort);
-    bacnetUDP.write(errorBuffer, bufferPosition);
-    bacnetUDP.endPacket();
+    sendResponse(remoteIP, remotePort, errorBuffer, bufferPosition);
     
     Serial.println("BACnet Error Response Sent");
-    Serial.println("  Error Class: " + String(errorClass));
-    Serial.println("  Error Code: " + String(errorCode));
-    Serial.println("  Destination: " + remoteIP.toString() + ":" + String(remotePort));
+    Serial.printf("  Error Class: %u\n", errorClass);
+    Serial.printf("  Error Code: %u\n", errorCode);
+    Serial.printf("  Destination: " IP_FORMAT ":%u\n", IP_ARGS(remoteIP), remotePort);
+}
+
+void BACnetProtocol::sendAbort(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t reason) {
+    uint8_t abortBuffer[9] = {
+        0x81, 0x0a, 0x00, 0x09, // BVLC Header
+        0x01, 0x00,             // NPDU
+        0x71,                   // Abort PDU, sent by server
+        invokeId,
+        reason
+    };
+    
+    sendResponse(remoteIP, remotePort, abortBuffer, sizeof(abortBuffer));
+    
+    Serial.printf("BACnet Requests Throttled: " IP_FORMAT ", Abort sent\n", IP_ARGS(remoteIP));
 }
 
 // BACnet Encoding/Decoding Functions
@@ -409,23 +1134,37 @@ void BACnetProtocol::encodeBACnetObjectId(uint8_t* buffer, uint16_t objectType,
     buffer[3] = objectInstance & 0xFF;
 }
 
-void BACnetProtocol::encodeBACnetUnsigned(uint8_t* buffer, uint32_t value) {
+uint8_t BACnetProtocol::encodeBACnetUnsigned(uint8_t* buffer, uint32_t value) {
     if (value <= 255) {
         buffer[0] = 0x21; // Context tag, length 1
         buffer[1] = value;
+        return 2;
     } else if (value <= 65535) {
         buffer[0] = 0x22; // Context tag, length 2
         buffer[1] = (value >> 8) & 0xFF;
         buffer[2] = value & 0xFF;
+        return 3;
     } else {
         buffer[0] = 0x24; // Context tag, length 4
         buffer[1] = (value >> 24) & 0xFF;
         buffer[2] = (value >> 16) & 0xFF;
         buffer[3] = (value >> 8) & 0xFF;
         buffer[4] = value & 0xFF;
+        return 5;
     }
 }
 
+uint8_t BACnetProtocol::encodeBACnetContextUnsigned(uint8_t* buffer, uint8_t tagNumber, uint32_t value) {
+    uint8_t length = encodeBACnetUnsigned(buffer, value);
+    buffer[0] = (tagNumber << 4) | 0x08 | (length - 1); // Context class, same value length
+    return length;
+}
+
+// Fixed-point values become IEEE REAL only here; an invalid reading goes out as NaN
+void BACnetProtocol::encodeBACnetFixed(uint8_t* buffer, fixed_t value) {
+    encodeBACnetReal(buffer, fixedIsValid(value) ? fixedToFloat(value) : NAN);
+}
+
 void BACnetProtocol::encodeBACnetReal(uint8_t* buffer, float value) {
     buffer[0] = 0x44; // Application tag, real (4 bytes)
     
@@ -448,15 +1187,42 @@ void BACnetProtocol::encodeBACnetCharacterString(uint8_t* buffer, const char* st
     memcpy(&buffer[2], str, strlen(str)); // String content
 }
 
+uint8_t BACnetProtocol::encodeBACnetDateTime(uint8_t* buffer, uint32_t timestamp) {
+    // Convert seconds since 1970-01-01 into a civil date (days-from-civil inverse)
+    uint32_t days = timestamp / 86400;
+    uint32_t secondsOfDay = timestamp % 86400;
+    
+    int32_t z = days + 719468;
+    int32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    uint32_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    
+    buffer[0] = 0xA4; // Application tag, date
+    buffer[1] = year - 1900;
+    buffer[2] = month;
+    buffer[3] = day;
+    buffer[4] = (days + 3) % 7 + 1; // 1970-01-01 was a Thursday, Monday = 1
+    
+    buffer[5] = 0xB4; // Application tag, time
+    buffer[6] = secondsOfDay / 3600;
+    buffer[7] = (secondsOfDay / 60) % 60;
+    buffer[8] = secondsOfDay % 60;
+    buffer[9] = 0;
+    return 10;
+}
+
 uint16_t BACnetProtocol::decodeBACnetUnsigned(uint8_t* buffer, uint8_t len) {
-    if (len < 2) {
+    uint8_t valueLength = len > 0 ? buffer[0] & 0x07 : 0;
+    if (len < 2 || len < valueLength + 1) {
         Serial.println("BACnet Decode Error: Buffer too short for unsigned integer");
         return 0;
     }
     
-    uint8_t tagByte = buffer[0];
-    uint8_t valueLength = tagByte & 0x07;
-    
     if (valueLength == 1) {
         return buffer[1];
     } else if (valueLength == 2) {
@@ -472,19 +1238,273 @@ uint32_t BACnetProtocol::decodeBACnetObjectId(uint8_t* buffer, uint16_t* objectT
     return (buffer[2] << 8) | buffer[3];
 }
 
-void BACnetProtocol::updateBinaryOutput(uint32_t instance, float value) {
+uint8_t BACnetProtocol::decodeBACnetApplicationValue(uint8_t* buffer, size_t len, uint8_t expectedTag, uint32_t* value) {
+    if (len < 2 || (buffer[0] >> 4) != expectedTag || (buffer[0] & 0x08)) {
+        return 0;
+    }
+    
+    uint8_t valueLength = buffer[0] & 0x07;
+    if (valueLength < 1 || valueLength > 4 || len < (size_t)valueLength + 1) {
+        return 0;
+    }
+    
+    *value = 0;
+    for (uint8_t i = 1; i <= valueLength; i++) {
+        *value = (*value << 8) | buffer[i];
+    }
+    return valueLength + 1;
+}
+
+uint8_t BACnetProtocol::decodeBACnetValue(uint8_t* buffer, size_t len, BACnetValue* value) {
+    if (len < 1 || (buffer[0] & 0x08)) return 0;
+    
+    value->tag = buffer[0] >> 4;
+    value->number = 0;
+    value->text[0] = '\0';
+    uint8_t lengthValue = buffer[0] & 0x07;
+    
+    switch (value->tag) {
+        case 0: // Null
+            return 1;
+        case 1: // Boolean, value carried in the tag
+            value->number = lengthValue ? 1.0 : 0.0;
+            return 1;
+        case 2: // Unsigned
+        case 9: // Enumerated
+        case 12: { // Object identifier, always the full 4 bytes
+            uint32_t raw = 0;
+            if (lengthValue < 1 || lengthValue > 4 || len < (size_t)lengthValue + 1) return 0;
+            if (value->tag == 12 && lengthValue != 4) return 0;
+            for (uint8_t i = 1; i <= lengthValue; i++) raw = (raw << 8) | buffer[i];
+            value->unsignedValue = raw;
+            value->number = raw;
+            return lengthValue + 1;
+        }
+        case 4: { // Real
+            if (lengthValue != 4 || len < 5) return 0;
+            uint32_t raw = ((uint32_t)buffer[1] << 24) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 8) | buffer[4];
+            memcpy(&value->number, &raw, sizeof(raw));
+            return 5;
+        }
+        case 7: { // Character string: length, charset byte, characters
+            size_t headerLength = 1;
+            size_t stringLength = lengthValue;
+            if (lengthValue == 5) {
+                if (len < 2) return 0;
+                stringLength = buffer[1];
+                headerLength = 2;
+            }
+            if (stringLength < 1 || len < headerLength + stringLength || buffer[headerLength] != 0) return 0;
+            size_t textLength = min(stringLength - 1, sizeof(value->text) - 1);
+            memcpy(value->text, &buffer[headerLength + 1], textLength);
+            value->text[textLength] = '\0';
+            return headerLength + stringLength;
+        }
+        default:
+            return 0;
+    }
+}
+
+uint8_t BACnetProtocol::decodeBACnetDateTime(uint8_t* buffer, size_t len, uint32_t* timestamp) {
+    if (len < 10 || buffer[0] != 0xA4 || buffer[5] != 0xB4) {
+        return 0;
+    }
+    
+    // Wildcard (0xFF) fields are treated as zero
+    int32_t year = buffer[1] == 0xFF ? 1970 : buffer[1] + 1900;
+    uint32_t month = (buffer[2] == 0 || buffer[2] > 12) ? 1 : buffer[2];
+    uint32_t day = (buffer[3] == 0 || buffer[3] > 31) ? 1 : buffer[3];
+    uint32_t hour = buffer[6] > 23 ? 0 : buffer[6];
+    uint32_t minute = buffer[7] > 59 ? 0 : buffer[7];
+    uint32_t second = buffer[8] > 59 ? 0 : buffer[8];
+    
+    year -= month <= 2 ? 1 : 0;
+    int32_t era = year / 400;
+    uint32_t yearOfEra = year - era * 400;
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int32_t days = era * 146097 + (int32_t)dayOfEra - 719468;
+    
+    *timestamp = days < 0 ? 0 : (uint32_t)days * 86400 + hour * 3600 + minute * 60 + second;
+    return 10;
+}
+
+void BACnetProtocol::updateBinaryOutput(uint32_t instance, fixed_t value) {
     if (instance == 1) {
         binaryOutput1.present_value = value;
     }
 }
 
-void BACnetProtocol::updateAnalogOutput(uint32_t instance, float value) {
+void BACnetProtocol::updateAnalogOutput(uint32_t instance, fixed_t value) {
     if (instance == 2) {
         analogOutput1.present_value = value;
     }
 }
 
-void BACnetProtocol::updateAnalogInput(uint32_t instance, float value) {
+void BACnetProtocol::setTrendLogManager(TrendLogManager* logs) {
+    trendLogManager = logs;
+}
+
+void BACnetProtocol::setConfigStore(ConfigStore* store) {
+    configStore = store;
+}
+
+void BACnetProtocol::setTimeService(TimeService* clock) {
+    timeService = clock;
+}
+
+void BACnetProtocol::setHeapMonitor(HeapMonitor* monitor) {
+    heapMonitor = monitor;
+}
+
+void BACnetProtocol::onOutputWrite(BACnetOutputCallback callback) {
+    outputCallback = callback;
+}
+
+uint32_t BACnetProtocol::getDeviceInstance() {
+    return deviceObject.object_id;
+}
+
+bool BACnetProtocol::setDeviceInstance(uint32_t instance) {
+    if (instance > BACNET_INSTANCE_MAX) return false;
+    if (instance == deviceObject.object_id) return true;
+    
+    deviceObject.object_id = instance;
+    if (configStore != nullptr) {
+        configStore->setUInt32(CONFIG_KEY_DEVICE_INSTANCE, instance);
+    }
+    encodeIAm();
+    Serial.printf("BACnet Device Instance Changed to %lu\n", (unsigned long)instance);
+    
+    // Let the network learn the new identity straight away
+    announcePresence();
+    return true;
+}
+
+bool BACnetProtocol::setObjectName(uint16_t objectType, uint32_t instance, const char* name) {
+    BACnetObject* object = findObject(objectType, instance);
+    if (object == nullptr) return false;
+    
+    strncpy(object->object_name, name, sizeof(object->object_name) - 1);
+    object->object_name[sizeof(object->object_name) - 1] = '\0';
+    encodeObjectName(findObjectIndex(objectType, instance));
+    if (configStore != nullptr) {
+        configStore->setString(object == &deviceObject ? CONFIG_KEY_DEVICE_NAME : CONFIG_KEY_OBJECT_NAME + instance,
+                               object->object_name);
+    }
+    Serial.printf("BACnet Object %lu Renamed to %s\n", (unsigned long)instance, object->object_name);
+    return true;
+}
+
+bool BACnetProtocol::setCOVIncrement(uint16_t objectType, uint32_t instance, fixed_t increment) {
+    BACnetObject* object = findObject(objectType, instance);
+    if (object == nullptr || (objectType != OBJECT_ANALOG_INPUT && objectType != OBJECT_ANALOG_OUTPUT)) return false;
+    
+    object->cov_increment = increment;
+    if (configStore != nullptr) {
+        configStore->setFloat(CONFIG_KEY_COV_INCREMENT + instance, fixedToFloat(increment));
+    }
+    return true;
+}
+
+uint8_t BACnetProtocol::getObjectCount() {
+    return BACNET_OBJECT_COUNT;
+}
+
+BACnetObject* BACnetProtocol::getObject(uint8_t index) {
+    return index < BACNET_OBJECT_COUNT ? objects[index] : nullptr;
+}
+
+void BACnetProtocol::loadConfiguration() {
+    if (configStore == nullptr) return;
+    
+    deviceObject.object_id = configStore->getUInt32(CONFIG_KEY_DEVICE_INSTANCE, DEVICE_ID);
+    if (deviceObject.object_id > BACNET_INSTANCE_MAX) deviceObject.object_id = DEVICE_ID;
+    configStore->getString(CONFIG_KEY_DEVICE_NAME, deviceObject.object_name, sizeof(deviceObject.object_name));
+    
+    for (uint8_t i = 1; i < BACNET_OBJECT_COUNT; i++) {
+        BACnetObject* object = objects[i];
+        configStore->getString(CONFIG_KEY_OBJECT_NAME + object->object_id, object->object_name, sizeof(object->object_name));
+        object->cov_increment = fixedFromFloat(configStore->getFloat(CONFIG_KEY_COV_INCREMENT + object->object_id,
+                                                                    fixedToFloat(object->cov_increment)));
+        
+        // Only the array itself: DeviceManager owns the persisted output state,
+        // which the button, cloud and rules change too, and has already
+        // restored it. Replaying the array would override their last change.
+        BACnetPriorityArray* priorityArray = findPriorityArray(object);
+        if (priorityArray != nullptr) {
+            configStore->get(CONFIG_KEY_PRIORITY_ARRAY + object->object_id, priorityArray, sizeof(BACnetPriorityArray));
+        }
+    }
+}
+
+uint8_t BACnetProtocol::findObjectIndex(uint16_t objectType, uint32_t instance) {
+    for (uint8_t i = 0; i < BACNET_OBJECT_COUNT; i++) {
+        if (objects[i]->object_type == objectType && objects[i]->object_id == instance) {
+            return i;
+        }
+    }
+    return BACNET_OBJECT_COUNT;
+}
+
+BACnetObject* BACnetProtocol::findObject(uint16_t objectType, uint32_t instance) {
+    uint8_t index = findObjectIndex(objectType, instance);
+    return index < BACNET_OBJECT_COUNT ? objects[index] : nullptr;
+}
+
+fixed_t BACnetProtocol::effectivePriorityValue(BACnetPriorityArray* priorityArray) {
+    // Highest active priority, else the relinquish default (0)
+    for (uint8_t slot = 0; slot < BACNET_PRIORITY_LEVELS; slot++) {
+        if (priorityArray->active_mask & (1 << slot)) {
+            return fixedFromFloat(priorityArray->values[slot]);
+        }
+    }
+    return 0;
+}
+
+BACnetPriorityArray* BACnetProtocol::findPriorityArray(BACnetObject* object) {
+    if (object == &binaryOutput1) return &binaryOutput1Priority;
+    if (object == &analogOutput1) return &analogOutput1Priority;
+    return nullptr;
+}
+
+// Binary outputs take inactive or active, the analog output is the 0-255
+// dimmer level. NaN fails every comparison and is rejected with the rest.
+bool BACnetProtocol::isOutputValueInRange(BACnetObject* object, float value) {
+    if (object->object_type == OBJECT_BINARY_OUTPUT) {
+        return value == 0 || value == 1;
+    }
+    return value >= 0 && value <= 255;
+}
+
+void BACnetProtocol::writeCommandableValue(BACnetObject* object, BACnetPriorityArray* priorityArray, BACnetValue& value, uint8_t priority) {
+    uint16_t slotBit = 1 << (priority - 1);
+    if (value.tag == 0) {
+        priorityArray->active_mask &= ~slotBit; // NULL relinquishes the slot
+    } else {
+        priorityArray->active_mask |= slotBit;
+        priorityArray->values[priority - 1] = object->object_type == OBJECT_BINARY_OUTPUT ? (value.number != 0 ? 1.0 : 0.0) : value.number;
+    }
+    
+    fixed_t effectiveValue = effectivePriorityValue(priorityArray);
+    object->present_value = effectiveValue;
+    
+    if (configStore != nullptr) {
+        configStore->set(CONFIG_KEY_PRIORITY_ARRAY + object->object_id, priorityArray, sizeof(BACnetPriorityArray));
+    }
+    if (outputCallback != nullptr) {
+        outputCallback(object->object_id, effectiveValue);
+    }
+    Serial.printf("  Effective Present Value: %.2f\n", fixedToFloat(effectiveValue));
+}
+
+void BACnetProtocol::updateBinaryInput(uint32_t instance, fixed_t value) {
+    if (instance == 5) {
+        binaryInput1.present_value = value;
+    }
+}
+
+void BACnetProtocol::updateAnalogInput(uint32_t instance, fixed_t value) {
     if (instance == 3) {
         analogInput1.present_value = value;
     } else if (instance == 4) {
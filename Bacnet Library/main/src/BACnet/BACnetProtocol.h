@@ -4,15 +4,28 @@
 #include <Arduino.h>
 #include <WiFiUdp.h>
 #include "../config/config.h"
+#include "../TrendLog/TrendLogManager.h"
+#include "../Storage/ConfigStore.h"
+#include "../System/TimeService.h"
+#include "../System/HeapMonitor.h"
+#include "../System/FixedPoint.h"
+#include "BACnetAdmission.h"
+#include "BACnetReplyCache.h"
+#include "BACnetRouter.h"
 
 // BACnet Constants
 #define OBJECT_ANALOG_INPUT 0
 #define OBJECT_ANALOG_OUTPUT 1
+#define OBJECT_ANALOG_VALUE 2
 #define OBJECT_BINARY_INPUT 3
 #define OBJECT_BINARY_OUTPUT 4
 #define OBJECT_DEVICE 8
+#define OBJECT_TRENDLOG 20
 
 // BACnet Property Identifiers
+#define PROP_COV_INCREMENT 22
+#define PROP_LOCAL_DATE 56
+#define PROP_LOCAL_TIME 57
 #define PROP_OBJECT_IDENTIFIER 75
 #define PROP_OBJECT_NAME 77
 #define PROP_OBJECT_TYPE 79
@@ -20,58 +33,190 @@
 #define PROP_VENDOR_NAME 99
 #define PROP_VENDOR_IDENTIFIER 96
 #define PROP_PRESENT_VALUE 85
+#define PROP_PRIORITY_ARRAY 87
+#define PROP_RELINQUISH_DEFAULT 104
+#define PROP_BUFFER_SIZE 126
+#define PROP_LOG_BUFFER 131
+#define PROP_LOG_INTERVAL 134
+#define PROP_RECORD_COUNT 141
+#define PROP_TOTAL_RECORD_COUNT 145
+
+// Proprietary Device properties reporting heap health
+#define PROP_FREE_HEAP 512
+#define PROP_LARGEST_FREE_BLOCK 513
+#define PROP_HEAP_FRAGMENTATION 514
+#define PROP_MIN_LARGEST_FREE_BLOCK 515
+
+// BACnet Error Classes and Codes
+#define ERROR_CLASS_DEVICE 0
+#define ERROR_CLASS_OBJECT 1
+#define ERROR_CLASS_PROPERTY 2
+#define ERROR_CLASS_SERVICES 5
+#define ERROR_CODE_UNKNOWN_OBJECT 31
+#define ERROR_CODE_UNKNOWN_PROPERTY 32
+#define ERROR_CODE_VALUE_OUT_OF_RANGE 37
+#define ERROR_CODE_WRITE_ACCESS_DENIED 40
+#define ERROR_CODE_INVALID_DATA_TYPE 9
+#define ERROR_CODE_OPERATIONAL_PROBLEM 25
+#define ERROR_CODE_INVALID_TAG 57
+#define ABORT_REASON_OUT_OF_RESOURCES 9
+
+#define BACNET_MIN_FRAME_LENGTH 5     // BVLC header and unconfirmed service choice
+#define BACNET_MIN_CONFIRMED_LENGTH 7 // Up to the confirmed service choice
+#define BACNET_PRIORITY_LEVELS 16
+#define BACNET_OBJECT_COUNT 6
+#define BACNET_VENDOR_NAME "Sachithra"
+#define BACNET_I_AM_FRAME_SIZE 24
+#define BACNET_ENCODED_NAME_SIZE 33 // Tag, length and up to 31 characters
 
 // BACnet Object Structure Definition
 typedef struct {
     uint32_t object_id;
     uint16_t object_type;
     char object_name[32];
-    float present_value;
+    fixed_t present_value;
     char description[64];
+    fixed_t cov_increment;
 } BACnetObject;
 
+// Command priority array of a commandable output, slot 0 = priority 1.
+// Values stay float because the array is persisted as a binary record.
+typedef struct {
+    uint16_t active_mask;
+    float values[BACNET_PRIORITY_LEVELS];
+} BACnetPriorityArray;
+
+// Application-tagged value decoded from a WriteProperty request
+typedef struct {
+    uint8_t tag;
+    float number;
+    uint32_t unsignedValue;
+    char text[32];
+} BACnetValue;
+
+// Invoked when a BACnet write changes the effective value of an output
+typedef void (*BACnetOutputCallback)(uint32_t instance, fixed_t value);
+
 class BACnetProtocol {
 public:
     void begin();
     void handle();
     void broadcastPresence();
+    void announcePresence();
     void printStatus();
     
     // Callbacks for device state updates
-    void updateBinaryOutput(uint32_t instance, float value);
-    void updateAnalogOutput(uint32_t instance, float value);
-    void updateAnalogInput(uint32_t instance, float value);
+    void updateBinaryOutput(uint32_t instance, fixed_t value);
+    void updateAnalogOutput(uint32_t instance, fixed_t value);
+    void updateAnalogInput(uint32_t instance, fixed_t value);
+    void updateBinaryInput(uint32_t instance, fixed_t value);
+    
+    void setTrendLogManager(TrendLogManager* logs);
+    void setConfigStore(ConfigStore* store);
+    void setTimeService(TimeService* clock);
+    void setHeapMonitor(HeapMonitor* monitor);
+    void onOutputWrite(BACnetOutputCallback callback);
+    
+    // Runtime configuration, persisted through the config store
+    uint32_t getDeviceInstance();
+    bool setDeviceInstance(uint32_t instance);
+    bool setObjectName(uint16_t objectType, uint32_t instance, const char* name);
+    bool setCOVIncrement(uint16_t objectType, uint32_t instance, fixed_t increment);
+    uint8_t getObjectCount();
+    BACnetObject* getObject(uint8_t index);
+    
+    // Traffic counters for the metrics endpoint
+    uint32_t getRejectedFrames();
+    BACnetAdmission& getAdmission();
+    uint32_t getRetriesAnswered();
+    uint32_t getReadPropertyCycles(); // Average to assemble one reply, 0 before the first
+    
+    // Virtual devices hosted behind BACNET_VIRTUAL_NETWORK
+    BACnetRouter& getRouter();
 
 private:
     WiFiUDP bacnetUDP;
     uint32_t bacnetInvokeId = 1;
     unsigned long lastBACnetDiscovery = 0;
+    TrendLogManager* trendLogManager = nullptr;
+    ConfigStore* configStore = nullptr;
+    TimeService* timeService = nullptr;
+    HeapMonitor* heapMonitor = nullptr;
+    BACnetOutputCallback outputCallback = nullptr;
+    uint32_t rejectedFrames = 0;
+    uint64_t rejectCycles = 0;
+    BACnetAdmission admission;
+    BACnetReplyCache replyCache;
+    BACnetCachedReply* pendingReply = nullptr; // Slot capturing the reply to the request being processed
+    BACnetRouter router;
+    BACnetRoute route = {false}; // Set while serving a request for a virtual device
+    uint32_t readPropertyResponses = 0;
+    uint64_t readPropertyCycles = 0;
     
     // BACnet Objects
-    BACnetObject deviceObject = {DEVICE_ID, OBJECT_DEVICE, "SBMCon", 0.0, "Smart Building Controller"};
-    BACnetObject binaryOutput1 = {1, OBJECT_BINARY_OUTPUT, "Digital_LED", 0.0, "Digital LED Output"};
-    BACnetObject analogOutput1 = {2, OBJECT_ANALOG_OUTPUT, "Dimming_LED", 0.0, "Dimming LED Output"};
-    BACnetObject analogInput1 = {3, OBJECT_ANALOG_INPUT, "Temperature", 0.0, "Temperature Sensor"};
-    BACnetObject analogInput2 = {4, OBJECT_ANALOG_INPUT, "Humidity", 0.0, "Humidity Sensor"};
-    BACnetObject binaryInput1 = {5, OBJECT_BINARY_INPUT, "Button_State", 0.0, "Manual Button Input"};
+    BACnetObject deviceObject = {DEVICE_ID, OBJECT_DEVICE, "SBMCon", 0, "Smart Building Controller"};
+    BACnetObject binaryOutput1 = {1, OBJECT_BINARY_OUTPUT, "Digital_LED", 0, "Digital LED Output"};
+    BACnetObject analogOutput1 = {2, OBJECT_ANALOG_OUTPUT, "Dimming_LED", 0, "Dimming LED Output", FIXED_ONE};
+    BACnetObject analogInput1 = {3, OBJECT_ANALOG_INPUT, "Temperature", FIXED_INVALID, "Temperature Sensor", FIXED_ONE / 2};
+    BACnetObject analogInput2 = {4, OBJECT_ANALOG_INPUT, "Humidity", FIXED_INVALID, "Humidity Sensor", FIXED_ONE};
+    BACnetObject binaryInput1 = {5, OBJECT_BINARY_INPUT, "Button_State", 0, "Manual Button Input"};
+    BACnetObject* objects[BACNET_OBJECT_COUNT] = {
+        &deviceObject, &binaryOutput1, &analogOutput1, &analogInput1, &analogInput2, &binaryInput1
+    };
+    
+    BACnetPriorityArray binaryOutput1Priority = {0, {0}};
+    BACnetPriorityArray analogOutput1Priority = {0, {0}};
+    
+    // Responses that only change with configuration, encoded ahead of time
+    uint8_t iAmFrame[BACNET_I_AM_FRAME_SIZE];
+    uint8_t iAmLength = 0;
+    uint8_t encodedNames[BACNET_OBJECT_COUNT][BACNET_ENCODED_NAME_SIZE];
+    
+    void loadConfiguration();
+    void encodeIAm();
+    uint8_t encodeIAmBody(uint8_t* buffer, uint32_t instance);
+    void encodeObjectName(uint8_t index);
+    uint8_t findObjectIndex(uint16_t objectType, uint32_t instance);
+    BACnetObject* findObject(uint16_t objectType, uint32_t instance);
+    BACnetPriorityArray* findPriorityArray(BACnetObject* object);
+    fixed_t effectivePriorityValue(BACnetPriorityArray* priorityArray);
+    bool isOutputValueInRange(BACnetObject* object, float value);
+    void writeCommandableValue(BACnetObject* object, BACnetPriorityArray* priorityArray, BACnetValue& value, uint8_t priority);
     
     void processBACnetPacket(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort);
     void handleUnconfirmedRequest(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort);
     void handleConfirmedRequest(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort);
     void handleReadProperty(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId);
     void handleWriteProperty(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId);
+    void handleReadRange(uint8_t* buffer, size_t len, IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId);
+    void handleTimeSynchronization(uint8_t* buffer, size_t len, bool utc);
     void sendIAm();
+    void sendVirtualIAm(uint8_t device);
+    void sendBroadcast(const uint8_t* frame, size_t length);
+    void sendResponse(IPAddress remoteIP, uint16_t remotePort, const uint8_t* frame, size_t length);
     void sendReadPropertyACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, 
                             uint16_t objectType, uint32_t objectInstance, uint32_t propertyId);
+    void sendVirtualReadPropertyACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId,
+                                    uint16_t objectType, uint32_t objectInstance, uint32_t propertyId);
+    void writeVirtualProperty(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint16_t objectType,
+                              uint32_t objectInstance, uint32_t propertyId, BACnetValue& value);
+    void sendSimpleACK(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t serviceChoice);
     void sendError(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t errorClass, uint8_t errorCode);
+    void sendAbort(IPAddress remoteIP, uint16_t remotePort, uint8_t invokeId, uint8_t reason);
     
     // Encoding/Decoding functions
     void encodeBACnetObjectId(uint8_t* buffer, uint16_t objectType, uint32_t objectInstance);
-    void encodeBACnetUnsigned(uint8_t* buffer, uint32_t value);
+    uint8_t encodeBACnetUnsigned(uint8_t* buffer, uint32_t value);
+    uint8_t encodeBACnetContextUnsigned(uint8_t* buffer, uint8_t tagNumber, uint32_t value);
     void encodeBACnetReal(uint8_t* buffer, float value);
+    void encodeBACnetFixed(uint8_t* buffer, fixed_t value);
     void encodeBACnetCharacterString(uint8_t* buffer, const char* str);
+    uint8_t encodeBACnetDateTime(uint8_t* buffer, uint32_t timestamp);
     uint16_t decodeBACnetUnsigned(uint8_t* buffer, uint8_t len);
     uint32_t decodeBACnetObjectId(uint8_t* buffer, uint16_t* objectType);
+    uint8_t decodeBACnetApplicationValue(uint8_t* buffer, size_t len, uint8_t expectedTag, uint32_t* value);
+    uint8_t decodeBACnetDateTime(uint8_t* buffer, size_t len, uint32_t* timestamp);
+    uint8_t decodeBACnetValue(uint8_t* buffer, size_t len, BACnetValue* value);
 };
 
 #endif
\ No newline at end of file
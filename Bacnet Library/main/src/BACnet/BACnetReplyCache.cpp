@@ -0,0 +1,73 @@
+#include <Arduino.h>
+#include "BACnetReplyCache.h"
+#include "../System/StringGuard.h"
+
+static_assert(BACNET_REPLY_CACHE_SIZE <= 0xFF, "Reply cache slots are indexed with uint8_t");
+
+bool BACnetReplyCache::isCached(uint8_t service) {
+    return service == 0x0F; // WriteProperty
+}
+
+BACnetCachedReply* BACnetReplyCache::find(uint32_t address, uint16_t port, uint8_t invokeId, uint8_t service, uint32_t requestHash) {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < BACNET_REPLY_CACHE_SIZE; i++) {
+        BACnetCachedReply& entry = entries[i];
+        if (entry.length > 0 && now - entry.storedAt < BACNET_REPLY_CACHE_TIME &&
+            entry.address == address && entry.port == port && entry.invokeId == invokeId &&
+            entry.service == service && entry.requestHash == requestHash) {
+            hits++;
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+BACnetCachedReply* BACnetReplyCache::reserve(uint32_t address, uint16_t port, uint8_t invokeId, uint8_t service, uint32_t requestHash) {
+    // Reuse an empty or expired slot, otherwise the oldest reply
+    unsigned long now = millis();
+    BACnetCachedReply* slot = &entries[0];
+    for (uint8_t i = 0; i < BACNET_REPLY_CACHE_SIZE; i++) {
+        if (entries[i].length == 0 || now - entries[i].storedAt >= BACNET_REPLY_CACHE_TIME) {
+            slot = &entries[i];
+            break;
+        }
+        if (now - entries[i].storedAt > now - slot->storedAt) slot = &entries[i];
+    }
+
+    slot->address = address;
+    slot->port = port;
+    slot->invokeId = invokeId;
+    slot->service = service;
+    slot->requestHash = requestHash;
+    slot->storedAt = now;
+    slot->length = 0;
+    return slot;
+}
+
+void BACnetReplyCache::store(BACnetCachedReply* entry, const uint8_t* frame, size_t length) {
+    if (length > BACNET_REPLY_CACHE_BYTES) {
+        uncacheable++;
+        return;
+    }
+    memcpy(entry->frame, frame, length);
+    entry->length = length;
+    entry->storedAt = millis();
+}
+
+void BACnetReplyCache::printStatus() {
+    Serial.printf("  Retries Answered From Cache: %lu (%lu replies too large to cache)\n", (unsigned long)hits,
+                  (unsigned long)uncacheable);
+}
+
+uint32_t BACnetReplyCache::getHits() {
+    return hits;
+}
+
+uint32_t BACnetReplyCache::hashRequest(const uint8_t* frame, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ frame[i]) * 16777619UL;
+    }
+    return hash;
+}
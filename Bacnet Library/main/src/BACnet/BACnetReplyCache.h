@@ -0,0 +1,39 @@
+#ifndef BACNET_REPLY_CACHE_H
+#define BACNET_REPLY_CACHE_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Encoded reply to a WriteProperty request, kept so a client retry with the
+// same invoke ID is answered without writing again
+typedef struct {
+    uint32_t address;
+    uint16_t port;
+    uint8_t invokeId;
+    uint8_t service;
+    uint32_t requestHash; // Tells a retry from a new request reusing the invoke ID
+    unsigned long storedAt;
+    uint16_t length;      // 0 while no reply has been stored
+    uint8_t frame[BACNET_REPLY_CACHE_BYTES];
+} BACnetCachedReply;
+
+class BACnetReplyCache {
+public:
+    // Confirmed services whose replies are cached: those not safe to repeat
+    static bool isCached(uint8_t service);
+
+    BACnetCachedReply* find(uint32_t address, uint16_t port, uint8_t invokeId, uint8_t service, uint32_t requestHash);
+    BACnetCachedReply* reserve(uint32_t address, uint16_t port, uint8_t invokeId, uint8_t service, uint32_t requestHash);
+    void store(BACnetCachedReply* entry, const uint8_t* frame, size_t length);
+    void printStatus();
+    uint32_t getHits();
+
+    static uint32_t hashRequest(const uint8_t* frame, size_t length);
+
+private:
+    BACnetCachedReply entries[BACNET_REPLY_CACHE_SIZE] = {};
+    uint32_t hits = 0;
+    uint32_t uncacheable = 0;
+};
+
+#endif
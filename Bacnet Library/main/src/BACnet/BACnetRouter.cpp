@@ -0,0 +1,219 @@
+#include <Arduino.h>
+#include "BACnetRouter.h"
+#include "../System/StringGuard.h"
+
+// NPDU control bits
+#define NPDU_NETWORK_MESSAGE 0x80
+#define NPDU_DESTINATION 0x20
+#define NPDU_SOURCE 0x08
+
+uint8_t BACnetRouter::addDevice(uint32_t instance, const char* name) {
+    if (deviceCount >= BACNET_VIRTUAL_DEVICE_MAX) return BACNET_ROUTE_ALL;
+
+    BACnetVirtualDevice& device = devices[deviceCount];
+    device.instance = instance;
+    strncpy(device.name, name, sizeof(device.name) - 1);
+    device.name[sizeof(device.name) - 1] = '\0';
+    device.objectCount = 0;
+    Serial.printf("BACnet Virtual Device %lu (%s) on network %u, MAC %u\n", (unsigned long)instance, device.name,
+                  BACNET_VIRTUAL_NETWORK, deviceCount + 1);
+    return deviceCount++;
+}
+
+bool BACnetRouter::addObject(uint8_t device, uint16_t type, uint32_t instance, const char* name, bool writable,
+                            fixed_t minimum, fixed_t maximum) {
+    if (device >= deviceCount || devices[device].objectCount >= BACNET_VIRTUAL_OBJECT_MAX) return false;
+
+    BACnetVirtualObject& object = devices[device].objects[devices[device].objectCount++];
+    object.instance = instance;
+    object.type = type;
+    strncpy(object.name, name, sizeof(object.name) - 1);
+    object.name[sizeof(object.name) - 1] = '\0';
+    object.present_value = FIXED_INVALID;
+    object.writable = writable;
+    object.minimum = minimum;
+    object.maximum = maximum;
+    return true;
+}
+
+bool BACnetRouter::setPresentValue(uint8_t device, uint16_t type, uint32_t instance, fixed_t value) {
+    BACnetVirtualObject* object = findObject(device, type, instance);
+    if (object == nullptr) return false;
+    object->present_value = value;
+    return true;
+}
+
+void BACnetRouter::onWrite(BACnetVirtualWriteCallback callback) {
+    writeCallback = callback;
+}
+
+void BACnetRouter::printStatus() {
+    if (deviceCount == 0) return;
+    Serial.printf("  Virtual Network %u: %u devices, %lu routed requests, %lu router queries\n", BACNET_VIRTUAL_NETWORK,
+                  deviceCount, (unsigned long)routedRequests, (unsigned long)routerQueries);
+}
+
+uint8_t BACnetRouter::getDeviceCount() {
+    return deviceCount;
+}
+
+BACnetVirtualDevice* BACnetRouter::getDevice(uint8_t index) {
+    return index < deviceCount ? &devices[index] : nullptr;
+}
+
+BACnetVirtualObject* BACnetRouter::findObject(uint8_t device, uint16_t type, uint32_t instance) {
+    if (device >= deviceCount) return nullptr;
+    for (uint8_t i = 0; i < devices[device].objectCount; i++) {
+        BACnetVirtualObject& object = devices[device].objects[i];
+        if (object.type == type && object.instance == instance) {
+            return &object;
+        }
+    }
+    return nullptr;
+}
+
+bool BACnetRouter::writePresentValue(uint8_t device, BACnetVirtualObject* object, fixed_t value) {
+    if (device >= deviceCount || object == nullptr || !object->writable) return false;
+
+    object->present_value = value;
+    if (writeCallback != nullptr) {
+        writeCallback(devices[device].instance, object->type, object->instance, value);
+    }
+    return true;
+}
+
+// Original-Unicast or Original-Broadcast BVLC with an NPDU, length matching the datagram
+bool BACnetRouter::isNetworkFrame(const uint8_t* frame, size_t length) {
+    if (length < 7 || frame[0] != 0x81 || (frame[1] != 0x0A && frame[1] != 0x0B)) return false;
+    return (size_t)((frame[2] << 8) | frame[3]) == length && frame[4] == 0x01;
+}
+
+size_t BACnetRouter::accept(uint8_t* frame, size_t length, BACnetRoute* route, uint8_t* reply, size_t* replyLength) {
+    *replyLength = 0;
+    route->active = false;
+
+    uint8_t control = frame[5];
+    size_t position = 6;
+
+    bool hasDestination = control & NPDU_DESTINATION;
+    uint16_t destinationNetwork = 0;
+    uint8_t destinationLength = 0;
+    uint8_t destinationAddress = 0;
+    if (hasDestination) {
+        if (position + 3 > length) return 0;
+        destinationNetwork = (frame[position] << 8) | frame[position + 1];
+        destinationLength = frame[position + 2];
+        position += 3;
+        if (destinationLength > BACNET_MAX_MAC_LENGTH || position + destinationLength > length) return 0;
+        if (destinationLength == 1) destinationAddress = frame[position];
+        position += destinationLength;
+    }
+
+    route->hasSource = control & NPDU_SOURCE;
+    if (route->hasSource) {
+        if (position + 3 > length) return 0;
+        route->sourceNetwork = (frame[position] << 8) | frame[position + 1];
+        route->sourceLength = frame[position + 2];
+        position += 3;
+        if (route->sourceLength == 0 || route->sourceLength > BACNET_MAX_MAC_LENGTH ||
+            position + route->sourceLength > length) return 0;
+        memcpy(route->sourceAddress, &frame[position], route->sourceLength);
+        position += route->sourceLength;
+    }
+
+    if (hasDestination) position++; // Hop count
+    if (position >= length) return 0;
+
+    if (control & NPDU_NETWORK_MESSAGE) {
+        // With no other ports, router discovery is the only network message that concerns us
+        if (frame[position] == NETWORK_MESSAGE_WHO_IS_ROUTER && deviceCount > 0) {
+            bool anyNetwork = position + 3 > length;
+            if (anyNetwork || ((frame[position + 1] << 8) | frame[position + 2]) == BACNET_VIRTUAL_NETWORK) {
+                routerQueries++;
+                *replyLength = encodeIAmRouter(reply);
+            }
+        }
+        return 0;
+    }
+
+    if (!hasDestination || deviceCount == 0) return 0;
+    if (destinationNetwork != BACNET_VIRTUAL_NETWORK && destinationNetwork != BACNET_GLOBAL_NETWORK) return 0;
+    if (destinationNetwork == BACNET_GLOBAL_NETWORK || destinationLength == 0) {
+        route->device = BACNET_ROUTE_ALL;
+    } else if (destinationLength == 1 && destinationAddress >= 1 && destinationAddress <= deviceCount) {
+        route->device = destinationAddress - 1;
+    } else {
+        return 0;
+    }
+
+    // Confirmed services need a single device to answer
+    uint8_t pduType = frame[position] & 0xF0;
+    if (pduType == 0x00 && route->device == BACNET_ROUTE_ALL) return 0;
+    if (pduType != 0x00 && pduType != 0x10) return 0;
+
+    // This stack frames requests with the PDU type in BVLC byte 1 (0x10 confirmed,
+    // 0x00 unconfirmed) and the rest of the APDU from byte 4
+    size_t apduLength = length - position - 1;
+    memmove(&frame[4], &frame[position + 1], apduLength);
+    frame[1] = pduType == 0x00 ? 0x10 : 0x00;
+    length = 4 + apduLength;
+    frame[2] = (length >> 8) & 0xFF;
+    frame[3] = length & 0xFF;
+
+    route->active = true;
+    routedRequests++;
+    return length;
+}
+
+size_t BACnetRouter::wrap(const uint8_t* frame, size_t length, const BACnetRoute& route, uint8_t device, bool broadcast,
+                          uint8_t* out, size_t outSize) {
+    if (length < 6 || outSize < BACNET_ROUTE_HEADER_MAX) return 0;
+
+    size_t position = 0;
+    out[position++] = 0x81;
+    out[position++] = broadcast ? 0x0B : 0x0A;
+    position += 2; // Length, filled in below
+    out[position++] = 0x01;
+
+    // A request from a remote network is answered through the router it came
+    // from: a reply to the requester itself, a broadcast (the I-Am to a Who-Is)
+    // as a global one, which that router forwards back to the requester's network
+    bool toRemote = route.hasSource;
+    out[position++] = NPDU_SOURCE | (toRemote ? NPDU_DESTINATION : 0);
+    if (toRemote && broadcast) {
+        out[position++] = (BACNET_GLOBAL_NETWORK >> 8) & 0xFF;
+        out[position++] = BACNET_GLOBAL_NETWORK & 0xFF;
+        out[position++] = 0;
+    } else if (toRemote) {
+        out[position++] = (route.sourceNetwork >> 8) & 0xFF;
+        out[position++] = route.sourceNetwork & 0xFF;
+        out[position++] = route.sourceLength;
+        memcpy(&out[position], route.sourceAddress, route.sourceLength);
+        position += route.sourceLength;
+    }
+    out[position++] = (BACNET_VIRTUAL_NETWORK >> 8) & 0xFF;
+    out[position++] = BACNET_VIRTUAL_NETWORK & 0xFF;
+    out[position++] = 1;
+    out[position++] = device + 1;
+    if (toRemote) out[position++] = 0xFF; // Hop count
+
+    size_t apduLength = length - 6;
+    if (position + apduLength > outSize) return 0;
+    memcpy(&out[position], &frame[6], apduLength);
+    position += apduLength;
+
+    out[2] = (position >> 8) & 0xFF;
+    out[3] = position & 0xFF;
+    return position;
+}
+
+size_t BACnetRouter::encodeIAmRouter(uint8_t* out) {
+    const uint8_t frame[] = {
+        0x81, 0x0B, 0x00, 0x09,           // BVLC, Original-Broadcast
+        0x01, NPDU_NETWORK_MESSAGE,       // NPDU
+        NETWORK_MESSAGE_I_AM_ROUTER,
+        (BACNET_VIRTUAL_NETWORK >> 8) & 0xFF, BACNET_VIRTUAL_NETWORK & 0xFF
+    };
+    memcpy(out, frame, sizeof(frame));
+    return sizeof(frame);
+}
@@ -0,0 +1,91 @@
+#ifndef BACNET_ROUTER_H
+#define BACNET_ROUTER_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+#include "../System/FixedPoint.h"
+
+#define BACNET_ROUTE_ALL 0xFF         // Request addressed to every virtual device
+#define BACNET_GLOBAL_NETWORK 0xFFFF
+#define BACNET_MAX_MAC_LENGTH 7
+#define BACNET_ROUTE_HEADER_MAX (6 + 4 + BACNET_MAX_MAC_LENGTH + 4 + 1) // BVLC, NPDU with DNET, SNET and hop count
+
+// Network layer messages
+#define NETWORK_MESSAGE_WHO_IS_ROUTER 0x00
+#define NETWORK_MESSAGE_I_AM_ROUTER 0x01
+
+// A point of a virtual device. Values are owned by the application, which
+// keeps them current; writes to writable points are passed to the callback.
+typedef struct {
+    uint32_t instance;
+    uint16_t type;
+    char name[32];
+    fixed_t present_value;
+    bool writable;
+    fixed_t minimum; // Range a write must fall in
+    fixed_t maximum;
+} BACnetVirtualObject;
+
+// A logical BACnet device hosted behind the virtual network. Its MAC address
+// on that network is its table index plus one.
+typedef struct {
+    uint32_t instance;
+    char name[32];
+    BACnetVirtualObject objects[BACNET_VIRTUAL_OBJECT_MAX];
+    uint8_t objectCount;
+} BACnetVirtualDevice;
+
+// Addressing of the request being served, kept so its reply can be routed back
+typedef struct {
+    bool active;
+    uint8_t device;      // Virtual device index, or BACNET_ROUTE_ALL
+    bool hasSource;      // Arrived from a remote network through another router
+    uint16_t sourceNetwork;
+    uint8_t sourceLength;
+    uint8_t sourceAddress[BACNET_MAX_MAC_LENGTH];
+} BACnetRoute;
+
+// Invoked when a BACnet write changes the value of a virtual device point
+typedef void (*BACnetVirtualWriteCallback)(uint32_t deviceInstance, uint16_t objectType, uint32_t objectInstance, fixed_t value);
+
+// Network layer for the virtual devices. Standard BACnet/IP frames carrying
+// an NPDU are accepted when addressed to BACNET_VIRTUAL_NETWORK; the NPDU is
+// stripped so the APDU goes through the same services and codec as the
+// physical device, and replies get the virtual device's SNET/SADR added.
+// Who-Is-Router-To-Network is answered with I-Am-Router-To-Network.
+class BACnetRouter {
+public:
+    uint8_t addDevice(uint32_t instance, const char* name);
+    bool addObject(uint8_t device, uint16_t type, uint32_t instance, const char* name, bool writable,
+                   fixed_t minimum = FIXED_MIN, fixed_t maximum = FIXED_MAX);
+    bool setPresentValue(uint8_t device, uint16_t type, uint32_t instance, fixed_t value);
+    void onWrite(BACnetVirtualWriteCallback callback);
+    void printStatus();
+
+    uint8_t getDeviceCount();
+    BACnetVirtualDevice* getDevice(uint8_t index);
+    BACnetVirtualObject* findObject(uint8_t device, uint16_t type, uint32_t instance);
+    bool writePresentValue(uint8_t device, BACnetVirtualObject* object, fixed_t value);
+
+    static bool isNetworkFrame(const uint8_t* frame, size_t length);
+
+    // Decodes the NPDU of a standard frame. Frames for the virtual network are
+    // rewritten in place to this stack's request framing and their route filled
+    // in; returns the new length, or 0 when the frame is not for a virtual device.
+    // Router discovery is answered into reply, setting replyLength.
+    size_t accept(uint8_t* frame, size_t length, BACnetRoute* route, uint8_t* reply, size_t* replyLength);
+    // Reframes a reply built for the physical device ("81 0a len 01 00 APDU")
+    // as coming from the routed device; returns the new length
+    size_t wrap(const uint8_t* frame, size_t length, const BACnetRoute& route, uint8_t device, bool broadcast,
+                uint8_t* out, size_t outSize);
+    size_t encodeIAmRouter(uint8_t* out);
+
+private:
+    BACnetVirtualDevice devices[BACNET_VIRTUAL_DEVICE_MAX];
+    uint8_t deviceCount = 0;
+    BACnetVirtualWriteCallback writeCallback = nullptr;
+    uint32_t routedRequests = 0;
+    uint32_t routerQueries = 0;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <Arduino.h>
+#include "ThermostatManager.h"
+#include "../System/StringGuard.h"
+
+// Gains and thresholds from config.h, converted at compile time
+static constexpr fixed_t KP = fixedFromFloat(THERMOSTAT_KP);
+static constexpr fixed_t KI_PER_TICK = fixedFromFloat(THERMOSTAT_KI * (THERMOSTAT_TICK_INTERVAL / 1000.0));
+static constexpr fixed_t DEMAND_ON = fixedFromFloat(THERMOSTAT_DEMAND_ON);
+static constexpr fixed_t DEMAND_OFF = fixedFromFloat(THERMOSTAT_DEMAND_OFF);
+static constexpr fixed_t AUTO_CHANGEOVER = fixedFromFloat(THERMOSTAT_AUTO_CHANGEOVER);
+static constexpr fixed_t SETPOINT_MIN = fixedFromFloat(THERMOSTAT_SETPOINT_MIN);
+static constexpr fixed_t SETPOINT_MAX = fixedFromFloat(THERMOSTAT_SETPOINT_MAX);
+
+static const char* const THERMOSTAT_MODE_NAMES[THERMOSTAT_MODE_COUNT] = {"off", "cool", "heat", "auto"};
+
+void ThermostatManager::begin(ConfigStore* store) {
+    Serial.println("Initializing thermostat control...");
+    configStore = store;
+
+    pinMode(AC_RELAY_BO, OUTPUT);
+    digitalWrite(AC_RELAY_BO, LOW);
+    // Treat the relay as off since boot so a reset cannot short-cycle the compressor
+    lastRelayChange = millis();
+
+    setpoint = fixedFromFloat(configStore->getFloat(CONFIG_KEY_THERMOSTAT_SETPOINT, THERMOSTAT_DEFAULT_SETPOINT));
+    uint32_t storedMode = configStore->getUInt32(CONFIG_KEY_THERMOSTAT_MODE, THERMOSTAT_MODE_OFF);
+    mode = storedMode < THERMOSTAT_MODE_COUNT ? (ThermostatMode)storedMode : THERMOSTAT_MODE_OFF;
+    nextTick = millis();
+
+    Serial.printf("  Mode: %s, Setpoint: %.2f C\n", getModeName(mode), fixedToFloat(setpoint));
+}
+
+void ThermostatManager::handle(fixed_t temperature) {
+    // Fixed-rate ticks: the controller gains assume THERMOSTAT_TICK_INTERVAL
+    // between steps, so late ticks are caught up rather than stretched
+    unsigned long currentTime = millis();
+    uint8_t catchUp = 0;
+    while ((long)(currentTime - nextTick) >= 0 && catchUp++ < THERMOSTAT_MAX_CATCH_UP) {
+        nextTick += THERMOSTAT_TICK_INTERVAL;
+        step(temperature);
+    }
+    if ((long)(currentTime - nextTick) >= 0) {
+        nextTick = currentTime + THERMOSTAT_TICK_INTERVAL;
+    }
+}
+
+void ThermostatManager::step(fixed_t temperature) {
+    if (mode == THERMOSTAT_MODE_OFF || !fixedIsValid(temperature)) {
+        resetController();
+        setRelay(false);
+        return;
+    }
+
+    // Auto picks a direction outside the changeover band and only while the
+    // relay is off, so the compressor never reverses under load
+    bool wantHeating = heating;
+    if (mode == THERMOSTAT_MODE_COOL) {
+        wantHeating = false;
+    } else if (mode == THERMOSTAT_MODE_HEAT) {
+        wantHeating = true;
+    } else if (temperature > setpoint + AUTO_CHANGEOVER) {
+        wantHeating = false;
+    } else if (temperature < setpoint - AUTO_CHANGEOVER) {
+        wantHeating = true;
+    }
+    if (wantHeating != heating) {
+        if (relayOn) {
+            setRelay(false);
+            return;
+        }
+        heating = wantHeating;
+        resetController();
+    }
+
+    // Positive error means the room needs the active direction
+    fixed_t error = heating ? setpoint - temperature : temperature - setpoint;
+    fixed_t proportional = fixedMul(KP, error);
+
+    // Anti-windup: stop integrating once the output is saturated in the error's direction
+    fixed_t unsaturated = proportional + integral;
+    if (!(unsaturated >= FIXED_ONE && error > 0) && !(unsaturated <= 0 && error < 0)) {
+        integral += fixedMul(KI_PER_TICK, error);
+        integral = constrain(integral, (fixed_t)0, FIXED_ONE);
+    }
+    demand = constrain(proportional + integral, (fixed_t)0, FIXED_ONE);
+
+    if (relayOn) {
+        setRelay(demand > DEMAND_OFF);
+    } else {
+        setRelay(demand >= DEMAND_ON);
+    }
+}
+
+void ThermostatManager::resetController() {
+    integral = 0;
+    demand = 0;
+}
+
+void ThermostatManager::setRelay(bool on) {
+    if (on == relayOn) return;
+
+    unsigned long elapsed = millis() - lastRelayChange;
+    if (elapsed < (relayOn ? THERMOSTAT_MIN_ON_TIME : THERMOSTAT_MIN_OFF_TIME)) return;
+
+    relayOn = on;
+    lastRelayChange = millis();
+    digitalWrite(AC_RELAY_BO, relayOn ? HIGH : LOW);
+    Serial.printf("Thermostat: AC %s (demand %.2f)\n", relayOn ? (heating ? "HEATING" : "COOLING") : "OFF",
+                  fixedToFloat(demand));
+}
+
+void ThermostatManager::printStatus() {
+    Serial.println("Thermostat Status:");
+    Serial.printf("  Mode: %s, Setpoint: %.2f C\n", getModeName(mode), fixedToFloat(setpoint));
+    Serial.printf("  Relay: %s, Direction: %s, Demand: %.2f\n", relayOn ? "ON" : "OFF", heating ? "Heat" : "Cool",
+                  fixedToFloat(demand));
+}
+
+void ThermostatManager::setSetpoint(fixed_t value) {
+    setpoint = constrain(value, SETPOINT_MIN, SETPOINT_MAX);
+    // Stored as float so existing configuration records keep their meaning
+    configStore->setFloat(CONFIG_KEY_THERMOSTAT_SETPOINT, fixedToFloat(setpoint));
+}
+
+bool ThermostatManager::setMode(ThermostatMode value) {
+    if (value >= THERMOSTAT_MODE_COUNT) return false;
+    if (value != mode) {
+        mode = value;
+        resetController();
+        configStore->setUInt32(CONFIG_KEY_THERMOSTAT_MODE, mode);
+    }
+    return true;
+}
+
+fixed_t ThermostatManager::getSetpoint() { return setpoint; }
+ThermostatMode ThermostatManager::getMode() { return mode; }
+bool ThermostatManager::isRelayOn() { return relayOn; }
+bool ThermostatManager::isHeating() { return heating; }
+fixed_t ThermostatManager::getDemand() { return demand; }
+
+const char* ThermostatManager::getModeName(ThermostatMode value) {
+    return value < THERMOSTAT_MODE_COUNT ? THERMOSTAT_MODE_NAMES[value] : "unknown";
+}
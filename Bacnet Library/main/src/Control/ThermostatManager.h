@@ -0,0 +1,54 @@
+#ifndef THERMOSTAT_MANAGER_H
+#define THERMOSTAT_MANAGER_H
+
+#include <Arduino.h>
+#include "../config/pins.h"
+#include "../config/config.h"
+#include "../Storage/ConfigStore.h"
+#include "../System/FixedPoint.h"
+
+enum ThermostatMode : uint8_t {
+    THERMOSTAT_MODE_OFF,
+    THERMOSTAT_MODE_COOL,
+    THERMOSTAT_MODE_HEAT,
+    THERMOSTAT_MODE_AUTO,
+    THERMOSTAT_MODE_COUNT
+};
+
+// Closed-loop control of the AC relay from the filtered room temperature.
+// A PI controller turns the temperature error into a 0-1 demand; the relay
+// switches on and off at separate demand thresholds (hysteresis) and never
+// changes state inside the compressor minimum on/off times. The loop runs
+// entirely in Q16.16 fixed point.
+class ThermostatManager {
+public:
+    void begin(ConfigStore* store);
+    void handle(fixed_t temperature);
+    void printStatus();
+
+    void setSetpoint(fixed_t value);
+    bool setMode(ThermostatMode value);
+    fixed_t getSetpoint();
+    ThermostatMode getMode();
+    const char* getModeName(ThermostatMode value);
+    bool isRelayOn();
+    bool isHeating();
+    fixed_t getDemand();
+
+private:
+    ConfigStore* configStore = nullptr;
+    fixed_t setpoint = fixedFromFloat(THERMOSTAT_DEFAULT_SETPOINT);
+    ThermostatMode mode = THERMOSTAT_MODE_OFF;
+    bool heating = false;
+    fixed_t integral = 0;
+    fixed_t demand = 0;
+    bool relayOn = false;
+    unsigned long lastRelayChange = 0;
+    unsigned long nextTick = 0;
+
+    void step(fixed_t temperature);
+    void resetController();
+    void setRelay(bool on);
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <Arduino.h>
+#include "ButtonInput.h"
+#include "../System/StringGuard.h"
+
+void ButtonInput::begin(uint8_t inputPin) {
+    pin = inputPin;
+    pinMode(pin, INPUT_PULLUP);
+    rawLevel = stableLevel = digitalRead(pin);
+    rawChangeTime = millis();
+    attachInterruptArg(digitalPinToInterrupt(pin), onEdge, this, CHANGE);
+}
+
+void IRAM_ATTR ButtonInput::onEdge(void* arg) {
+    ButtonInput* button = (ButtonInput*)arg;
+    uint8_t head = button->queueHead;
+    uint8_t next = (head + 1) & (BUTTON_QUEUE_SIZE - 1);
+
+    // When full, the newest queued edge is replaced rather than this one
+    // dropped, so the level the button settles at is never lost. The
+    // consumer is at the tail, far from that slot.
+    if (next == button->queueTail) {
+        button->droppedEdges++;
+        head = (head - 1) & (BUTTON_QUEUE_SIZE - 1);
+        next = button->queueHead;
+    }
+    button->queue[head].timestamp = millis();
+    button->queue[head].level = digitalRead(button->pin);
+    button->queueHead = next;
+}
+
+ButtonGesture ButtonInput::handle() {
+    ButtonGesture gesture = BUTTON_GESTURE_NONE;
+
+    // Stop at the first gesture; later edges stay queued for the next call
+    while (gesture == BUTTON_GESTURE_NONE && queueTail != queueHead) {
+        uint8_t tail = queueTail;
+        uint32_t timestamp = queue[tail].timestamp;
+        uint8_t level = queue[tail].level;
+        queueTail = (tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+
+        // The level before this edge counts only if it held for the debounce time
+        if (timestamp - rawChangeTime >= DEBOUNCE_DELAY && rawLevel != stableLevel) {
+            gesture = applyStableLevel(rawLevel, rawChangeTime);
+        }
+        if (gesture == BUTTON_GESTURE_NONE) {
+            gesture = checkTimers(timestamp);
+        }
+        if (level != rawLevel) {
+            rawLevel = level;
+            rawChangeTime = timestamp;
+        }
+    }
+
+    if (gesture == BUTTON_GESTURE_NONE) {
+        uint32_t now = millis();
+        if (now - rawChangeTime >= DEBOUNCE_DELAY && rawLevel != stableLevel) {
+            gesture = applyStableLevel(rawLevel, rawChangeTime);
+        }
+        if (gesture == BUTTON_GESTURE_NONE) {
+            gesture = checkTimers(now);
+        }
+    }
+    return gesture;
+}
+
+uint8_t ButtonInput::getClickCount() {
+    return clickCount;
+}
+
+bool ButtonInput::isPressed() {
+    return stableLevel == LOW;
+}
+
+uint32_t ButtonInput::getDroppedEdges() {
+    return droppedEdges;
+}
+
+ButtonGesture ButtonInput::applyStableLevel(uint8_t level, uint32_t timestamp) {
+    stableLevel = level;
+
+    if (level == LOW) {
+        pressTime = timestamp;
+        longPressReported = false;
+        return BUTTON_GESTURE_NONE;
+    }
+
+    // A hold already reported as a long press is not also a click
+    releaseTime = timestamp;
+    if (!longPressReported) {
+        pendingClicks++;
+    }
+    return BUTTON_GESTURE_NONE;
+}
+
+ButtonGesture ButtonInput::checkTimers(uint32_t now) {
+    if (stableLevel == LOW && !longPressReported && now - pressTime >= BUTTON_LONG_PRESS_TIME) {
+        longPressReported = true;
+        pendingClicks = 0;
+        return BUTTON_GESTURE_LONG_PRESS;
+    }
+    if (stableLevel == HIGH && pendingClicks > 0 && now - releaseTime >= BUTTON_MULTI_CLICK_GAP) {
+        clickCount = pendingClicks;
+        pendingClicks = 0;
+        return BUTTON_GESTURE_CLICK;
+    }
+    return BUTTON_GESTURE_NONE;
+}
@@ -0,0 +1,57 @@
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+#define BUTTON_QUEUE_SIZE 16 // Power of two
+
+enum ButtonGesture {
+    BUTTON_GESTURE_NONE,
+    BUTTON_GESTURE_CLICK,     // One or more short presses, see getClickCount()
+    BUTTON_GESTURE_LONG_PRESS // Held for BUTTON_LONG_PRESS_TIME, fires while still held
+};
+
+// Raw edge captured by the interrupt handler
+typedef struct {
+    uint32_t timestamp;
+    uint8_t level;
+} ButtonEdge;
+
+// Active-low push button read through GPIO edge interrupts. The ISR only
+// timestamps edges into a single-producer/single-consumer ring; debounce
+// and gesture decoding run in handle(), replaying edges at their capture
+// time so presses made while loop() was busy are still decoded correctly.
+class ButtonInput {
+public:
+    void begin(uint8_t inputPin);
+    ButtonGesture handle();
+    uint8_t getClickCount();
+    bool isPressed();
+    uint32_t getDroppedEdges();
+
+private:
+    uint8_t pin = 0;
+
+    // Written by the ISR only
+    volatile ButtonEdge queue[BUTTON_QUEUE_SIZE];
+    volatile uint8_t queueHead = 0;
+    volatile uint32_t droppedEdges = 0;
+    // Written by the consumer only
+    volatile uint8_t queueTail = 0;
+
+    uint8_t rawLevel = HIGH;
+    uint32_t rawChangeTime = 0;
+    uint8_t stableLevel = HIGH;
+    uint32_t pressTime = 0;
+    uint32_t releaseTime = 0;
+    bool longPressReported = false;
+    uint8_t pendingClicks = 0;
+    uint8_t clickCount = 0;
+
+    static void IRAM_ATTR onEdge(void* arg);
+    ButtonGesture applyStableLevel(uint8_t level, uint32_t timestamp);
+    ButtonGesture checkTimers(uint32_t now);
+};
+
+#endif
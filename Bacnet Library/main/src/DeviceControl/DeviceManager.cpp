@@ -1,53 +1,56 @@
 #include <Arduino.h>
 #include "DeviceManager.h"
+#include "../System/StringGuard.h"
 
-void DeviceManager::begin() {
+void DeviceManager::begin(ConfigStore* store) {
     Serial.println("Initializing device control hardware...");
+    configStore = store;
     initializePins();
-    setDigitalLed(false);
-    setLEDBrightness(0);
+    fadeTime = configStore->getUInt32(CONFIG_KEY_FADE_TIME, LED_FADE_TIME);
+    dimmer.begin(DIM_LED_AO, 0);
+    
+    // Restore the last commanded outputs so a power blip does not switch loads off;
+    // the dimmer ramps up from dark rather than stepping
+    setDigitalLed(configStore->getUInt32(CONFIG_KEY_OUTPUT_LED, 0) != 0);
+    setLEDBrightness(configStore->getUInt32(CONFIG_KEY_OUTPUT_BRIGHTNESS, 0));
 }
 
 void DeviceManager::initializePins() {
     pinMode(LED_BO, OUTPUT);
     pinMode(DIM_LED_AO, OUTPUT);
-    pinMode(BUTTON_BI, INPUT_PULLUP);
+    button.begin(BUTTON_BI);
     
     digitalWrite(LED_BO, LOW);
-    analogWrite(DIM_LED_AO, 0);
-    
-    analogWriteRange(255);
     analogWriteFreq(1000);
 }
 
+// Single click toggles the LED, double click switches the dimmer between
+// off and full, a long press switches both outputs off
 void DeviceManager::handleButton() {
-    bool currentButtonState = digitalRead(BUTTON_BI);
+    ButtonGesture gesture = button.handle();
     
-    // Detect button press with debounce
-    if (currentButtonState == LOW && lastButtonState == HIGH) {
-        if ((millis() - lastDebounceTime) > DEBOUNCE_DELAY) {
-            Serial.println("Button Press Detected - Processing Toggle Request");
-            
-            // Toggle LED state
-            bool newLedState = !ledState;
-            setDigitalLed(newLedState);
-            
-            Serial.println("Button action completed:");
-            Serial.println("  LED Toggled to: " + String(newLedState ? "ON" : "OFF"));
-            
-            lastDebounceTime = millis();
-        }
+    if (gesture == BUTTON_GESTURE_CLICK && button.getClickCount() == 1) {
+        Serial.println("Button Click Detected - Processing Toggle Request");
+        setDigitalLed(!ledState);
+    } else if (gesture == BUTTON_GESTURE_CLICK && button.getClickCount() == 2) {
+        Serial.println("Button Double Click Detected - Toggling Dimmer");
+        setLEDBrightness(currentBrightness > 0 ? 0 : 255);
+    } else if (gesture == BUTTON_GESTURE_CLICK) {
+        Serial.printf("Button Warning: Ignoring %u clicks\n", button.getClickCount());
+    } else if (gesture == BUTTON_GESTURE_LONG_PRESS) {
+        Serial.println("Button Long Press Detected - Switching Outputs Off");
+        setDigitalLed(false);
+        setLEDBrightness(0);
     }
-    
-    lastButtonState = currentButtonState;
 }
 
 void DeviceManager::setDigitalLed(bool enabled) {
     ledState = enabled;
+    configStore->setUInt32(CONFIG_KEY_OUTPUT_LED, ledState ? 1 : 0);
     digitalWrite(LED_BO, ledState ? HIGH : LOW);
     
     Serial.println("Digital LED state changed:");
-    Serial.println("  Hardware: " + String(enabled ? "ON" : "OFF"));
+    Serial.printf("  Hardware: %s\n", enabled ? "ON" : "OFF");
 }
 
 void DeviceManager::setLEDBrightness(uint8_t brightness) {
@@ -56,15 +59,30 @@ void DeviceManager::setLEDBrightness(uint8_t brightness) {
         Serial.println("Brightness Warning: Value clamped to maximum 255");
     }
     currentBrightness = brightness;
-    analogWrite(DIM_LED_AO, brightness);
-    Serial.println("PWM LED brightness set to: " + String(brightness) + "/255");
+    configStore->setUInt32(CONFIG_KEY_OUTPUT_BRIGHTNESS, brightness);
+    dimmer.fadeTo(brightness, fadeTime);
+    Serial.printf("PWM LED brightness set to: %u/255 over %lu ms\n", brightness, (unsigned long)fadeTime);
 }
 
+void DeviceManager::setFadeTime(uint32_t time) {
+    if (time > LED_FADE_TIME_MAX) time = LED_FADE_TIME_MAX;
+    fadeTime = time;
+    configStore->setUInt32(CONFIG_KEY_FADE_TIME, fadeTime);
+}
+
+uint32_t DeviceManager::getFadeTime() { return fadeTime; }
+
 void DeviceManager::printStatus() {
     Serial.println("Device Control Status:");
-    Serial.println("  Digital LED: " + String(ledState ? "ON" : "OFF"));
-    Serial.println("  Brightness Level: " + String(currentBrightness) + "/255");
+    Serial.printf("  Digital LED: %s\n", ledState ? "ON" : "OFF");
+    Serial.printf("  Brightness Level: %u/255\n", currentBrightness);
+    Serial.printf("  Button: %s (%lu edges dropped)\n", button.isPressed() ? "PRESSED" : "RELEASED",
+                  (unsigned long)button.getDroppedEdges());
+    if (dimmer.isFading()) {
+        Serial.printf("  Dimmer: Fading, currently %u/255\n", dimmer.getLevel());
+    }
 }
 
 bool DeviceManager::getLedState() { return ledState; }
+bool DeviceManager::isButtonPressed() { return button.isPressed(); }
 uint8_t DeviceManager::getCurrentBrightness() { return currentBrightness; }
\ No newline at end of file
@@ -4,22 +4,30 @@
 #include <Arduino.h> 
 #include "../config/pins.h"
 #include "../config/config.h"
+#include "../Storage/ConfigStore.h"
+#include <FadeEngine.h> // Shared with the demo, from the BACnet_ESP8266 library
+#include "ButtonInput.h"
 
 class DeviceManager {
 public:
-    void begin();
+    void begin(ConfigStore* store);
     void handleButton();
     void printStatus();
     void setDigitalLed(bool on);
     void setLEDBrightness(uint8_t brightness);
+    void setFadeTime(uint32_t fadeTime);
+    uint32_t getFadeTime();
     bool getLedState();
+    bool isButtonPressed();
     uint8_t getCurrentBrightness();
 
 private:
     bool ledState = false;
-    bool lastButtonState = HIGH;
     uint8_t currentBrightness = 0;
-    unsigned long lastDebounceTime = 0;
+    uint32_t fadeTime = LED_FADE_TIME;
+    FadeEngine dimmer;
+    ButtonInput button;
+    ConfigStore* configStore = nullptr;
     
     void initializePins();
 };
@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include "CloudJournal.h"
+#include "../System/StringGuard.h"
+
+void CloudJournal::begin() {
+    Serial.println("Initializing cloud journal...");
+    memset(&header, 0, sizeof(JournalHeader));
+
+    if (!mountStorage()) {
+        Serial.printf("Cloud Journal Warning: No flash, keeping the newest %u entries in RAM\n", CLOUD_JOURNAL_RAM_ENTRIES);
+        return;
+    }
+    storageReady = true;
+
+    File journalFile = LittleFS.open(CLOUD_JOURNAL_PATH, "r");
+    if (journalFile) {
+        bool valid = journalFile.read((uint8_t*)&header, sizeof(JournalHeader)) == sizeof(JournalHeader) &&
+                     header.magic == CLOUD_JOURNAL_MAGIC && header.capacity == CLOUD_JOURNAL_FLASH_ENTRIES &&
+                     header.head < CLOUD_JOURNAL_FLASH_ENTRIES && header.count <= CLOUD_JOURNAL_FLASH_ENTRIES &&
+                     journalFile.size() >= sizeof(JournalHeader) + (size_t)header.count * sizeof(JournalEntry);
+        journalFile.close();
+        if (!valid) {
+            Serial.println("Cloud Journal Warning: Discarding unreadable journal");
+            memset(&header, 0, sizeof(JournalHeader));
+        }
+    }
+    header.magic = CLOUD_JOURNAL_MAGIC;
+    header.capacity = CLOUD_JOURNAL_FLASH_ENTRIES;
+    nextSequence = header.lastSequence + 1;
+
+    if (header.count > 0) {
+        Serial.printf("  %lu unsent entries restored\n", (unsigned long)header.count);
+    }
+}
+
+void CloudJournal::printStatus() {
+    Serial.println("Cloud Journal Status:");
+    Serial.printf("  Pending: %lu entries (%u in RAM), %lu dropped\n", (unsigned long)getCount(), tailCount,
+                  (unsigned long)droppedCount);
+}
+
+void CloudJournal::append(JournalField field, float value, uint32_t timestamp) {
+    if (tailCount >= CLOUD_JOURNAL_RAM_ENTRIES && !spill()) {
+        // Without flash the oldest RAM entry makes room
+        memmove(&tail[0], &tail[1], sizeof(JournalEntry) * (CLOUD_JOURNAL_RAM_ENTRIES - 1));
+        tailCount--;
+        droppedCount++;
+    }
+
+    JournalEntry& entry = tail[tailCount++];
+    memset(&entry, 0, sizeof(JournalEntry));
+    entry.sequence = nextSequence++;
+    entry.timestamp = timestamp;
+    entry.value = value;
+    entry.field = field;
+}
+
+bool CloudJournal::isEmpty() {
+    return tailCount == 0 && header.count == 0;
+}
+
+uint32_t CloudJournal::getCount() {
+    return tailCount + header.count;
+}
+
+uint8_t CloudJournal::compact(JournalEntry* latest) {
+    const uint8_t allFields = (1 << JOURNAL_FIELD_COUNT) - 1;
+    uint8_t present = 0;
+
+    // Newest first, keeping the first entry seen per field, and stopping as
+    // soon as every field has one: usually after a few entries, not the ring
+    for (int i = tailCount - 1; i >= 0 && present != allFields; i--) {
+        if (present & (1 << tail[i].field)) continue;
+        latest[tail[i].field] = tail[i];
+        present |= 1 << tail[i].field;
+    }
+    if (present == allFields || header.count == 0) return present;
+
+    File journalFile = LittleFS.open(CLOUD_JOURNAL_PATH, "r");
+    if (!journalFile) return present;
+
+    JournalEntry entry;
+    for (uint16_t i = 1; i <= header.count && present != allFields; i++) {
+        uint16_t position = (header.head + CLOUD_JOURNAL_FLASH_ENTRIES - i) % CLOUD_JOURNAL_FLASH_ENTRIES;
+        journalFile.seek(sizeof(JournalHeader) + position * sizeof(JournalEntry), SeekSet);
+        if (journalFile.read((uint8_t*)&entry, sizeof(JournalEntry)) != sizeof(JournalEntry)) break;
+        if (entry.field >= JOURNAL_FIELD_COUNT || (present & (1 << entry.field))) continue;
+        latest[entry.field] = entry;
+        present |= 1 << entry.field;
+    }
+    journalFile.close();
+    return present;
+}
+
+void CloudJournal::clear() {
+    tailCount = 0;
+    if (header.count == 0) return;
+
+    header.count = 0;
+    File journalFile = LittleFS.open(CLOUD_JOURNAL_PATH, "r+");
+    if (journalFile) {
+        writeHeader(journalFile, header);
+        journalFile.close();
+    }
+}
+
+// Moves the RAM entries into the flash ring, overwriting the oldest when full.
+// The header in RAM only advances once the entries and the header are on
+// flash; on failure the RAM tail is kept and the next spill rewrites the same slots.
+bool CloudJournal::spill() {
+    if (!storageReady) return false;
+
+    bool created = !LittleFS.exists(CLOUD_JOURNAL_PATH);
+    File journalFile = LittleFS.open(CLOUD_JOURNAL_PATH, created ? "w+" : "r+");
+    if (!journalFile) {
+        Serial.println("Cloud Journal Error: Unable to open " CLOUD_JOURNAL_PATH);
+        return false;
+    }
+
+    JournalHeader updated = header;
+    bool written = true;
+    if (created) {
+        // The ring grows from an empty file, so the header must exist before the first entry
+        updated.head = 0;
+        updated.count = 0;
+        written = writeHeader(journalFile, updated);
+    }
+
+    uint8_t spilled = 0;
+    while (written && spilled < tailCount) {
+        uint32_t run = CLOUD_JOURNAL_FLASH_ENTRIES - updated.head;
+        if (run > (uint32_t)(tailCount - spilled)) run = tailCount - spilled;
+
+        size_t bytes = run * sizeof(JournalEntry);
+        written = journalFile.seek(sizeof(JournalHeader) + updated.head * sizeof(JournalEntry), SeekSet) &&
+                  journalFile.write((const uint8_t*)&tail[spilled], bytes) == bytes;
+        updated.head = (updated.head + run) % CLOUD_JOURNAL_FLASH_ENTRIES;
+        spilled += run;
+    }
+
+    uint32_t total = (uint32_t)updated.count + tailCount;
+    uint32_t overwritten = 0;
+    if (total > CLOUD_JOURNAL_FLASH_ENTRIES) {
+        overwritten = total - CLOUD_JOURNAL_FLASH_ENTRIES;
+        total = CLOUD_JOURNAL_FLASH_ENTRIES;
+    }
+    updated.count = total;
+    updated.lastSequence = tail[tailCount - 1].sequence;
+
+    // Header last: an interrupted spill leaves the old head and count, so the
+    // new entries stay hidden. In a full ring they may already have replaced
+    // some of the oldest entries.
+    written = written && writeHeader(journalFile, updated);
+    journalFile.close();
+
+    if (!written) {
+        // A new file holds nothing else, so it is created again next time
+        if (created) LittleFS.remove(CLOUD_JOURNAL_PATH);
+        Serial.printf("Cloud Journal Error: Short write to " CLOUD_JOURNAL_PATH ", %u entries kept in RAM\n", tailCount);
+        return false;
+    }
+    header = updated;
+    droppedCount += overwritten;
+    tailCount = 0;
+    return true;
+}
+
+bool CloudJournal::writeHeader(File& file, const JournalHeader& value) {
+    return file.seek(0, SeekSet) && file.write((const uint8_t*)&value, sizeof(JournalHeader)) == sizeof(JournalHeader);
+}
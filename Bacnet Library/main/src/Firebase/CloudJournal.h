@@ -0,0 +1,66 @@
+#ifndef CLOUD_JOURNAL_H
+#define CLOUD_JOURNAL_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "../config/config.h"
+#include "../Storage/Storage.h"
+
+#define CLOUD_JOURNAL_PATH "/journal.bin"
+#define CLOUD_JOURNAL_MAGIC 0x4A524E4C // "JRNL"
+
+// Values the journal carries; each maps to one field of a database node
+enum JournalField : uint8_t {
+    JOURNAL_FIELD_TEMPERATURE,
+    JOURNAL_FIELD_HUMIDITY,
+    JOURNAL_FIELD_COUNT
+};
+
+// Fixed-size journal entry as stored in flash (16 bytes)
+typedef struct {
+    uint32_t sequence;
+    uint32_t timestamp; // Epoch seconds, 0 if the clock was not set
+    float value;
+    uint8_t field;
+    uint8_t reserved[3];
+} JournalEntry;
+
+// Ring header at the start of the journal file
+typedef struct {
+    uint32_t magic;
+    uint16_t capacity;
+    uint16_t head;
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t lastSequence;
+} JournalHeader;
+
+// Append-only log of cloud writes that have not been sent yet. Entries
+// collect in RAM and spill to a flash ring when the RAM buffer fills, so an
+// outage survives a reboot. When the ring is full the oldest entry is
+// overwritten. Replay only needs the newest value of each field.
+class CloudJournal {
+public:
+    void begin();
+    void printStatus();
+
+    void append(JournalField field, float value, uint32_t timestamp);
+    bool isEmpty();
+    uint32_t getCount();
+    // Fills latest[] with the newest entry per field; returns a bit per field present
+    uint8_t compact(JournalEntry* latest);
+    void clear();
+
+private:
+    JournalHeader header;
+    JournalEntry tail[CLOUD_JOURNAL_RAM_ENTRIES];
+    uint8_t tailCount = 0;
+    bool storageReady = false;
+    uint32_t nextSequence = 1;
+    uint32_t droppedCount = 0;
+
+    bool spill();
+    bool writeHeader(File& file, const JournalHeader& value);
+};
+
+#endif
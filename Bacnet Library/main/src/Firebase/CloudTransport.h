@@ -0,0 +1,17 @@
+#ifndef CLOUD_TRANSPORT_H
+#define CLOUD_TRANSPORT_H
+
+#include "../config/config.h"
+
+// The cloud sync built into the sketch, chosen with CLOUD_TRANSPORT in
+// config.h. Both managers expose the same public interface, so device logic
+// only ever talks to a CloudTransport.
+#if CLOUD_TRANSPORT == CLOUD_TRANSPORT_MQTT
+#include "MqttManager.h"
+typedef MqttManager CloudTransport;
+#else
+#include "FirebaseManager.h"
+typedef FirebaseManager CloudTransport;
+#endif
+
+#endif
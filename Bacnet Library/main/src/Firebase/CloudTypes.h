@@ -0,0 +1,15 @@
+#ifndef CLOUD_TYPES_H
+#define CLOUD_TYPES_H
+
+#include <Arduino.h>
+
+// Device values mirrored by every cloud transport
+enum CloudPoint : uint8_t {
+    CLOUD_POINT_BRIGHTNESS,
+    CLOUD_POINT_DIGITAL_LED,
+    CLOUD_POINT_COUNT
+};
+
+typedef void (*CloudValueCallback)(CloudPoint point, float value);
+
+#endif
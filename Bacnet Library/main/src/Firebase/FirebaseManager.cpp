@@ -1,5 +1,11 @@
+#include "../config/config.h"
+#if CLOUD_TRANSPORT == CLOUD_TRANSPORT_FIREBASE
 #include "FirebaseManager.h"
 #include <Arduino.h>
+#include "../System/StringGuard.h"
+
+// Field of the sensor node each journal field is written to
+static const char* const journalFieldNames[JOURNAL_FIELD_COUNT] = {"temperature", "humidity"};
 
 void FirebaseManager::begin() {
     Serial.println("Initializing Firebase Cloud Service");
@@ -7,213 +13,279 @@ void FirebaseManager::begin() {
     fbConfig.database_url = FIREBASE_DB_URL;
     fbConfig.signer.tokens.legacy_token = FIREBASE_AUTH;
     Firebase.begin(&fbConfig, &fbAuth);
-    Firebase.reconnectWiFi(true);
+    // Reconnection is owned by WiFiManager
+    Firebase.reconnectWiFi(false);
     
-    fbdo.setBSSLBufferSize(1024, 1024);
-    fbdo.setResponseSize(1024);
+    // One FirebaseData object carries every request, so they all share one
+    // TLS connection; keepalive probes stop it being dropped between polls
+    fbdo.setBSSLBufferSize(FIREBASE_SSL_RX_BUFFER, FIREBASE_SSL_TX_BUFFER);
+    fbdo.setResponseSize(FIREBASE_RESPONSE_SIZE);
+    fbdo.keepAlive(FIREBASE_KEEPALIVE_IDLE, FIREBASE_KEEPALIVE_INTERVAL, FIREBASE_KEEPALIVE_COUNT);
+    metricsWindowStart = millis();
     
+    started = true;
     Serial.println("Firebase Service Initialized Successfully");
 }
 
-void FirebaseManager::syncInitialData() {
-    Serial.println("Performing initial data synchronization...");
-    fetchBrightness();
-    fetchDigitalLed();
+void FirebaseManager::handle() {
+    switch (syncState) {
+        case CLOUD_STATE_IDLE:
+            break;
+        case CLOUD_STATE_SYNC_BRIGHTNESS:
+            if (!started) {
+                // Deferred until the first link-up so boot is not held up by cloud setup
+                begin();
+                return;
+            }
+            Serial.println("Performing initial data synchronization...");
+            fetchPoint(CLOUD_POINT_BRIGHTNESS);
+            syncState = CLOUD_STATE_SYNC_DIGITAL_LED;
+            break;
+        case CLOUD_STATE_SYNC_DIGITAL_LED:
+            fetchPoint(CLOUD_POINT_DIGITAL_LED);
+            lastFirebasePoll = millis();
+            initialSyncComplete = true;
+            syncState = CLOUD_STATE_POLLING;
+            break;
+        case CLOUD_STATE_POLLING:
+            syncData();
+            break;
+    }
 }
 
-void FirebaseManager::syncData() {
-    unsigned long currentTime = millis();
-    
-    if (currentTime - lastFirebasePoll >= FIREBASE_POLL_INTERVAL) {
-        lastFirebasePoll = currentTime;
-        fetchBrightness();
-        fetchDigitalLed();
-    }
+void FirebaseManager::requestInitialSync() {
+    syncState = CLOUD_STATE_SYNC_BRIGHTNESS;
 }
 
-void FirebaseManager::fetchBrightness() {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for brightness fetch");
-        return;
-    }
-    
-    Serial.println("Fetching brightness level from Firebase...");
-    
-    if (Firebase.getInt(fbdo, PATH_BRIGHTNESS)) {
-        int brightnessValue = fbdo.intData();
-        Serial.println("Raw brightness value received: " + String(brightnessValue));
-        
-    } else {
-        Serial.println("Firebase Error: Failed to read brightness value");
-    }
+bool FirebaseManager::isInitialSyncComplete() {
+    return initialSyncComplete;
 }
 
-void FirebaseManager::fetchDigitalLed() {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for LED state fetch");
+void FirebaseManager::reportLocal(CloudPoint point, float value) {
+    CloudPointState& state = points[point];
+    if (value == state.localValue) return;
+    
+    bool baseline = isnan(state.localValue);
+    state.localValue = value;
+    // The state restored at boot is not a new command; the initial sync decides between it and the cloud
+    if (baseline) return;
+    
+    if (value == state.cloudValue) {
+        state.dirty = false; // Changed back before it was sent
         return;
     }
-
-    Serial.println("Fetching digital LED state from Firebase...");
-
-    if (Firebase.getBool(fbdo, PATH_DIGITAL_LED)) {
-        bool remoteLedState = fbdo.boolData();
-        Serial.println("Remote LED state received: " + String(remoteLedState ? "ON" : "OFF"));
-        // This would typically call a callback to update the device
-    } else {
-        Serial.println("Firebase Error: Failed to read LED state");
+    unsigned long currentTime = millis();
+    if (!state.dirty) {
+        state.dirty = true;
+        state.firstChange = currentTime;
     }
+    state.lastChange = currentTime;
 }
 
-void FirebaseManager::writeDigitalLed(bool state) {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for LED state write");
+void FirebaseManager::onRemoteChange(CloudValueCallback callback) {
+    remoteCallback = callback;
+}
+
+// At most one request per pass: a due local write goes first, then the next poll read
+void FirebaseManager::syncData() {
+    unsigned long currentTime = millis();
+    
+    for (uint8_t i = 0; i < CLOUD_POINT_COUNT; i++) {
+        CloudPointState& state = points[i];
+        // Rapid changes are coalesced into one write once they settle
+        if (state.dirty && (currentTime - state.lastChange >= CLOUD_WRITE_COALESCE_TIME ||
+                            currentTime - state.firstChange >= CLOUD_WRITE_MAX_DELAY)) {
+            writePoint((CloudPoint)i);
+            return;
+        }
+    }
+    
+    if (journal != nullptr && !journal->isEmpty() && isReady() &&
+        currentTime - lastReplayAttempt >= CLOUD_JOURNAL_RETRY_INTERVAL) {
+        replayJournal();
         return;
     }
-
-    Serial.println("Writing LED state to Firebase: " + String(state ? "ON" : "OFF"));
-
-    if (Firebase.setBool(fbdo, PATH_DIGITAL_LED, state)) {
-        Serial.println("LED state successfully synchronized with Firebase");
-    } else {
-        Serial.println("Firebase Error: Failed to write LED state");
+    
+    if (pollIndex == 0) {
+        if (currentTime - lastFirebasePoll < FIREBASE_POLL_INTERVAL) return;
+        lastFirebasePoll = currentTime;
     }
+    fetchPoint((CloudPoint)pollIndex);
+    pollIndex = (pollIndex + 1) % CLOUD_POINT_COUNT;
 }
 
-void FirebaseManager::uploadSensorData(float temperature, float humidity) {
+void FirebaseManager::fetchPoint(CloudPoint point) {
+    CloudPointState& state = points[point];
     if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for sensor data upload");
+        Serial.printf("Firebase Warning: Service not ready to read %s\n", state.path);
         return;
     }
     
-    Serial.println("Uploading sensor data to Firebase...");
+    bool wasConnected = fbdo.httpConnected();
+    unsigned long startMicros = micros();
+    bool success = state.isBool ? Firebase.getBool(fbdo, state.path) : Firebase.getInt(fbdo, state.path);
+    recordOperation(wasConnected, startMicros, success);
     
-    FirebaseJson sensorData;
-    sensorData.set("temperature", temperature);
-    sensorData.set("humidity", humidity);
-
-    if (Firebase.updateNode(fbdo, PATH_SENSOR, sensorData)) {
-        Serial.println("Sensor data successfully uploaded to Firebase");
-    } else {
-        Serial.println("Firebase Error: Failed to upload sensor data");
+    if (!success) {
+        Serial.printf("Firebase Error: Failed to read %s\n", state.path);
+        Serial.printf("Error Reason: %s\n", fbdo.errorReason().c_str());
+        return;
     }
-}
-
-void FirebaseManager::printStatus() {
-    Serial.println("Firebase Status:");
-    Serial.println("  Connection: " + String(isReady() ? "Ready" : "Not Ready"));
-}
-
-bool FirebaseManager::isReady() {
-    return Firebase.ready();
-}#include "FirebaseManager.h"
-
-void FirebaseManager::begin() {
-    Serial.println("Initializing Firebase Cloud Service");
     
-    fbConfig.database_url = FIREBASE_DB_URL;
-    fbConfig.signer.tokens.legacy_token = FIREBASE_AUTH;
-    Firebase.begin(&fbConfig, &fbAuth);
-    Firebase.reconnectWiFi(true);
+    float remote = state.isBool ? (fbdo.boolData() ? 1 : 0) : fbdo.intData();
+    unsigned long currentTime = millis();
+    unsigned long previousRead = state.lastRead;
+    bool wasKnown = !isnan(state.cloudValue);
+    state.lastRead = currentTime;
     
-    fbdo.setBSSLBufferSize(1024, 1024);
-    fbdo.setResponseSize(1024);
+    // Unchanged, which includes reading back the device's own last write
+    if (remote == state.cloudValue) return;
+    state.cloudValue = remote;
     
-    Serial.println("Firebase Service Initialized Successfully");
-}
-
-void FirebaseManager::syncData() {
-    unsigned long currentTime = millis();
+    if (remote == state.localValue) {
+        state.dirty = false;
+        return;
+    }
+    if (state.dirty) {
+        // Last writer wins. The remote write happened some time after the
+        // previous read, so it is taken to be halfway between the two reads.
+        unsigned long remoteTime = previousRead + (currentTime - previousRead) / 2;
+        if (!wasKnown || (long)(state.lastChange - remoteTime) > 0) {
+            Serial.printf("Cloud Conflict: Keeping newer local value for %s\n", state.path);
+            return;
+        }
+        state.dirty = false;
+    }
     
-    if (currentTime - lastFirebasePoll >= FIREBASE_POLL_INTERVAL) {
-        lastFirebasePoll = currentTime;
-        fetchBrightness();
-        fetchDigitalLed();
+    Serial.printf("Cloud Change: %s = %.2f\n", state.path, remote);
+    state.localValue = remote;
+    if (remoteCallback != nullptr) {
+        remoteCallback(point, remote);
     }
 }
 
-void FirebaseManager::fetchBrightness() {
+void FirebaseManager::writePoint(CloudPoint point) {
+    CloudPointState& state = points[point];
+    if (state.localValue == state.cloudValue) {
+        state.dirty = false;
+        return;
+    }
     if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for brightness fetch");
+        // Keep the change and retry after another coalescing period
+        state.firstChange = state.lastChange = millis();
         return;
     }
     
-    Serial.println("Fetching brightness level from Firebase...");
+    Serial.printf("Writing %s to Firebase: %.2f\n", state.path, state.localValue);
+    
+    bool wasConnected = fbdo.httpConnected();
+    unsigned long startMicros = micros();
+    bool success = state.isBool ? Firebase.setBool(fbdo, state.path, state.localValue != 0)
+                                : Firebase.setInt(fbdo, state.path, (int)state.localValue);
+    recordOperation(wasConnected, startMicros, success);
     
-    if (Firebase.getInt(fbdo, PATH_BRIGHTNESS)) {
-        int brightnessValue = fbdo.intData();
-        Serial.println("Raw brightness value received: " + String(brightnessValue));
-        
+    if (success) {
+        state.cloudValue = state.localValue;
+        state.lastRead = millis();
+        state.dirty = false;
     } else {
-        Serial.println("Firebase Error: Failed to read brightness value");
-        Serial.println("Error Reason: " + String(fbdo.errorReason().c_str()));
+        Serial.printf("Firebase Error: Failed to write %s\n", state.path);
+        Serial.printf("Error Reason: %s\n", fbdo.errorReason().c_str());
+        state.firstChange = state.lastChange = millis();
     }
 }
 
-void FirebaseManager::fetchDigitalLed() {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for LED state fetch");
-        return;
-    }
-
-    Serial.println("Fetching digital LED state from Firebase...");
-
-    if (Firebase.getBool(fbdo, PATH_DIGITAL_LED)) {
-        bool remoteLedState = fbdo.boolData();
-        Serial.println("Remote LED state received: " + String(remoteLedState ? "ON" : "OFF"));
-    } else {
-        Serial.println("Firebase Error: Failed to read LED state");
-        Serial.println("Error Reason: " + String(fbdo.errorReason().c_str()));
-    }
+void FirebaseManager::setJournal(CloudJournal* cloudJournal) {
+    journal = cloudJournal;
 }
 
-void FirebaseManager::writeDigitalLed(bool state) {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for LED state write");
-        return;
-    }
-
-    Serial.println("Writing LED state to Firebase: " + String(state ? "ON" : "OFF"));
-
-    if (Firebase.setBool(fbdo, PATH_DIGITAL_LED, state)) {
-        Serial.println("LED state successfully synchronized with Firebase");
-    } else {
-        Serial.println("Firebase Error: Failed to write LED state");
-        Serial.println("Error Reason: " + String(fbdo.errorReason().c_str()));
-    }
+// Readings always go through the journal; the next sync pass sends them
+void FirebaseManager::recordSensorData(float temperature, float humidity, uint32_t timestamp) {
+    if (journal == nullptr) return;
+    if (!isnan(temperature)) journal->append(JOURNAL_FIELD_TEMPERATURE, temperature, timestamp);
+    if (!isnan(humidity)) journal->append(JOURNAL_FIELD_HUMIDITY, humidity, timestamp);
 }
 
-void FirebaseManager::uploadSensorData(float temperature, float humidity) {
-    if (!isReady()) {
-        Serial.println("Firebase Warning: Service not ready for sensor data upload");
-        return;
-    }
+// Sends the newest journaled value of every field in a single update of the
+// sensor node, however many readings built up while the cloud was unreachable
+void FirebaseManager::replayJournal() {
+    lastReplayAttempt = millis();
     
-    Serial.println("Uploading sensor data to Firebase...");
+    JournalEntry latest[JOURNAL_FIELD_COUNT];
+    uint8_t present = journal->compact(latest);
+    uint32_t entryCount = journal->getCount();
     
     FirebaseJson sensorData;
-    if (!isnan(temperature)) {
-        sensorData.set("temperature", temperature);
-        Serial.println("  Temperature data prepared: " + String(temperature) + " C");
+    uint32_t timestamp = 0;
+    for (uint8_t i = 0; i < JOURNAL_FIELD_COUNT; i++) {
+        if (!(present & (1 << i))) continue;
+        sensorData.set(journalFieldNames[i], latest[i].value);
+        if (latest[i].timestamp > timestamp) timestamp = latest[i].timestamp;
     }
-    if (!isnan(humidity)) {
-        sensorData.set("humidity", humidity);
-        Serial.println("  Humidity data prepared: " + String(humidity) + " %");
+    if (timestamp != 0) {
+        sensorData.set("timestamp", (int)timestamp);
     }
-
-    if (Firebase.updateNode(fbdo, PATH_SENSOR, sensorData)) {
-        Serial.println("Sensor data successfully uploaded to Firebase");
+    
+    bool wasConnected = fbdo.httpConnected();
+    unsigned long startMicros = micros();
+    bool success = present == 0 || Firebase.updateNode(fbdo, PATH_SENSOR, sensorData);
+    if (present != 0) recordOperation(wasConnected, startMicros, success);
+    
+    if (success) {
+        journal->clear();
+        Serial.printf("Sensor data uploaded to Firebase (%lu journal entries)\n", (unsigned long)entryCount);
     } else {
-        Serial.println("Firebase Error: Failed to upload sensor data");
-        Serial.println("Error Reason: " + String(fbdo.errorReason().c_str()));
+        Serial.printf("Firebase Error: Failed to upload sensor data, %lu entries kept\n", (unsigned long)entryCount);
+        Serial.printf("Error Reason: %s\n", fbdo.errorReason().c_str());
     }
 }
 
 void FirebaseManager::printStatus() {
     Serial.println("Firebase Status:");
-    Serial.println("  Connection: " + String(isReady() ? "Ready" : "Not Ready"));
+    Serial.printf("  Connection: %s\n", isReady() ? "Ready" : "Not Ready");
+    if (metrics.operations == 0) return;
+    
+    uint32_t reused = metrics.operations - metrics.handshakes;
+    Serial.printf("  Requests: %lu (%lu failed), %lu bytes per response, largest %lu\n", (unsigned long)metrics.operations,
+                  (unsigned long)metrics.failures, (unsigned long)(metrics.responseBytes / metrics.operations),
+                  (unsigned long)metrics.largestResponse);
+    Serial.printf("  TLS Handshakes: %lu total, %lu in the last hour, %lu this hour\n", (unsigned long)metrics.handshakes,
+                  (unsigned long)handshakesLastHour, (unsigned long)windowHandshakes);
+    if (metrics.handshakes > 0) {
+        Serial.printf("  Request Time With Handshake: %lu ms\n", (unsigned long)(metrics.handshakeMicros / metrics.handshakes / 1000));
+    }
+    if (reused > 0) {
+        Serial.printf("  Request Time On Open Connection: %lu ms\n", (unsigned long)(metrics.reuseMicros / reused / 1000));
+    }
+}
+
+void FirebaseManager::recordOperation(bool wasConnected, unsigned long startMicros, bool success) {
+    unsigned long elapsed = micros() - startMicros;
+    
+    metrics.operations++;
+    if (!success) metrics.failures++;
+    if (wasConnected) {
+        metrics.reuseMicros += elapsed;
+    } else {
+        metrics.handshakes++;
+        metrics.handshakeMicros += elapsed;
+        windowHandshakes++;
+    }
+    if (success) {
+        uint32_t length = fbdo.payloadLength();
+        metrics.responseBytes += length;
+        if (length > metrics.largestResponse) metrics.largestResponse = length;
+    }
+    
+    if (millis() - metricsWindowStart >= CLOUD_METRICS_WINDOW) {
+        metricsWindowStart = millis();
+        handshakesLastHour = windowHandshakes;
+        windowHandshakes = 0;
+    }
 }
 
 bool FirebaseManager::isReady() {
     return Firebase.ready();
-}
\ No newline at end of file
+}
+
+#endif
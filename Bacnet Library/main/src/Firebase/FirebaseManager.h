@@ -5,25 +5,85 @@
 #include <Arduino.h>
 #include "../config/credentials.h"
 #include "../config/config.h"
+#include "CloudTypes.h"
+#include "CloudJournal.h"
 
+// Cloud work is spread over loop passes so each pass does at most one request
+enum CloudSyncState {
+    CLOUD_STATE_IDLE,
+    CLOUD_STATE_SYNC_BRIGHTNESS,
+    CLOUD_STATE_SYNC_DIGITAL_LED,
+    CLOUD_STATE_POLLING
+};
+
+// A device value mirrored at one database path
+typedef struct {
+    const char* path;
+    bool isBool;
+    float localValue;          // Last value reported by the device, NAN before the first report
+    float cloudValue;          // Last value read from or written to the database, NAN if unknown
+    bool dirty;                // Local change not yet written
+    unsigned long firstChange; // First and latest unsent local change
+    unsigned long lastChange;
+    unsigned long lastRead;    // When cloudValue was last confirmed
+} CloudPointState;
+
+// Request statistics for the cloud connection. A handshake is counted for
+// every request that found the TLS connection closed and had to open it again.
+typedef struct {
+    uint32_t operations;
+    uint32_t failures;
+    uint32_t handshakes;
+    uint32_t responseBytes;
+    uint32_t largestResponse;
+    uint64_t reuseMicros;     // Total time of requests on an open connection; 32 bits wrap after 71 minutes
+    uint64_t handshakeMicros; // Total time of requests that opened one
+} CloudMetrics;
+
+// Two-way sync of device values with the database. Local changes are
+// reported every loop pass, coalesced and written only when they differ from
+// the database. Remote changes found by polling are passed to the callback.
+// A read that returns the device's own write is not treated as a command.
 class FirebaseManager {
 public:
     void begin();
-    void syncInitialData();
+    void handle();
+    void requestInitialSync();
+    bool isInitialSyncComplete();
     void syncData();
     void printStatus();
     bool isReady();
     
-    void fetchBrightness();
-    void fetchDigitalLed();
-    void writeDigitalLed(bool state);
-    void uploadSensorData(float temperature, float humidity);
+    void reportLocal(CloudPoint point, float value);
+    void onRemoteChange(CloudValueCallback callback);
+    void setJournal(CloudJournal* cloudJournal);
+    void recordSensorData(float temperature, float humidity, uint32_t timestamp);
 
 private:
     FirebaseData fbdo;
     FirebaseConfig fbConfig;
     FirebaseAuth fbAuth;
     unsigned long lastFirebasePoll = 0;
+    CloudSyncState syncState = CLOUD_STATE_IDLE;
+    bool started = false;
+    bool initialSyncComplete = false;
+    CloudPointState points[CLOUD_POINT_COUNT] = {
+        {PATH_BRIGHTNESS, false, NAN, NAN},
+        {PATH_DIGITAL_LED, true, NAN, NAN}
+    };
+    uint8_t pollIndex = 0;
+    CloudValueCallback remoteCallback = nullptr;
+    CloudJournal* journal = nullptr;
+    unsigned long lastReplayAttempt = 0;
+    CloudMetrics metrics = {0};
+    unsigned long metricsWindowStart = 0;
+    uint32_t windowHandshakes = 0;
+    uint32_t handshakesLastHour = 0;
+    
+    void fetchPoint(CloudPoint point);
+    void writePoint(CloudPoint point);
+    void replayJournal();
+    void recordOperation(bool wasConnected, unsigned long startMicros, bool success);
 };
 
 #endif
\ No newline at end of file
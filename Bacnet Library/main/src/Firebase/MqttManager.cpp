@@ -0,0 +1,272 @@
+#include "../config/config.h"
+#if CLOUD_TRANSPORT == CLOUD_TRANSPORT_MQTT
+#include "MqttManager.h"
+#include <Arduino.h>
+#include "../System/StringGuard.h"
+
+// Key of each journal field in the telemetry payload
+static const char* const telemetryKeys[JOURNAL_FIELD_COUNT] = {"t", "h"};
+
+void MqttManager::begin() {
+    Serial.println("Initializing MQTT Cloud Service");
+
+    snprintf(topicRoot, sizeof(topicRoot), "%s/%06lx", MQTT_TOPIC_ROOT, (unsigned long)ESP.getChipId());
+    // Bounds the TCP connect, which blocks the loop while the broker is unreachable
+    wifiClient.setTimeout(MQTT_CONNECT_TIMEOUT);
+    mqtt.setClient(wifiClient);
+    mqtt.setServer(MQTT_BROKER, MQTT_PORT);
+    mqtt.setKeepAlive(MQTT_KEEPALIVE);
+    mqtt.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+    mqtt.setCallback([this](char* topic, uint8_t* payload, unsigned int length) {
+        onMessage(topic, payload, length);
+    });
+
+    started = true;
+    Serial.printf("MQTT Broker: %s:%u, topics under %s\n", MQTT_BROKER, MQTT_PORT, topicRoot);
+}
+
+void MqttManager::handle() {
+    if (!syncRequested) return;
+    if (!started) {
+        // Deferred until the first link-up so boot is not held up by cloud setup
+        begin();
+        return;
+    }
+
+    if (!mqtt.connected()) {
+        unsigned long currentTime = millis();
+        if (metrics.connects + metrics.connectFailures > 0 &&
+            currentTime - lastConnectAttempt < reconnectDelay) return;
+        lastConnectAttempt = currentTime;
+        if (!connect()) {
+            // Back off while the broker stays down so blocked connects stay rare
+            reconnectDelay = min(reconnectDelay * 2, MQTT_RECONNECT_MAX_INTERVAL);
+            return;
+        }
+        reconnectDelay = MQTT_RECONNECT_INTERVAL;
+    }
+
+    mqtt.loop();
+    syncData();
+}
+
+void MqttManager::requestInitialSync() {
+    syncRequested = true;
+}
+
+bool MqttManager::isInitialSyncComplete() {
+    return initialSyncComplete;
+}
+
+void MqttManager::reportLocal(CloudPoint point, float value) {
+    MqttPointState& state = points[point];
+    if (value == state.localValue) return;
+    state.localValue = value;
+
+    if (value == state.publishedValue) {
+        state.dirty = false; // Changed back before it was sent
+        return;
+    }
+    unsigned long currentTime = millis();
+    if (!state.dirty) {
+        state.dirty = true;
+        state.firstChange = currentTime;
+    }
+    state.lastChange = currentTime;
+}
+
+void MqttManager::onRemoteChange(CloudValueCallback callback) {
+    remoteCallback = callback;
+}
+
+void MqttManager::syncData() {
+    unsigned long currentTime = millis();
+
+    for (uint8_t i = 0; i < CLOUD_POINT_COUNT; i++) {
+        MqttPointState& state = points[i];
+        // Rapid changes are coalesced into one message once they settle
+        if (state.dirty && (currentTime - state.lastChange >= CLOUD_WRITE_COALESCE_TIME ||
+                            currentTime - state.firstChange >= CLOUD_WRITE_MAX_DELAY)) {
+            publishPoint((CloudPoint)i);
+        }
+    }
+
+    if (journal != nullptr && !journal->isEmpty() &&
+        currentTime - lastReplayAttempt >= CLOUD_JOURNAL_RETRY_INTERVAL) {
+        replayJournal();
+    }
+}
+
+bool MqttManager::connect() {
+    char topic[MQTT_TOPIC_SIZE];
+    snprintf(topic, sizeof(topic), "%s/status", topicRoot);
+    const char* username = MQTT_USERNAME[0] != '\0' ? MQTT_USERNAME : nullptr;
+    const char* password = MQTT_PASSWORD[0] != '\0' ? MQTT_PASSWORD : nullptr;
+
+    // Persistent session under the stable client id: the broker keeps the
+    // subscription and queues QoS 1 commands while the device is away
+    if (!mqtt.connect(topicRoot, username, password, topic, 1, true, "offline", false)) {
+        metrics.connectFailures++;
+        Serial.printf("MQTT Error: Connection to %s failed, state %d\n", MQTT_BROKER, mqtt.state());
+        return false;
+    }
+    metrics.connects++;
+    Serial.printf("MQTT Connected to %s:%u\n", MQTT_BROKER, MQTT_PORT);
+
+    publish("status", "online", true);
+    snprintf(topic, sizeof(topic), "%s/cmd/+", topicRoot);
+    if (!mqtt.subscribe(topic, 1)) {
+        Serial.printf("MQTT Error: Failed to subscribe to %s\n", topic);
+    }
+
+    // The retained state is refreshed on every new session
+    for (uint8_t i = 0; i < CLOUD_POINT_COUNT; i++) {
+        if (!isnan(points[i].localValue)) publishPoint((CloudPoint)i);
+    }
+    initialSyncComplete = true;
+    return true;
+}
+
+void MqttManager::onMessage(char* topic, uint8_t* payload, unsigned int length) {
+    metrics.received++;
+
+    size_t rootLength = strlen(topicRoot);
+    if (strncmp(topic, topicRoot, rootLength) != 0 || strncmp(topic + rootLength, "/cmd/", 5) != 0) return;
+    const char* name = topic + rootLength + 5;
+
+    uint8_t point = 0;
+    while (point < CLOUD_POINT_COUNT && strcmp(name, points[point].name) != 0) point++;
+    if (point == CLOUD_POINT_COUNT) {
+        Serial.printf("MQTT Warning: Unknown command topic %s\n", topic);
+        return;
+    }
+
+    // Topic and payload point into the client's buffer, which the state
+    // publish below reuses, so the value is copied out first
+    char text[16];
+    if (length == 0 || length >= sizeof(text)) return;
+    memcpy(text, payload, length);
+    text[length] = '\0';
+
+    float value;
+    if (strcmp(text, "true") == 0) {
+        value = 1;
+    } else if (strcmp(text, "false") == 0) {
+        value = 0;
+    } else {
+        char* end;
+        value = strtod(text, &end);
+        if (end == text || *end != '\0') {
+            Serial.printf("MQTT Warning: Ignoring command \"%s\" for %s\n", text, points[point].name);
+            return;
+        }
+    }
+
+    MqttPointState& state = points[point];
+    if (state.isBool) value = value != 0 ? 1 : 0;
+    Serial.printf("Cloud Change: %s = %.2f\n", state.name, value);
+    state.localValue = value;
+    state.dirty = false;
+    if (remoteCallback != nullptr) {
+        remoteCallback((CloudPoint)point, value);
+    }
+    // Retained state follows the command so late subscribers see it
+    publishPoint((CloudPoint)point);
+}
+
+void MqttManager::publishPoint(CloudPoint point) {
+    MqttPointState& state = points[point];
+    char suffix[24];
+    char payload[16];
+    snprintf(suffix, sizeof(suffix), "state/%s", state.name);
+    if (state.isBool) {
+        snprintf(payload, sizeof(payload), "%s", state.localValue != 0 ? "true" : "false");
+    } else {
+        snprintf(payload, sizeof(payload), "%d", (int)state.localValue);
+    }
+
+    if (publish(suffix, payload, true)) {
+        state.publishedValue = state.localValue;
+        state.dirty = false;
+    } else {
+        // Keep the change and retry after another coalescing period
+        Serial.printf("MQTT Error: Failed to publish %s\n", suffix);
+        state.firstChange = state.lastChange = millis();
+    }
+}
+
+void MqttManager::setJournal(CloudJournal* cloudJournal) {
+    journal = cloudJournal;
+}
+
+// Readings always go through the journal; the next sync pass sends them
+void MqttManager::recordSensorData(float temperature, float humidity, uint32_t timestamp) {
+    if (journal == nullptr) return;
+    if (!isnan(temperature)) journal->append(JOURNAL_FIELD_TEMPERATURE, temperature, timestamp);
+    if (!isnan(humidity)) journal->append(JOURNAL_FIELD_HUMIDITY, humidity, timestamp);
+}
+
+// Sends the newest journaled value of every field in one QoS 0 message,
+// e.g. {"t":23.50,"h":41.00,"ts":1700000000}
+void MqttManager::replayJournal() {
+    lastReplayAttempt = millis();
+
+    JournalEntry latest[JOURNAL_FIELD_COUNT];
+    uint8_t present = journal->compact(latest);
+    uint32_t entryCount = journal->getCount();
+
+    char payload[64];
+    size_t length = snprintf(payload, sizeof(payload), "{");
+    uint32_t timestamp = 0;
+    for (uint8_t i = 0; i < JOURNAL_FIELD_COUNT; i++) {
+        if (!(present & (1 << i))) continue;
+        length += snprintf(payload + length, sizeof(payload) - length, "%s\"%s\":%.2f", length > 1 ? "," : "",
+                           telemetryKeys[i], latest[i].value);
+        if (latest[i].timestamp > timestamp) timestamp = latest[i].timestamp;
+    }
+    if (timestamp != 0) {
+        length += snprintf(payload + length, sizeof(payload) - length, ",\"ts\":%lu", (unsigned long)timestamp);
+    }
+    snprintf(payload + length, sizeof(payload) - length, "}");
+
+    if (present == 0 || publish("telemetry", payload, false)) {
+        journal->clear();
+        Serial.printf("Sensor data published over MQTT (%lu journal entries)\n", (unsigned long)entryCount);
+    } else {
+        Serial.printf("MQTT Error: Failed to publish sensor data, %lu entries kept\n", (unsigned long)entryCount);
+    }
+}
+
+bool MqttManager::publish(const char* suffix, const char* payload, bool retained) {
+    char topic[MQTT_TOPIC_SIZE];
+    size_t topicLength = snprintf(topic, sizeof(topic), "%s/%s", topicRoot, suffix);
+    size_t payloadLength = strlen(payload);
+    if (!mqtt.publish(topic, (const uint8_t*)payload, payloadLength, retained)) return false;
+
+    // PUBLISH framing: fixed header byte, remaining length, topic length prefix
+    uint32_t remaining = 2 + topicLength + payloadLength;
+    metrics.published++;
+    metrics.payloadBytes += payloadLength;
+    metrics.wireBytes += 1 + (remaining < 128 ? 1 : 2) + remaining;
+    return true;
+}
+
+void MqttManager::printStatus() {
+    Serial.println("MQTT Status:");
+    Serial.printf("  Connection: %s (%s:%u)\n", isReady() ? "Connected" : "Disconnected", MQTT_BROKER, MQTT_PORT);
+    Serial.printf("  Sessions: %lu (%lu failed attempts)\n", (unsigned long)metrics.connects,
+                  (unsigned long)metrics.connectFailures);
+    Serial.printf("  Commands Received: %lu\n", (unsigned long)metrics.received);
+    if (metrics.published == 0) return;
+
+    Serial.printf("  Published: %lu messages, %lu bytes each on the wire (%lu payload)\n",
+                  (unsigned long)metrics.published, (unsigned long)(metrics.wireBytes / metrics.published),
+                  (unsigned long)(metrics.payloadBytes / metrics.published));
+}
+
+bool MqttManager::isReady() {
+    return mqtt.connected();
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef MQTT_MANAGER_H
+#define MQTT_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PubSubClient.h>
+#include "../config/credentials.h"
+#include "../config/config.h"
+#include "CloudTypes.h"
+#include "CloudJournal.h"
+
+#define MQTT_TOPIC_SIZE 64
+
+// A device value mirrored on a retained state topic
+typedef struct {
+    const char* name;          // Topic suffix under state/ and cmd/
+    bool isBool;
+    float localValue;          // Last value reported by the device, NAN before the first report
+    float publishedValue;      // Last value published on this connection, NAN if none
+    bool dirty;                // Local change not yet published
+    unsigned long firstChange; // First and latest unpublished local change
+    unsigned long lastChange;
+} MqttPointState;
+
+// Traffic on the broker connection. Wire bytes include the MQTT framing of
+// each PUBLISH, so wireBytes / messages is the real per-message cost.
+typedef struct {
+    uint32_t connects;
+    uint32_t connectFailures;
+    uint32_t published;
+    uint32_t received;
+    uint32_t payloadBytes;
+    uint32_t wireBytes;
+} MqttMetrics;
+
+// Cloud sync over one persistent MQTT 3.1.1 connection, built instead of
+// FirebaseManager when CLOUD_TRANSPORT is CLOUD_TRANSPORT_MQTT. Topics live
+// under MQTT_TOPIC_ROOT/<chip id>:
+//   state/<point>  retained, QoS 0: the device's current value
+//   cmd/<point>    subscribed at QoS 1: remote commands, published unretained
+//   telemetry      QoS 0: newest journaled readings in one compact payload
+//   status         retained "online", with "offline" as the will
+// The session is persistent (clean session off, chip-id client id), so QoS 1
+// commands sent while the device was offline are delivered on reconnect.
+// Local changes are coalesced as in FirebaseManager before being published.
+class MqttManager {
+public:
+    void begin();
+    void handle();
+    void requestInitialSync();
+    bool isInitialSyncComplete();
+    void syncData();
+    void printStatus();
+    bool isReady();
+
+    void reportLocal(CloudPoint point, float value);
+    void onRemoteChange(CloudValueCallback callback);
+    void setJournal(CloudJournal* cloudJournal);
+    void recordSensorData(float temperature, float humidity, uint32_t timestamp);
+
+private:
+    WiFiClient wifiClient;
+    PubSubClient mqtt;
+    char topicRoot[MQTT_TOPIC_SIZE / 2];
+    bool started = false;
+    bool syncRequested = false;
+    bool initialSyncComplete = false;
+    unsigned long lastConnectAttempt = 0;
+    unsigned long reconnectDelay = MQTT_RECONNECT_INTERVAL;
+    MqttPointState points[CLOUD_POINT_COUNT] = {
+        {"brightness", false, NAN, NAN},
+        {"digitalLed", true, NAN, NAN}
+    };
+    CloudValueCallback remoteCallback = nullptr;
+    CloudJournal* journal = nullptr;
+    unsigned long lastReplayAttempt = 0;
+    MqttMetrics metrics = {0};
+
+    bool connect();
+    void onMessage(char* topic, uint8_t* payload, unsigned int length);
+    void publishPoint(CloudPoint point);
+    void replayJournal();
+    bool publish(const char* suffix, const char* payload, bool retained);
+};
+
+#endif
@@ -1,39 +1,178 @@
 #include <Arduino.h>
 #include "WiFiManager.h"
+#include "../System/StringGuard.h"
 
 void WiFiManager::connect() {
     Serial.println("Starting WiFi Connection Procedure");
-    Serial.println("Target Network: " + String(WIFI_SSID));
+    Serial.printf("Target Network: %s\n", WIFI_SSID);
     
+    // The connection is driven by handle(), so keep the SDK from
+    // reconnecting on its own or rewriting credentials to flash
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
     
-    connectionStartTime = millis();
-    Serial.print("Establishing WiFi Connection");
-    
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(250);
-        Serial.print(".");
-        
-        if (millis() - connectionStartTime > NETWORK_TIMEOUT) {
-            Serial.println("\nWiFi Connection Failed: Timeout exceeded");
-            Serial.println("Initiating System Restart...");
-            ESP.restart();
-        }
+    hasCachedAccessPoint = loadRecord(NETWORK_CACHE_PATH, &networkCache, sizeof(networkCache));
+    
+#ifdef WIFI_STATIC_IP
+    WiFi.config(IPAddress(WIFI_STATIC_IP), IPAddress(WIFI_STATIC_GATEWAY),
+                IPAddress(WIFI_STATIC_SUBNET), IPAddress(WIFI_STATIC_DNS));
+    Serial.printf("Static IP Configuration: " IP_FORMAT "\n", IP_ARGS(IPAddress(WIFI_STATIC_IP)));
+#else
+    if (WIFI_REUSE_DHCP_LEASE && hasCachedAccessPoint && networkCache.localIP != 0) {
+        // Reuse the previous lease to skip the DHCP exchange on boot. It is only
+        // a hint: the first failed or lost link on it returns to DHCP for good.
+        WiFi.config(IPAddress(networkCache.localIP), IPAddress(networkCache.gateway),
+                    IPAddress(networkCache.subnet), IPAddress(networkCache.dns));
+        usingCachedLease = true;
+        Serial.printf("Reusing Cached IP Address: " IP_FORMAT "\n", IP_ARGS(IPAddress(networkCache.localIP)));
     }
+#endif
+    
+    gotIpHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& event) {
+        gotIpEvent = true;
+    });
+    disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& event) {
+        disconnectedEvent = true;
+    });
+    
+    startAttempt();
+}
+
+void WiFiManager::handle() {
+    bool gotIp = gotIpEvent;
+    bool disconnected = disconnectedEvent;
+    gotIpEvent = false;
+    disconnectedEvent = false;
     
-    Serial.println("\nWiFi Connection Established Successfully");
-    Serial.println("Local IP Address: " + WiFi.localIP().toString());
-    Serial.println("Signal Strength: " + String(WiFi.RSSI()) + " dBm");
+    switch (state) {
+        case WIFI_STATE_CONNECTING:
+            if (gotIp || WiFi.status() == WL_CONNECTED) {
+                state = WIFI_STATE_CONNECTED;
+                retryDelay = WIFI_RETRY_MIN_DELAY;
+                updateNetworkCache();
+                
+                Serial.println("WiFi Connection Established Successfully");
+                Serial.printf("Local IP Address: " IP_FORMAT "\n", IP_ARGS(WiFi.localIP()));
+                Serial.printf("Signal Strength: %d dBm\n", (int)WiFi.RSSI());
+                Serial.printf("Association Time: %lu ms%s\n", millis() - connectionStartTime,
+                              fastAttempt ? " (fast reconnect)" : "");
+                notifyLinkState(true);
+            } else if (millis() - connectionStartTime > (fastAttempt ? WIFI_FAST_CONNECT_TIMEOUT : NETWORK_TIMEOUT)) {
+                Serial.println("WiFi Connection Attempt Timed Out");
+                if (fastAttempt) {
+                    // Access point may have moved channel, fall back to a full scan
+                    hasCachedAccessPoint = false;
+                }
+                if (usingCachedLease) {
+                    dropCachedLease();
+                }
+                scheduleRetry();
+            }
+            break;
+            
+        case WIFI_STATE_CONNECTED:
+            if (disconnected || WiFi.status() != WL_CONNECTED) {
+                Serial.println("WiFi Link Lost - Local control continues, reconnecting");
+                reconnectCount++;
+                notifyLinkState(false);
+                if (usingCachedLease) {
+                    // The lease may have expired or moved to another host meanwhile
+                    dropCachedLease();
+                }
+                startAttempt();
+            }
+            break;
+            
+        case WIFI_STATE_BACKOFF:
+            if (millis() - backoffStartTime >= retryDelay) {
+                retryDelay = min(retryDelay * 2, WIFI_RETRY_MAX_DELAY);
+                startAttempt();
+            }
+            break;
+            
+        case WIFI_STATE_IDLE:
+            break;
+    }
 }
 
 void WiFiManager::printStatus() {
+    static const char* stateNames[] = {"Idle", "Connecting", "Connected", "Waiting to Retry"};
+    
     Serial.println("Network Status:");
-    Serial.println("  WiFi Connected: " + String(isConnected() ? "Yes" : "No"));
-    Serial.println("  IP Address: " + WiFi.localIP().toString());
-    Serial.println("  Signal Strength: " + String(WiFi.RSSI()) + " dBm");
+    Serial.printf("  WiFi Connected: %s\n", isConnected() ? "Yes" : "No");
+    Serial.printf("  Link State: %s\n", stateNames[state]);
+    Serial.printf("  IP Address: " IP_FORMAT "\n", IP_ARGS(WiFi.localIP()));
+    Serial.printf("  Signal Strength: %d dBm\n", (int)WiFi.RSSI());
+    Serial.printf("  Reconnects: %lu\n", (unsigned long)reconnectCount);
 }
 
 bool WiFiManager::isConnected() {
-    return WiFi.status() == WL_CONNECTED;
-}
\ No newline at end of file
+    return state == WIFI_STATE_CONNECTED;
+}
+
+void WiFiManager::onLinkStateChange(WiFiLinkCallback callback) {
+    if (linkCallbackCount < WIFI_MAX_LINK_CALLBACKS) {
+        linkCallbacks[linkCallbackCount++] = callback;
+    }
+}
+
+void WiFiManager::startAttempt() {
+    state = WIFI_STATE_CONNECTING;
+    connectionStartTime = millis();
+    fastAttempt = hasCachedAccessPoint;
+    
+    if (fastAttempt) {
+        // Skip the channel scan by targeting the last known access point
+        Serial.printf("WiFi Fast Reconnect on Channel %ld\n", (long)networkCache.channel);
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, networkCache.channel, networkCache.bssid);
+    } else {
+        Serial.println("WiFi Connecting with Full Scan");
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    }
+}
+
+void WiFiManager::updateNetworkCache() {
+    NetworkCache current;
+    memset(&current, 0, sizeof(current));
+    memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+    current.channel = WiFi.channel();
+    current.localIP = WiFi.localIP();
+    current.gateway = WiFi.gatewayIP();
+    current.subnet = WiFi.subnetMask();
+    current.dns = WiFi.dnsIP();
+    
+    // Only touch flash when the access point or lease actually changed
+    if (!hasCachedAccessPoint || memcmp(&current, &networkCache, sizeof(current)) != 0) {
+        networkCache = current;
+        saveRecord(NETWORK_CACHE_PATH, &networkCache, sizeof(networkCache));
+        Serial.printf("Network Cache Updated: Channel %ld\n", (long)networkCache.channel);
+    }
+    hasCachedAccessPoint = true;
+}
+
+// Returns to DHCP and forgets the lease, so the next boot does not reuse it
+// either; the next DHCP association stores a fresh one
+void WiFiManager::dropCachedLease() {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    usingCachedLease = false;
+    networkCache.localIP = 0;
+    if (hasCachedAccessPoint) {
+        saveRecord(NETWORK_CACHE_PATH, &networkCache, sizeof(networkCache));
+    }
+    Serial.println("WiFi Cached Lease Dropped, Using DHCP");
+}
+
+void WiFiManager::scheduleRetry() {
+    WiFi.disconnect();
+    state = WIFI_STATE_BACKOFF;
+    // Jitter keeps a site full of controllers from retrying in lockstep
+    backoffStartTime = millis() - random(retryDelay / 4 + 1);
+    Serial.printf("WiFi Retry Scheduled in %lu ms\n", retryDelay);
+}
+
+void WiFiManager::notifyLinkState(bool connected) {
+    for (uint8_t i = 0; i < linkCallbackCount; i++) {
+        linkCallbacks[i](connected);
+    }
+}
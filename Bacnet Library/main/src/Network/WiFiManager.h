@@ -5,15 +5,64 @@
 #include <ESP8266WiFi.h>
 #include "../config/credentials.h"
 #include "../config/config.h"
+#include "../Storage/Storage.h"
+
+#define NETWORK_CACHE_PATH "/network.bin"
+
+// Access point and lease of the last good association, persisted for fast boots
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t reserved[2];
+    int32_t channel;
+    uint32_t localIP;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+} NetworkCache;
+
+enum WiFiConnectionState {
+    WIFI_STATE_IDLE,
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_BACKOFF
+};
+
+typedef void (*WiFiLinkCallback)(bool connected);
 
 class WiFiManager {
 public:
     void connect();
+    void handle();
     void printStatus();
     bool isConnected();
+    void onLinkStateChange(WiFiLinkCallback callback);
 
 private:
+    WiFiConnectionState state = WIFI_STATE_IDLE;
     unsigned long connectionStartTime = 0;
+    unsigned long backoffStartTime = 0;
+    unsigned long retryDelay = WIFI_RETRY_MIN_DELAY;
+    uint32_t reconnectCount = 0;
+
+    NetworkCache networkCache = {};
+    bool hasCachedAccessPoint = false;
+    bool usingCachedLease = false;
+    bool fastAttempt = false;
+
+    // Set from the SDK event context, consumed in handle()
+    volatile bool gotIpEvent = false;
+    volatile bool disconnectedEvent = false;
+    WiFiEventHandler gotIpHandler;
+    WiFiEventHandler disconnectedHandler;
+
+    WiFiLinkCallback linkCallbacks[WIFI_MAX_LINK_CALLBACKS];
+    uint8_t linkCallbackCount = 0;
+
+    void startAttempt();
+    void updateNetworkCache();
+    void dropCachedLease();
+    void scheduleRetry();
+    void notifyLinkState(bool connected);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,482 @@
+#include <Arduino.h>
+#include "RulesEngine.h"
+#include "../System/StringGuard.h"
+
+static const char* const RULE_POINT_NAMES[RULE_POINT_COUNT] = {
+    "temperature", "humidity", "button", "led", "brightness", "mode", "setpoint", "time", "day"
+};
+
+typedef struct {
+    const char* name;
+    float value;
+} RuleValueName;
+
+// Symbolic values accepted in rule text; mode names follow ThermostatMode
+static const RuleValueName RULE_VALUE_NAMES[] = {
+    {"off", 0}, {"on", 1}, {"false", 0}, {"true", 1},
+    {"cool", 1}, {"heat", 2}, {"auto", 3},
+    {"sun", 0}, {"mon", 1}, {"tue", 2}, {"wed", 3}, {"thu", 4}, {"fri", 5}, {"sat", 6}
+};
+
+typedef struct {
+    const char* symbol;
+    RuleOpcode opcode;
+} RuleOperator;
+
+static const RuleOperator RULE_OPERATORS[] = {
+    {">", RULE_OP_GT}, {"<", RULE_OP_LT}, {">=", RULE_OP_GE}, {"<=", RULE_OP_LE}, {"==", RULE_OP_EQ}, {"!=", RULE_OP_NE}
+};
+
+static bool isWritablePoint(uint8_t point) {
+    return point == RULE_POINT_LED || point == RULE_POINT_BRIGHTNESS ||
+           point == RULE_POINT_MODE || point == RULE_POINT_SETPOINT;
+}
+
+static int findPoint(const char* name) {
+    for (uint8_t i = 0; i < RULE_POINT_COUNT; i++) {
+        if (strcmp(name, RULE_POINT_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static bool parseValue(const char* token, float& value) {
+    for (size_t i = 0; i < sizeof(RULE_VALUE_NAMES) / sizeof(RULE_VALUE_NAMES[0]); i++) {
+        if (strcmp(token, RULE_VALUE_NAMES[i].name) == 0) {
+            value = RULE_VALUE_NAMES[i].value;
+            return true;
+        }
+    }
+
+    char* end;
+    const char* colon = strchr(token, ':');
+    if (colon != nullptr) {
+        // hh:mm as minutes since midnight
+        long hours = strtol(token, &end, 10);
+        if (end != colon) return false;
+        long minutes = strtol(colon + 1, &end, 10);
+        if (*end != '\0' || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) return false;
+        value = hours * 60 + minutes;
+        return true;
+    }
+
+    value = strtod(token, &end);
+    return end != token && *end == '\0';
+}
+
+static bool emitByte(RuleProgram& output, uint8_t value) {
+    if (output.length >= RULES_PROGRAM_SIZE) return false;
+    output.code[output.length++] = value;
+    return true;
+}
+
+static bool emitFloat(RuleProgram& output, float value) {
+    if (output.length + sizeof(float) > RULES_PROGRAM_SIZE) return false;
+    memcpy(&output.code[output.length], &value, sizeof(float));
+    output.length += sizeof(float);
+    return true;
+}
+
+void RulesEngine::begin() {
+    Serial.println("Initializing rules engine...");
+    for (uint8_t i = 0; i < RULE_POINT_COUNT; i++) {
+        inputs[i] = NAN;
+    }
+
+    RuleProgram stored;
+    if (loadRecord(RULES_PROGRAM_PATH, &stored, sizeof(RuleProgram)) && load(stored)) {
+        Serial.printf("  %u rules loaded (%u bytes)\n", ruleCount, program.length);
+    } else {
+        program.length = 0;
+        Serial.println("  No rules installed");
+    }
+}
+
+void RulesEngine::handle() {
+    if (pendingRules == 0) return;
+
+    uint32_t pending = pendingRules;
+    pendingRules = 0;
+
+    for (uint8_t i = 0; i < ruleCount; i++) {
+        if (!(pending & (1UL << i))) continue;
+
+        RuleEntry& rule = rules[i];
+        // Wait until every input the rule reads has a value; it is flagged again when they arrive
+        if ((rule.pointMask & knownPoints) != rule.pointMask) continue;
+
+        int8_t result = evaluate(rule) ? 1 : 0;
+        evaluationCount++;
+        if (result == rule.lastResult) continue;
+
+        rule.lastResult = result;
+        uint16_t thenOffset = rule.offset + rule.conditionLength;
+        if (result) {
+            runActions(thenOffset, rule.thenLength);
+        } else {
+            runActions(thenOffset + rule.thenLength, rule.elseLength);
+        }
+    }
+}
+
+void RulesEngine::printStatus() {
+    Serial.println("Rules Engine Status:");
+    Serial.printf("  Rules: %u (%u/%u bytes)\n", ruleCount, program.length, RULES_PROGRAM_SIZE);
+    Serial.printf("  Evaluations: %lu, Actions: %lu\n", (unsigned long)evaluationCount, (unsigned long)actionCount);
+}
+
+void RulesEngine::setInput(RulePoint point, float value) {
+    if (point >= RULE_POINT_COUNT) return;
+    uint16_t pointBit = 1 << point;
+
+    if (isnan(value)) {
+        knownPoints &= ~pointBit;
+        return;
+    }
+    if ((knownPoints & pointBit) && inputs[point] == value) return;
+
+    inputs[point] = value;
+    knownPoints |= pointBit;
+    pendingRules |= pointRules[point];
+}
+
+void RulesEngine::onAction(RuleActionCallback callback) {
+    actionCallback = callback;
+}
+
+bool RulesEngine::upload(const char* source, char* error, size_t errorSize) {
+    RuleProgram compiled;
+    RuleEntry entries[RULES_MAX_RULES];
+    uint8_t count;
+    if (!compile(source, compiled, error, errorSize) || !parse(compiled, entries, count)) {
+        if (error[0] == '\0') snprintf(error, errorSize, "Compiled program failed validation");
+        return false;
+    }
+
+    // Saved before it runs, so a failed upload leaves the previous rules both
+    // active and in flash
+    if (!saveRecord(RULES_PROGRAM_PATH, &compiled, sizeof(RuleProgram))) {
+        snprintf(error, errorSize, "Rules not saved to flash, previous rules kept");
+        return false;
+    }
+    File sourceFile = LittleFS.open(RULES_SOURCE_PATH, "w");
+    if (sourceFile) {
+        sourceFile.write((const uint8_t*)source, strlen(source));
+        sourceFile.close();
+    }
+    activate(compiled, entries, count);
+
+    Serial.printf("Rules Updated: %u rules, %u bytes\n", ruleCount, program.length);
+    return true;
+}
+
+void RulesEngine::printSource(Print& output) {
+    if (ruleCount == 0 || !mountStorage()) return;
+
+    File sourceFile = LittleFS.open(RULES_SOURCE_PATH, "r");
+    if (!sourceFile) return;
+
+    uint8_t chunk[64];
+    int length;
+    while ((length = sourceFile.read(chunk, sizeof(chunk))) > 0) {
+        output.write(chunk, length);
+    }
+    sourceFile.close();
+}
+
+uint8_t RulesEngine::getRuleCount() { return ruleCount; }
+uint16_t RulesEngine::getProgramSize() { return program.length; }
+
+bool RulesEngine::compile(const char* source, RuleProgram& output, char* error, size_t errorSize) {
+    output.length = 0;
+    error[0] = '\0';
+
+    char* text = strdup(source);
+    if (text == nullptr) {
+        snprintf(error, errorSize, "Out of memory");
+        return false;
+    }
+
+    // One rule per line or ';'
+    bool success = true;
+    uint8_t lineNumber = 0;
+    char* ruleSave;
+    for (char* ruleText = strtok_r(text, "\n;", &ruleSave); ruleText != nullptr; ruleText = strtok_r(nullptr, "\n;", &ruleSave)) {
+        lineNumber++;
+        char ruleError[64];
+        if (!compileRule(ruleText, output, ruleError, sizeof(ruleError))) {
+            snprintf(error, errorSize, "Rule %u: %s", lineNumber, ruleError);
+            success = false;
+            break;
+        }
+    }
+
+    free(text);
+    return success;
+}
+
+// if <point> <op> <value> [and|or [not] <point> <op> <value>]... then <point>=<value>... [else <point>=<value>...]
+// and/or combine left to right.
+bool RulesEngine::compileRule(char* text, RuleProgram& output, char* error, size_t errorSize) {
+    const char* separators = " \t\r";
+    char* save;
+    char* token = strtok_r(text, separators, &save);
+    if (token == nullptr) return true; // Blank line
+
+    if (strcmp(token, "if") != 0) {
+        snprintf(error, errorSize, "expected 'if', found '%s'", token);
+        return false;
+    }
+
+    uint16_t header = output.length;
+    if (!emitByte(output, 0) || !emitByte(output, 0) || !emitByte(output, 0)) {
+        snprintf(error, errorSize, "program too large");
+        return false;
+    }
+
+    // Condition
+    uint16_t start = output.length;
+    RuleOpcode join = (RuleOpcode)0;
+    while (true) {
+        token = strtok_r(nullptr, separators, &save);
+        bool negate = token != nullptr && strcmp(token, "not") == 0;
+        if (negate) token = strtok_r(nullptr, separators, &save);
+
+        int point = token ? findPoint(token) : -1;
+        if (point < 0) {
+            snprintf(error, errorSize, "unknown point '%s'", token ? token : "");
+            return false;
+        }
+
+        token = strtok_r(nullptr, separators, &save);
+        const RuleOperator* comparison = nullptr;
+        for (size_t i = 0; token != nullptr && i < sizeof(RULE_OPERATORS) / sizeof(RULE_OPERATORS[0]); i++) {
+            if (strcmp(token, RULE_OPERATORS[i].symbol) == 0) comparison = &RULE_OPERATORS[i];
+        }
+        if (comparison == nullptr) {
+            snprintf(error, errorSize, "expected comparison after '%s'", RULE_POINT_NAMES[point]);
+            return false;
+        }
+
+        float value;
+        token = strtok_r(nullptr, separators, &save);
+        if (token == nullptr || !parseValue(token, value)) {
+            snprintf(error, errorSize, "invalid value '%s'", token ? token : "");
+            return false;
+        }
+
+        bool emitted = emitByte(output, RULE_OP_LOAD) && emitByte(output, point) &&
+                       emitByte(output, RULE_OP_CONST) && emitFloat(output, value) &&
+                       emitByte(output, comparison->opcode) &&
+                       (!negate || emitByte(output, RULE_OP_NOT)) &&
+                       (join == 0 || emitByte(output, join));
+        if (!emitted) {
+            snprintf(error, errorSize, "program too large");
+            return false;
+        }
+
+        token = strtok_r(nullptr, separators, &save);
+        if (token != nullptr && strcmp(token, "and") == 0) {
+            join = RULE_OP_AND;
+        } else if (token != nullptr && strcmp(token, "or") == 0) {
+            join = RULE_OP_OR;
+        } else if (token != nullptr && strcmp(token, "then") == 0) {
+            break;
+        } else {
+            snprintf(error, errorSize, "expected 'and', 'or' or 'then'");
+            return false;
+        }
+    }
+    uint16_t conditionLength = output.length - start;
+
+    // Actions: then-branch, optionally followed by else-branch
+    uint16_t branchLength[2] = {0, 0};
+    for (uint8_t branch = 0; branch < 2; branch++) {
+        start = output.length;
+        while ((token = strtok_r(nullptr, separators, &save)) != nullptr) {
+            if (branch == 0 && strcmp(token, "else") == 0) break;
+
+            char* equals = strchr(token, '=');
+            if (equals == nullptr) {
+                snprintf(error, errorSize, "expected <point>=<value>, found '%s'", token);
+                return false;
+            }
+            *equals = '\0';
+            int point = findPoint(token);
+            float value;
+            if (point < 0 || !isWritablePoint(point)) {
+                snprintf(error, errorSize, "'%s' cannot be set", token);
+                return false;
+            }
+            if (!parseValue(equals + 1, value)) {
+                snprintf(error, errorSize, "invalid value '%s'", equals + 1);
+                return false;
+            }
+            if (!emitByte(output, RULE_OP_SET) || !emitByte(output, point) || !emitFloat(output, value)) {
+                snprintf(error, errorSize, "program too large");
+                return false;
+            }
+        }
+        branchLength[branch] = output.length - start;
+        if (token == nullptr) break;
+    }
+
+    if (branchLength[0] == 0) {
+        snprintf(error, errorSize, "no actions after 'then'");
+        return false;
+    }
+    if (conditionLength > 255 || branchLength[0] > 255 || branchLength[1] > 255) {
+        snprintf(error, errorSize, "rule too long");
+        return false;
+    }
+    output.code[header] = conditionLength;
+    output.code[header + 1] = branchLength[0];
+    output.code[header + 2] = branchLength[1];
+    return true;
+}
+
+// Checks a program end to end before it replaces the active one, so the
+// evaluator never has to bounds-check at run time
+bool RulesEngine::load(const RuleProgram& candidate) {
+    RuleEntry entries[RULES_MAX_RULES];
+    uint8_t count;
+    if (!parse(candidate, entries, count)) return false;
+    activate(candidate, entries, count);
+    return true;
+}
+
+// Splits a program into rules and validates each of them, without touching the active set
+bool RulesEngine::parse(const RuleProgram& candidate, RuleEntry* entries, uint8_t& count) {
+    if (candidate.length > RULES_PROGRAM_SIZE) return false;
+
+    count = 0;
+    uint16_t offset = 0;
+    while (offset < candidate.length) {
+        if (count >= RULES_MAX_RULES || offset + 3 > candidate.length) return false;
+
+        RuleEntry& rule = entries[count];
+        rule.conditionLength = candidate.code[offset];
+        rule.thenLength = candidate.code[offset + 1];
+        rule.elseLength = candidate.code[offset + 2];
+        rule.offset = offset + 3;
+        rule.pointMask = 0;
+        rule.lastResult = -1;
+
+        uint16_t end = rule.offset + rule.conditionLength + rule.thenLength + rule.elseLength;
+        uint16_t unusedMask = 0;
+        if (end > candidate.length ||
+            !validateRun(&candidate.code[rule.offset], rule.conditionLength, false, rule.pointMask) ||
+            !validateRun(&candidate.code[rule.offset + rule.conditionLength], rule.thenLength, true, unusedMask) ||
+            !validateRun(&candidate.code[rule.offset + rule.conditionLength + rule.thenLength], rule.elseLength, true, unusedMask)) {
+            return false;
+        }
+        offset = end;
+        count++;
+    }
+    return true;
+}
+
+void RulesEngine::activate(const RuleProgram& candidate, const RuleEntry* entries, uint8_t count) {
+    if (&candidate != &program) {
+        memcpy(&program, &candidate, sizeof(RuleProgram));
+    }
+    memcpy(rules, entries, sizeof(RuleEntry) * count);
+    ruleCount = count;
+
+    // Index rules by the inputs they read, then evaluate every rule once
+    memset(pointRules, 0, sizeof(pointRules));
+    for (uint8_t i = 0; i < ruleCount; i++) {
+        for (uint8_t point = 0; point < RULE_POINT_COUNT; point++) {
+            if (rules[i].pointMask & (1 << point)) pointRules[point] |= 1UL << i;
+        }
+    }
+    pendingRules = ruleCount == 32 ? 0xFFFFFFFF : (1UL << ruleCount) - 1;
+}
+
+bool RulesEngine::validateRun(const uint8_t* code, uint8_t length, bool actions, uint16_t& pointMask) {
+    uint8_t depth = 0;
+    uint8_t i = 0;
+
+    while (i < length) {
+        uint8_t opcode = code[i++];
+        switch (opcode) {
+            case RULE_OP_LOAD:
+                if (actions || i + 1 > length || code[i] >= RULE_POINT_COUNT) return false;
+                pointMask |= 1 << code[i++];
+                depth++;
+                break;
+            case RULE_OP_CONST:
+                if (actions || i + sizeof(float) > length) return false;
+                i += sizeof(float);
+                depth++;
+                break;
+            case RULE_OP_GT: case RULE_OP_LT: case RULE_OP_GE: case RULE_OP_LE:
+            case RULE_OP_EQ: case RULE_OP_NE: case RULE_OP_AND: case RULE_OP_OR:
+                if (actions || depth < 2) return false;
+                depth--;
+                break;
+            case RULE_OP_NOT:
+                if (actions || depth < 1) return false;
+                break;
+            case RULE_OP_SET:
+                if (!actions || i + 1 + sizeof(float) > length || !isWritablePoint(code[i])) return false;
+                i += 1 + sizeof(float);
+                break;
+            default:
+                return false;
+        }
+        if (depth > RULES_STACK_DEPTH) return false;
+    }
+    return actions || depth == 1;
+}
+
+bool RulesEngine::evaluate(const RuleEntry& rule) {
+    float stack[RULES_STACK_DEPTH];
+    uint8_t depth = 0;
+    const uint8_t* code = &program.code[rule.offset];
+    uint8_t i = 0;
+
+    while (i < rule.conditionLength) {
+        uint8_t opcode = code[i++];
+        if (opcode == RULE_OP_LOAD) {
+            stack[depth++] = inputs[code[i++]];
+            continue;
+        }
+        if (opcode == RULE_OP_CONST) {
+            memcpy(&stack[depth++], &code[i], sizeof(float));
+            i += sizeof(float);
+            continue;
+        }
+        if (opcode == RULE_OP_NOT) {
+            stack[depth - 1] = stack[depth - 1] == 0 ? 1 : 0;
+            continue;
+        }
+
+        float right = stack[--depth];
+        float left = stack[depth - 1];
+        bool result = false;
+        switch (opcode) {
+            case RULE_OP_GT: result = left > right; break;
+            case RULE_OP_LT: result = left < right; break;
+            case RULE_OP_GE: result = left >= right; break;
+            case RULE_OP_LE: result = left <= right; break;
+            case RULE_OP_EQ: result = left == right; break;
+            case RULE_OP_NE: result = left != right; break;
+            case RULE_OP_AND: result = left != 0 && right != 0; break;
+            case RULE_OP_OR: result = left != 0 || right != 0; break;
+        }
+        stack[depth - 1] = result ? 1 : 0;
+    }
+    return stack[0] != 0;
+}
+
+void RulesEngine::runActions(uint16_t offset, uint8_t length) {
+    const uint8_t* code = &program.code[offset];
+    for (uint8_t i = 0; i < length; i += 1 + 1 + sizeof(float)) {
+        float value;
+        memcpy(&value, &code[i + 2], sizeof(float));
+        actionCount++;
+        if (actionCallback != nullptr) {
+            actionCallback((RulePoint)code[i + 1], value);
+        }
+    }
+}
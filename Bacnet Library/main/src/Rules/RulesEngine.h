@@ -0,0 +1,99 @@
+#ifndef RULES_ENGINE_H
+#define RULES_ENGINE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "../config/config.h"
+#include "../Storage/Storage.h"
+
+#define RULES_PROGRAM_PATH "/rules.bin"
+#define RULES_SOURCE_PATH "/rules.txt"
+
+// Values the rules can read; the writable ones can also be set by actions
+enum RulePoint : uint8_t {
+    RULE_POINT_TEMPERATURE,
+    RULE_POINT_HUMIDITY,
+    RULE_POINT_BUTTON,
+    RULE_POINT_LED,
+    RULE_POINT_BRIGHTNESS,
+    RULE_POINT_MODE,
+    RULE_POINT_SETPOINT,
+    RULE_POINT_TIME, // Minutes since local midnight
+    RULE_POINT_DAY,  // 0 = Sunday
+    RULE_POINT_COUNT
+};
+
+enum RuleOpcode : uint8_t {
+    RULE_OP_LOAD = 0x01,  // + point: push input value
+    RULE_OP_CONST = 0x02, // + float32: push constant
+    RULE_OP_GT = 0x10,
+    RULE_OP_LT = 0x11,
+    RULE_OP_GE = 0x12,
+    RULE_OP_LE = 0x13,
+    RULE_OP_EQ = 0x14,
+    RULE_OP_NE = 0x15,
+    RULE_OP_AND = 0x20,
+    RULE_OP_OR = 0x21,
+    RULE_OP_NOT = 0x22,
+    RULE_OP_SET = 0x30    // + point + float32: action, write output
+};
+
+// Compiled rule set as stored in flash. Each rule is three length bytes
+// (condition, then-actions, else-actions) followed by those byte runs.
+typedef struct {
+    uint16_t length;
+    uint8_t code[RULES_PROGRAM_SIZE];
+} RuleProgram;
+
+typedef struct {
+    uint16_t offset;
+    uint8_t conditionLength;
+    uint8_t thenLength;
+    uint8_t elseLength;
+    uint16_t pointMask;
+    int8_t lastResult; // -1 until first evaluated
+} RuleEntry;
+
+typedef void (*RuleActionCallback)(RulePoint point, float value);
+
+// On-device automation. Rule text such as
+//   if temperature > 26 and time >= 8:00 then mode=cool setpoint=24 else mode=off
+// is compiled once on upload to a small stack bytecode kept in flash. A rule
+// is only re-evaluated when one of the inputs it reads changes, and its
+// actions run when its condition changes between true and false.
+class RulesEngine {
+public:
+    void begin();
+    void handle();
+    void printStatus();
+
+    void setInput(RulePoint point, float value);
+    void onAction(RuleActionCallback callback);
+    bool upload(const char* source, char* error, size_t errorSize);
+    void printSource(Print& output);
+    uint8_t getRuleCount();
+    uint16_t getProgramSize();
+
+private:
+    RuleProgram program;
+    RuleEntry rules[RULES_MAX_RULES];
+    uint8_t ruleCount = 0;
+    uint32_t pointRules[RULE_POINT_COUNT] = {0}; // Bit per rule that reads the point
+    float inputs[RULE_POINT_COUNT];
+    uint16_t knownPoints = 0;
+    uint32_t pendingRules = 0; // Rules whose inputs changed since the last pass
+    RuleActionCallback actionCallback = nullptr;
+    uint32_t evaluationCount = 0;
+    uint32_t actionCount = 0;
+
+    bool compile(const char* source, RuleProgram& output, char* error, size_t errorSize);
+    bool compileRule(char* text, RuleProgram& output, char* error, size_t errorSize);
+    bool load(const RuleProgram& candidate);
+    bool parse(const RuleProgram& candidate, RuleEntry* entries, uint8_t& count);
+    void activate(const RuleProgram& candidate, const RuleEntry* entries, uint8_t count);
+    bool validateRun(const uint8_t* code, uint8_t length, bool actions, uint16_t& pointMask);
+    bool evaluate(const RuleEntry& rule);
+    void runActions(uint16_t offset, uint8_t length);
+};
+
+#endif
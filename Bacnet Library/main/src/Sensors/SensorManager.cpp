@@ -1,7 +1,11 @@
 #include <Arduino.h>
 #include "SensorManager.h"
+#include "../System/StringGuard.h"
 
-void SensorManager::begin() {
+static constexpr fixed_t FILTER_ALPHA = fixedFromFloat(TEMPERATURE_FILTER_ALPHA);
+
+void SensorManager::begin(TimeService* clock) {
+    timeService = clock;
     Serial.println("Starting DHT11 temperature and humidity sensor...");
     dht.begin();
 }
@@ -22,23 +26,44 @@ void SensorManager::readDHTSensor() {
     float humidityReading = dht.readHumidity();
     
     if (!isnan(tempReading) && !isnan(humidityReading)) {
-        temperature = tempReading;
-        humidity = humidityReading;
+        failedReads = 0;
+        // The driver only returns float; convert once and stay in fixed point from here
+        temperature = fixedFromFloat(tempReading);
+        humidity = fixedFromFloat(humidityReading);
+        sampleTime = timeService->epochSeconds();
+        
+        // Exponential smoothing takes out the DHT11's 1 C steps and read noise for control
+        if (!fixedIsValid(filteredTemperature)) {
+            filteredTemperature = temperature;
+        } else {
+            filteredTemperature += fixedMul(FILTER_ALPHA, temperature - filteredTemperature);
+        }
         Serial.println("DHT Sensor Read Successful:");
-        Serial.println("  Temperature: " + String(temperature) + " C");
-        Serial.println("  Humidity: " + String(humidity) + " %");
+        Serial.printf("  Temperature: %.2f C\n", tempReading);
+        Serial.printf("  Humidity: %.2f %%\n", humidityReading);
     } else {
         Serial.println("DHT Sensor Error: Failed to read temperature or humidity");
-        Serial.println("  Temperature Read: " + String(isnan(tempReading) ? "Failed" : "Success"));
-        Serial.println("  Humidity Read: " + String(isnan(humidityReading) ? "Failed" : "Success"));
+        Serial.printf("  Temperature Read: %s\n", isnan(tempReading) ? "Failed" : "Success");
+        Serial.printf("  Humidity Read: %s\n", isnan(humidityReading) ? "Failed" : "Success");
+        
+        if (failedReads < DHT_MAX_FAILED_READS && ++failedReads == DHT_MAX_FAILED_READS) {
+            Serial.printf("DHT Sensor Fault: %u failed reads, readings invalidated\n", failedReads);
+            temperature = FIXED_INVALID;
+            filteredTemperature = FIXED_INVALID;
+            humidity = FIXED_INVALID;
+        }
     }
 }
 
 void SensorManager::printStatus() {
     Serial.println("Environmental Sensor Status:");
-    Serial.println("  Temperature: " + String(isnan(temperature) ? "Reading Failed" : String(temperature) + " C"));
-    Serial.println("  Humidity: " + String(isnan(humidity) ? "Reading Failed" : String(humidity) + " %"));
+    if (!fixedIsValid(temperature)) Serial.println("  Temperature: Reading Failed");
+    else Serial.printf("  Temperature: %.2f C\n", fixedToFloat(temperature));
+    if (!fixedIsValid(humidity)) Serial.println("  Humidity: Reading Failed");
+    else Serial.printf("  Humidity: %.2f %%\n", fixedToFloat(humidity));
 }
 
-float SensorManager::getTemperature() { return temperature; }
-float SensorManager::getHumidity() { return humidity; }
\ No newline at end of file
+fixed_t SensorManager::getTemperature() { return temperature; }
+fixed_t SensorManager::getFilteredTemperature() { return filteredTemperature; }
+fixed_t SensorManager::getHumidity() { return humidity; }
+uint32_t SensorManager::getSampleTime() { return sampleTime; }
@@ -5,20 +5,30 @@
 #include <DHT.h>
 #include "../config/pins.h"
 #include "../config/config.h"
+#include "../System/TimeService.h"
+#include "../System/FixedPoint.h"
 
 class SensorManager {
 public:
-    void begin();
+    void begin(TimeService* clock);
     void readAndUploadData();
     void printStatus();
-    float getTemperature();
-    float getHumidity();
+    // FIXED_INVALID until the first good reading and after DHT_MAX_FAILED_READS
+    // failed reads in a row, so control stops acting on a stale temperature
+    fixed_t getTemperature();
+    fixed_t getFilteredTemperature();
+    fixed_t getHumidity();
+    uint32_t getSampleTime();
 
 private:
+    TimeService* timeService = nullptr;
     DHT dht = DHT(DHT11_AI, DHT11);
-    float temperature = NAN;
-    float humidity = NAN;
+    fixed_t temperature = FIXED_INVALID;
+    fixed_t filteredTemperature = FIXED_INVALID;
+    fixed_t humidity = FIXED_INVALID;
+    uint32_t sampleTime = 0; // Epoch seconds of the last good reading, 0 if the clock was not set
     unsigned long lastDHTUpload = 0;
+    uint8_t failedReads = 0;
     
     void readDHTSensor();
 };
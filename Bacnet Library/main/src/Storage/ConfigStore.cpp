@@ -0,0 +1,254 @@
+#include <Arduino.h>
+#include "ConfigStore.h"
+#include "../System/StringGuard.h"
+
+void ConfigStore::begin() {
+    Serial.println("Initializing configuration store...");
+    
+    storageReady = mountStorage();
+    if (!storageReady) {
+        Serial.println("Config Store Error: Flash unavailable, using compile-time defaults");
+        return;
+    }
+    
+    unsigned long startTime = micros();
+    if (!loadLog()) {
+        // Missing, foreign or torn log: rewrite it from whatever was recovered.
+        // Until that succeeds nothing may be appended to it.
+        logTorn = !compact();
+    }
+    restoreTime = micros() - startTime;
+    
+    Serial.printf("  Restored %u values in %lu us\n", entryCount, restoreTime);
+}
+
+void ConfigStore::handle() {
+    if (hasDirtyEntries && millis() - lastChangeTime >= CONFIG_SAVE_DELAY) {
+        flush();
+    }
+}
+
+void ConfigStore::flush() {
+    if (!hasDirtyEntries || !storageReady) return;
+    
+    size_t pendingBytes = 0;
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].dirty) {
+            pendingBytes += sizeof(ConfigRecordHeader) + entries[i].length + sizeof(uint32_t);
+        }
+    }
+    
+    bool saved = logTorn || logSize + pendingBytes > CONFIG_LOG_MAX_SIZE ? compact() : appendDirtyEntries();
+    if (!saved) {
+        // Values that did not reach flash stay dirty and are retried after another quiet period
+        lastChangeTime = millis();
+    }
+}
+
+void ConfigStore::printStatus() {
+    Serial.println("Configuration Store Status:");
+    Serial.printf("  Storage: %s\n", storageReady ? "LittleFS" : "Unavailable");
+    Serial.printf("  Keys: %u/%u\n", entryCount, CONFIG_MAX_ENTRIES);
+    Serial.printf("  Log Size: %lu/%lu bytes\n", (unsigned long)logSize, (unsigned long)CONFIG_LOG_MAX_SIZE);
+    Serial.printf("  Appends: %lu, Compactions: %lu\n", (unsigned long)appendCount, (unsigned long)compactionCount);
+    if (rejectedCount > 0) Serial.printf("  Rejected Writes: %lu\n", (unsigned long)rejectedCount);
+    Serial.printf("  Boot Restore Time: %lu us\n", restoreTime);
+}
+
+bool ConfigStore::get(uint16_t key, void* value, uint8_t length) {
+    ConfigEntry* entry = findEntry(key);
+    if (entry == nullptr || entry->length != length) return false;
+    memcpy(value, entry->value, length);
+    return true;
+}
+
+bool ConfigStore::set(uint16_t key, const void* value, uint8_t length) {
+    if (length > CONFIG_VALUE_MAX) {
+        Serial.printf("Config Store Error: Value for key 0x%04x is too long\n", key);
+        rejectedCount++;
+        return false;
+    }
+    
+    ConfigEntry* entry = findEntry(key);
+    if (entry != nullptr && entry->length == length && memcmp(entry->value, value, length) == 0) {
+        return true; // Unchanged, nothing to write
+    }
+    
+    if (entry == nullptr) {
+        if (entryCount >= CONFIG_MAX_ENTRIES) {
+            Serial.printf("Config Store Error: No free entries for key 0x%04x\n", key);
+            rejectedCount++;
+            return false;
+        }
+        entry = &entries[entryCount++];
+        entry->key = key;
+    }
+    
+    entry->length = length;
+    memcpy(entry->value, value, length);
+    entry->dirty = true;
+    hasDirtyEntries = true;
+    lastChangeTime = millis();
+    return true;
+}
+
+uint32_t ConfigStore::getUInt32(uint16_t key, uint32_t defaultValue) {
+    uint32_t value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+bool ConfigStore::setUInt32(uint16_t key, uint32_t value) {
+    return set(key, &value, sizeof(value));
+}
+
+float ConfigStore::getFloat(uint16_t key, float defaultValue) {
+    float value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+bool ConfigStore::setFloat(uint16_t key, float value) {
+    return set(key, &value, sizeof(value));
+}
+
+bool ConfigStore::getString(uint16_t key, char* buffer, size_t size) {
+    ConfigEntry* entry = findEntry(key);
+    if (entry == nullptr || size == 0) return false;
+    
+    size_t length = min((size_t)entry->length, size - 1);
+    memcpy(buffer, entry->value, length);
+    buffer[length] = '\0';
+    return true;
+}
+
+bool ConfigStore::setString(uint16_t key, const char* value) {
+    return set(key, value, min(strlen(value), (size_t)CONFIG_VALUE_MAX));
+}
+
+ConfigEntry* ConfigStore::findEntry(uint16_t key) {
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].key == key) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ConfigStore::loadLog() {
+    File logFile = LittleFS.open(CONFIG_STORE_PATH, "r");
+    if (!logFile) return false;
+    
+    uint32_t magic = 0;
+    if (logFile.read((uint8_t*)&magic, sizeof(magic)) != sizeof(magic) || magic != CONFIG_STORE_MAGIC) {
+        logFile.close();
+        Serial.println("Config Store Warning: Unrecognised log, starting fresh");
+        return false;
+    }
+    
+    // Replay records in order; later records for a key replace earlier ones
+    uint32_t validLength = sizeof(magic);
+    size_t fileSize = logFile.size();
+    ConfigRecordHeader header;
+    uint8_t value[CONFIG_VALUE_MAX];
+    uint32_t storedCrc;
+    
+    while (logFile.read((uint8_t*)&header, sizeof(header)) == sizeof(header)) {
+        if (header.length > CONFIG_VALUE_MAX ||
+            logFile.read(value, header.length) != header.length ||
+            logFile.read((uint8_t*)&storedCrc, sizeof(storedCrc)) != sizeof(storedCrc)) {
+            break;
+        }
+        uint32_t crc = crc32((const uint8_t*)&header, sizeof(header));
+        crc = crc32(value, header.length, crc);
+        if (crc != storedCrc) break;
+        
+        ConfigEntry* entry = findEntry(header.key);
+        if (entry == nullptr && entryCount < CONFIG_MAX_ENTRIES) {
+            entry = &entries[entryCount++];
+            entry->key = header.key;
+        } else if (entry == nullptr) {
+            Serial.printf("Config Store Error: No free entries, key 0x%04x not restored\n", header.key);
+        }
+        if (entry != nullptr) {
+            entry->length = header.length;
+            memcpy(entry->value, value, header.length);
+            entry->dirty = false;
+        }
+        validLength += sizeof(header) + header.length + sizeof(storedCrc);
+    }
+    logFile.close();
+    
+    logSize = validLength;
+    if (validLength != fileSize) {
+        Serial.printf("Config Store Warning: Discarding torn record at offset %lu\n", (unsigned long)validLength);
+        return false;
+    }
+    return true;
+}
+
+bool ConfigStore::appendDirtyEntries() {
+    File logFile = LittleFS.open(CONFIG_STORE_PATH, "a");
+    if (!logFile) {
+        Serial.println("Config Store Error: Unable to append to log");
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (!entries[i].dirty) continue;
+        if (!writeRecord(logFile, entries[i])) {
+            // Records after a torn one would never be read back, so the next save compacts
+            logFile.close();
+            logTorn = true;
+            Serial.println("Config Store Error: Short write to log, unsaved values kept");
+            return false;
+        }
+        logSize += sizeof(ConfigRecordHeader) + entries[i].length + sizeof(uint32_t);
+        entries[i].dirty = false;
+        appendCount++;
+    }
+    logFile.close();
+    hasDirtyEntries = false;
+    return true;
+}
+
+bool ConfigStore::compact() {
+    File tempFile = LittleFS.open(CONFIG_STORE_TEMP_PATH, "w");
+    if (!tempFile) {
+        Serial.println("Config Store Error: Unable to compact log");
+        return false;
+    }
+    
+    uint32_t magic = CONFIG_STORE_MAGIC;
+    bool written = tempFile.write((const uint8_t*)&magic, sizeof(magic)) == sizeof(magic);
+    uint32_t newSize = sizeof(magic);
+    for (uint8_t i = 0; written && i < entryCount; i++) {
+        written = writeRecord(tempFile, entries[i]);
+        newSize += sizeof(ConfigRecordHeader) + entries[i].length + sizeof(uint32_t);
+    }
+    tempFile.close();
+    
+    // Rename replaces the old log atomically, so power loss keeps one intact copy.
+    // An incomplete copy is never renamed and the old log stays in place.
+    if (!written || !LittleFS.rename(CONFIG_STORE_TEMP_PATH, CONFIG_STORE_PATH)) {
+        LittleFS.remove(CONFIG_STORE_TEMP_PATH);
+        Serial.println("Config Store Error: Compaction failed, previous log kept");
+        return false;
+    }
+    for (uint8_t i = 0; i < entryCount; i++) {
+        entries[i].dirty = false;
+    }
+    logSize = newSize;
+    logTorn = false;
+    hasDirtyEntries = false;
+    compactionCount++;
+    return true;
+}
+
+bool ConfigStore::writeRecord(File& file, ConfigEntry& entry) {
+    ConfigRecordHeader header = {entry.key, entry.length, 0};
+    uint32_t crc = crc32((const uint8_t*)&header, sizeof(header));
+    crc = crc32(entry.value, entry.length, crc);
+    
+    return file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+           file.write(entry.value, entry.length) == entry.length &&
+           file.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+}
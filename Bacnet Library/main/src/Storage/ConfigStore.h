@@ -0,0 +1,85 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "Storage.h"
+#include "../config/config.h"
+
+#define CONFIG_STORE_PATH "/config.log"
+#define CONFIG_STORE_TEMP_PATH "/config.tmp"
+#define CONFIG_STORE_MAGIC 0x53474643 // "CFGS"
+#define CONFIG_VALUE_MAX 72
+#define CONFIG_MAX_ENTRIES 24
+
+// Keys of persisted values. Per-object keys add the object instance to the base.
+enum ConfigKey : uint16_t {
+    CONFIG_KEY_DEVICE_INSTANCE = 0x0001,
+    CONFIG_KEY_DEVICE_NAME = 0x0002,
+    CONFIG_KEY_OUTPUT_LED = 0x0010,
+    CONFIG_KEY_OUTPUT_BRIGHTNESS = 0x0011,
+    CONFIG_KEY_FADE_TIME = 0x0012,
+    CONFIG_KEY_THERMOSTAT_SETPOINT = 0x0020,
+    CONFIG_KEY_THERMOSTAT_MODE = 0x0021,
+    CONFIG_KEY_NTP_SERVER = 0x0030,
+    CONFIG_KEY_OBJECT_NAME = 0x0100,
+    CONFIG_KEY_COV_INCREMENT = 0x0200,
+    CONFIG_KEY_PRIORITY_ARRAY = 0x0300
+};
+
+// On-flash record header; followed by the value bytes and a CRC32 of header + value
+typedef struct {
+    uint16_t key;
+    uint8_t length;
+    uint8_t reserved;
+} ConfigRecordHeader;
+
+typedef struct {
+    uint16_t key;
+    uint8_t length;
+    bool dirty;
+    uint8_t value[CONFIG_VALUE_MAX];
+} ConfigEntry;
+
+// Append-only key-value store. Every value lives in RAM after begin();
+// set() only updates RAM and changed keys are appended to the log once
+// writes have been quiet for CONFIG_SAVE_DELAY. When the log reaches
+// CONFIG_LOG_MAX_SIZE it is compacted to one record per key. Setters return
+// false when the value is too long or a new key finds all entries in use.
+class ConfigStore {
+public:
+    void begin();
+    void handle();
+    void flush();
+    void printStatus();
+
+    bool get(uint16_t key, void* value, uint8_t length);
+    bool set(uint16_t key, const void* value, uint8_t length);
+    uint32_t getUInt32(uint16_t key, uint32_t defaultValue);
+    bool setUInt32(uint16_t key, uint32_t value);
+    float getFloat(uint16_t key, float defaultValue);
+    bool setFloat(uint16_t key, float value);
+    bool getString(uint16_t key, char* buffer, size_t size);
+    bool setString(uint16_t key, const char* value);
+
+private:
+    ConfigEntry entries[CONFIG_MAX_ENTRIES];
+    uint8_t entryCount = 0;
+    bool storageReady = false;
+    bool hasDirtyEntries = false;
+    bool logTorn = false; // A failed append left a partial record; appends stop until a compaction
+    unsigned long lastChangeTime = 0;
+    uint32_t logSize = 0;
+    uint32_t appendCount = 0;
+    uint32_t compactionCount = 0;
+    uint32_t rejectedCount = 0;
+    unsigned long restoreTime = 0;
+
+    ConfigEntry* findEntry(uint16_t key);
+    bool loadLog();
+    bool appendDirtyEntries();
+    bool compact();
+    bool writeRecord(File& file, ConfigEntry& entry);
+};
+
+#endif
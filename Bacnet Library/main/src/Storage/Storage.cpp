@@ -0,0 +1,75 @@
+#include <Arduino.h>
+#include "Storage.h"
+#include "../System/StringGuard.h"
+
+static bool storageMounted = false;
+static bool storageMountAttempted = false;
+
+bool mountStorage() {
+    if (!storageMountAttempted) {
+        storageMountAttempted = true;
+        storageMounted = LittleFS.begin();
+        if (!storageMounted) {
+            Serial.println("Storage Error: Failed to mount LittleFS");
+        }
+    }
+    return storageMounted;
+}
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+bool loadRecord(const char* path, void* data, size_t size) {
+    if (!mountStorage()) return false;
+    
+    File recordFile = LittleFS.open(path, "r");
+    if (!recordFile) return false;
+    
+    // The CRC is checked in chunks before data is touched, so no buffer the
+    // size of the record is needed
+    uint32_t header[2];
+    bool valid = recordFile.read((uint8_t*)header, sizeof(header)) == sizeof(header) &&
+                 header[0] == STORAGE_RECORD_MAGIC && header[1] == size;
+    uint32_t crc = 0;
+    uint8_t chunk[STORAGE_CHUNK_SIZE];
+    for (size_t remaining = size; valid && remaining > 0;) {
+        size_t length = min(remaining, sizeof(chunk));
+        valid = recordFile.read(chunk, length) == (int)length;
+        crc = crc32(chunk, length, crc);
+        remaining -= length;
+    }
+    uint32_t storedCrc = 0;
+    valid = valid && recordFile.read((uint8_t*)&storedCrc, sizeof(storedCrc)) == sizeof(storedCrc) && storedCrc == crc &&
+            recordFile.seek(sizeof(header), SeekSet) && recordFile.read((uint8_t*)data, size) == (int)size;
+    recordFile.close();
+    return valid;
+}
+
+bool saveRecord(const char* path, const void* data, size_t size) {
+    if (!mountStorage()) return false;
+    
+    File recordFile = LittleFS.open(path, "w");
+    if (!recordFile) {
+        Serial.printf("Storage Error: Unable to write %s\n", path);
+        return false;
+    }
+    
+    uint32_t header[2] = {STORAGE_RECORD_MAGIC, (uint32_t)size};
+    uint32_t crc = crc32((const uint8_t*)data, size);
+    bool written = recordFile.write((const uint8_t*)header, sizeof(header)) == sizeof(header) &&
+                   recordFile.write((const uint8_t*)data, size) == size &&
+                   recordFile.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+    recordFile.close();
+    if (!written) {
+        Serial.printf("Storage Error: Short write to %s\n", path);
+    }
+    return written;
+}
@@ -0,0 +1,21 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#define STORAGE_RECORD_MAGIC 0x52435244 // "RCRD"
+#define STORAGE_CHUNK_SIZE 64 // Stack buffer for checking a record
+
+// Mounts LittleFS once; later calls return the cached result
+bool mountStorage();
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+// Small fixed-size records stored as magic + size + payload + CRC32.
+// loadRecord only reads into data once the stored record has been checked
+// complete and intact, so a damaged record leaves it unchanged.
+bool loadRecord(const char* path, void* data, size_t size);
+bool saveRecord(const char* path, const void* data, size_t size);
+
+#endif
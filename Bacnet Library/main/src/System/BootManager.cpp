@@ -0,0 +1,47 @@
+#include <Arduino.h>
+#include "BootManager.h"
+#include "../System/StringGuard.h"
+
+static const char* bootPhaseNames[BOOT_PHASE_COUNT] = {
+    "Outputs Restored",
+    "BACnet Started",
+    "Services Started",
+    "Network Up",
+    "First I-Am",
+    "Cloud Synced"
+};
+
+void BootManager::markPhase(BootPhase phase) {
+    if (phaseReached[phase]) return;
+    
+    phaseReached[phase] = true;
+    phaseTimes[phase] = millis();
+    Serial.printf("Boot Phase: %s at %lu ms\n", bootPhaseNames[phase], phaseTimes[phase]);
+    
+    if (phase == BOOT_PHASE_CLOUD_SYNCED) {
+        printStatus();
+    }
+}
+
+bool BootManager::isPhaseReached(BootPhase phase) {
+    return phaseReached[phase];
+}
+
+unsigned long BootManager::getPhaseTime(BootPhase phase) {
+    return phaseTimes[phase];
+}
+
+const char* BootManager::getPhaseName(BootPhase phase) {
+    return bootPhaseNames[phase];
+}
+
+void BootManager::printStatus() {
+    Serial.println("Boot Timing Report:");
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (phaseReached[i]) {
+            Serial.printf("  %s: %lu ms\n", bootPhaseNames[i], phaseTimes[i]);
+        } else {
+            Serial.printf("  %s: Pending\n", bootPhaseNames[i]);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef BOOT_MANAGER_H
+#define BOOT_MANAGER_H
+
+#include <Arduino.h>
+
+enum BootPhase {
+    BOOT_PHASE_OUTPUTS_RESTORED,
+    BOOT_PHASE_BACNET_STARTED,
+    BOOT_PHASE_SERVICES_STARTED,
+    BOOT_PHASE_NETWORK_UP,
+    BOOT_PHASE_FIRST_IAM,
+    BOOT_PHASE_CLOUD_SYNCED,
+    BOOT_PHASE_COUNT
+};
+
+class BootManager {
+public:
+    void markPhase(BootPhase phase);
+    bool isPhaseReached(BootPhase phase);
+    unsigned long getPhaseTime(BootPhase phase);
+    const char* getPhaseName(BootPhase phase);
+    void printStatus();
+
+private:
+    // Milliseconds since reset at which each phase was first reached, 0 = pending
+    unsigned long phaseTimes[BOOT_PHASE_COUNT] = {0};
+    bool phaseReached[BOOT_PHASE_COUNT] = {false};
+};
+
+#endif
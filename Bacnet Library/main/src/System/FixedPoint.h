@@ -0,0 +1,62 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+// Q16.16 fixed-point values for sensor readings, control loops and BACnet
+// present values. The ESP8266 has no FPU, so every float add, compare and
+// multiply is a soft-float library call; on fixed_t they are single integer
+// instructions and a 32x32->64 multiply. Values are converted from float once
+// where they enter (sensor driver, wire decode, config store) and back to
+// IEEE REAL only where they leave (BACnet encode, JSON, cloud, trend records).
+//
+// Accuracy bounds:
+//   range        -32767 .. 32767
+//   resolution   2^-16 (0.0000153)
+//   conversion   fixedFromFloat is within one step (2^-16) of the float;
+//                out-of-range floats saturate and NAN maps to FIXED_INVALID
+//   fixedMul     rounded to nearest, error <= 2^-17 per multiply
+//   EMA filter   stays within 1.5 * 2^-16 / alpha of the exact filter
+//                (0.00008 C at TEMPERATURE_FILTER_ALPHA 0.3, against the
+//                DHT11's 1 C resolution)
+typedef int32_t fixed_t;
+
+#define FIXED_FRACTION_BITS 16
+#define FIXED_ONE ((fixed_t)1 << FIXED_FRACTION_BITS)
+#define FIXED_INVALID INT32_MIN // Stands in for NAN: no valid reading yet
+#define FIXED_MAX INT32_MAX
+#define FIXED_MIN (INT32_MIN + 1)
+
+constexpr fixed_t fixedFromFloat(float value) {
+    return value != value ? FIXED_INVALID
+         : value >= 32767.0f ? FIXED_MAX
+         : value <= -32767.0f ? FIXED_MIN
+         : (fixed_t)(value * FIXED_ONE + (value >= 0 ? 0.5f : -0.5f));
+}
+
+constexpr float fixedToFloat(fixed_t value) {
+    return (float)value / FIXED_ONE;
+}
+
+constexpr fixed_t fixedFromInt(int32_t value) {
+    return value * FIXED_ONE;
+}
+
+// Rounds to the nearest integer
+constexpr int32_t fixedToInt(fixed_t value) {
+    return (value + (FIXED_ONE >> 1)) >> FIXED_FRACTION_BITS;
+}
+
+constexpr fixed_t fixedMul(fixed_t a, fixed_t b) {
+    return (fixed_t)(((int64_t)a * b + (FIXED_ONE >> 1)) >> FIXED_FRACTION_BITS);
+}
+
+constexpr fixed_t fixedAbs(fixed_t value) {
+    return value < 0 ? -value : value;
+}
+
+constexpr bool fixedIsValid(fixed_t value) {
+    return value != FIXED_INVALID;
+}
+
+#endif
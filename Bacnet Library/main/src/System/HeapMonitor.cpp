@@ -0,0 +1,33 @@
+#include <Arduino.h>
+#include "HeapMonitor.h"
+#include "StringGuard.h"
+
+void HeapMonitor::handle() {
+    if (lastSampleTime == 0 || millis() - lastSampleTime >= HEAP_SAMPLE_INTERVAL) {
+        sample();
+    }
+}
+
+void HeapMonitor::printStatus() {
+    sample();
+    Serial.println("Heap Status:");
+    Serial.printf("  Free: %lu bytes (lowest %lu)\n", (unsigned long)freeHeap, (unsigned long)minFreeHeap);
+    Serial.printf("  Largest Block: %lu bytes (lowest %lu)\n", (unsigned long)largestFreeBlock,
+                  (unsigned long)minLargestFreeBlock);
+    Serial.printf("  Fragmentation: %u%%\n", fragmentation);
+}
+
+uint32_t HeapMonitor::getFreeHeap() { return freeHeap; }
+uint32_t HeapMonitor::getLargestFreeBlock() { return largestFreeBlock; }
+uint8_t HeapMonitor::getFragmentation() { return fragmentation; }
+uint32_t HeapMonitor::getMinFreeHeap() { return minFreeHeap; }
+uint32_t HeapMonitor::getMinLargestFreeBlock() { return minLargestFreeBlock; }
+
+void HeapMonitor::sample() {
+    lastSampleTime = millis();
+    uint16_t largest = 0;
+    ESP.getHeapStats(&freeHeap, &largest, &fragmentation);
+    largestFreeBlock = largest;
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+    if (largestFreeBlock < minLargestFreeBlock) minLargestFreeBlock = largestFreeBlock;
+}
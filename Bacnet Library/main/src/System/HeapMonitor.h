@@ -0,0 +1,32 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Tracks free heap and the largest free block. The low-water marks cover
+// the whole uptime, so a long run shows whether fragmentation creeps up
+// until the TLS buffers can no longer be allocated.
+class HeapMonitor {
+public:
+    void handle();
+    void printStatus();
+
+    uint32_t getFreeHeap();
+    uint32_t getLargestFreeBlock();
+    uint8_t getFragmentation(); // Percent, 0 = all free memory in one block
+    uint32_t getMinFreeHeap();
+    uint32_t getMinLargestFreeBlock();
+
+private:
+    unsigned long lastSampleTime = 0;
+    uint32_t freeHeap = 0;
+    uint32_t largestFreeBlock = 0;
+    uint8_t fragmentation = 0;
+    uint32_t minFreeHeap = UINT32_MAX;
+    uint32_t minLargestFreeBlock = UINT32_MAX;
+
+    void sample();
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef STRING_GUARD_H
+#define STRING_GUARD_H
+
+// Included last by translation units that run on steady-state paths (the
+// loop, packet handling, HTTP routing and cloud sync). With
+// STRING_FREE_BUILD defined in config.h any use of the Arduino String class
+// after this point fails to compile, so these paths cannot fragment the heap
+// with temporaries. Format with Serial.printf and fixed buffers instead.
+
+#include "../config/config.h"
+
+#define IP_FORMAT "%u.%u.%u.%u"
+#define IP_ARGS(ip) (ip)[0], (ip)[1], (ip)[2], (ip)[3]
+
+#ifdef STRING_FREE_BUILD
+#pragma GCC poison String
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <coredecls.h>
+#include <sys/time.h>
+#include "TimeService.h"
+#include "../System/StringGuard.h"
+
+static const char* timeSourceNames[] = {"none", "sntp", "bacnet"};
+
+void TimeService::begin(ConfigStore* store) {
+    configStore = store;
+    if (configStore != nullptr) {
+        configStore->getString(CONFIG_KEY_NTP_SERVER, server, sizeof(server));
+    }
+
+    // lwIP calls back from its own context, so only flag the update here
+    settimeofday_cb([this](bool fromSntp) {
+        if (fromSntp) sntpPending = true;
+    });
+    startSntp();
+}
+
+void TimeService::handle() {
+    if (!sntpPending) return;
+    sntpPending = false;
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    if (now.tv_sec < TIME_MIN_VALID_EPOCH) return;
+    synchronize((uint64_t)now.tv_sec * 1000000 + now.tv_usec, TIME_SOURCE_SNTP);
+}
+
+void TimeService::printStatus() {
+    Serial.println("Time Service Status:");
+    Serial.printf("  Uptime: %lu s\n", (unsigned long)uptimeSeconds());
+    if (!isSynchronized()) {
+        Serial.printf("  Clock: Not synchronized (server %s)\n", server);
+        return;
+    }
+    struct tm local;
+    char text[24];
+    getLocalTime(&local);
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    Serial.printf("  Local Time: %s\n", text);
+    Serial.printf("  Source: %s, %lu syncs, last correction %lld us\n", getSourceName(source), (unsigned long)syncCount,
+                  (long long)lastCorrection);
+}
+
+uint64_t TimeService::monotonicMicros() {
+    return micros64();
+}
+
+uint32_t TimeService::uptimeSeconds() {
+    return micros64() / 1000000;
+}
+
+bool TimeService::isSynchronized() {
+    return source != TIME_SOURCE_NONE;
+}
+
+uint64_t TimeService::epochMicros() {
+    if (!isSynchronized()) return 0;
+    return epochAt(micros64());
+}
+
+uint32_t TimeService::epochSeconds() {
+    return epochMicros() / 1000000;
+}
+
+bool TimeService::getLocalTime(struct tm* local) {
+    if (!isSynchronized()) return false;
+    time_t seconds = epochSeconds();
+    localtime_r(&seconds, local);
+    return true;
+}
+
+// Converts a wall-clock reading in the local zone, given as seconds in the
+// same civil encoding as the epoch, to UTC epoch seconds
+uint32_t TimeService::localToEpoch(uint32_t localSeconds) {
+    time_t civil = localSeconds;
+    struct tm fields;
+    gmtime_r(&civil, &fields);
+    fields.tm_isdst = -1;
+    return mktime(&fields);
+}
+
+void TimeService::synchronize(uint64_t epoch, TimeSource from) {
+    uint64_t now = micros64();
+    uint64_t current = epochAt(now);
+    int64_t offset = isSynchronized() ? (int64_t)(epoch - current) : 0;
+
+    if (!isSynchronized() || offset > TIME_STEP_THRESHOLD || offset < -TIME_STEP_THRESHOLD) {
+        baseEpoch = epoch;
+        slewTotal = 0;
+        slewDuration = 0;
+        Serial.printf("Time Synchronized: Clock set from %s\n", getSourceName(from));
+    } else {
+        // Restart the slew from the current estimate so the clock stays continuous
+        baseEpoch = current;
+        slewTotal = offset;
+        slewDuration = (uint64_t)(offset < 0 ? -offset : offset) * 1000000 / TIME_SLEW_RATE;
+    }
+    baseMonotonic = now;
+    lastCorrection = offset;
+    source = from;
+    syncCount++;
+}
+
+void TimeService::setServer(const char* name) {
+    if (name[0] == '\0' || strcmp(name, server) == 0) return;
+
+    strncpy(server, name, sizeof(server) - 1);
+    server[sizeof(server) - 1] = '\0';
+    if (configStore != nullptr) {
+        configStore->setString(CONFIG_KEY_NTP_SERVER, server);
+    }
+    startSntp();
+}
+
+const char* TimeService::getServer() { return server; }
+TimeSource TimeService::getSource() { return source; }
+int64_t TimeService::getLastCorrection() { return lastCorrection; }
+
+const char* TimeService::getSourceName(TimeSource value) {
+    return value <= TIME_SOURCE_BACNET ? timeSourceNames[value] : "unknown";
+}
+
+uint64_t TimeService::epochAt(uint64_t monotonic) {
+    uint64_t elapsed = monotonic - baseMonotonic;
+    if (elapsed >= slewDuration) {
+        return baseEpoch + elapsed + slewTotal;
+    }
+    return baseEpoch + elapsed + slewTotal * (int64_t)elapsed / (int64_t)slewDuration;
+}
+
+void TimeService::startSntp() {
+    configTime(TIME_ZONE, server);
+    Serial.printf("Time Service: SNTP server %s, zone %s\n", server, TIME_ZONE);
+}
@@ -0,0 +1,62 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "../config/config.h"
+#include "../Storage/ConfigStore.h"
+
+#define TIME_SERVER_NAME_MAX 48
+
+enum TimeSource : uint8_t {
+    TIME_SOURCE_NONE,
+    TIME_SOURCE_SNTP,
+    TIME_SOURCE_BACNET
+};
+
+// Single time base for the controller. Intervals come from the 64-bit
+// microsecond counter, which does not wrap. Wall-clock time is that counter
+// plus an offset learned from SNTP or BACnet TimeSynchronization. Small
+// corrections are slewed in at TIME_SLEW_RATE so timestamps never go
+// backwards. Only the first sync or an error beyond TIME_STEP_THRESHOLD
+// steps the clock.
+class TimeService {
+public:
+    void begin(ConfigStore* store);
+    void handle();
+    void printStatus();
+
+    uint64_t monotonicMicros();
+    uint32_t uptimeSeconds();
+    bool isSynchronized();
+    uint64_t epochMicros();
+    uint32_t epochSeconds(); // 0 until synchronized
+    bool getLocalTime(struct tm* local);
+    uint32_t localToEpoch(uint32_t localSeconds);
+
+    void synchronize(uint64_t epoch, TimeSource source);
+    void setServer(const char* server);
+    const char* getServer();
+    TimeSource getSource();
+    const char* getSourceName(TimeSource value);
+    int64_t getLastCorrection();
+
+private:
+    ConfigStore* configStore = nullptr;
+    char server[TIME_SERVER_NAME_MAX] = NTP_SERVER;
+    volatile bool sntpPending = false;
+    TimeSource source = TIME_SOURCE_NONE;
+    uint32_t syncCount = 0;
+
+    // epoch = baseEpoch + elapsed + slewTotal * min(elapsed / slewDuration, 1)
+    uint64_t baseMonotonic = 0;
+    uint64_t baseEpoch = 0;
+    int64_t slewTotal = 0;
+    uint64_t slewDuration = 0;
+    int64_t lastCorrection = 0; // Microseconds; a step can exceed 32 bits (over 35 minutes)
+
+    uint64_t epochAt(uint64_t monotonic);
+    void startSntp();
+};
+
+#endif
@@ -0,0 +1,311 @@
+#include <Arduino.h>
+#include "TrendLogManager.h"
+#include "../System/StringGuard.h"
+
+void TrendLogManager::begin(TimeService* clock) {
+    timeService = clock;
+    Serial.println("Initializing Trend Log storage...");
+
+    if (!mountStorage()) {
+        Serial.println("Trend Log Error: Failed to mount LittleFS, logging to RAM tail only");
+        return;
+    }
+    storageReady = true;
+
+    if (!LittleFS.exists("/trend")) {
+        LittleFS.mkdir("/trend");
+    }
+
+    // Until the wall clock is synchronized, continue from the newest stored
+    // record so timestamps stay monotonic across reboots and time searches remain valid
+    for (uint8_t i = 0; i < TREND_LOG_COUNT; i++) {
+        if (!openLog(channels[i])) {
+            createLog(channels[i]);
+        }
+        channels[i].nextSequence = channels[i].header.lastSequence + 1;
+        if (channels[i].header.lastTimestamp > lastTimestamp) {
+            lastTimestamp = channels[i].header.lastTimestamp;
+        }
+        Serial.printf("  %s: %lu records restored\n", channels[i].object_name, (unsigned long)channels[i].header.count);
+    }
+    clockOffset = lastTimestamp + 1;
+}
+
+void TrendLogManager::handle(fixed_t temperature, fixed_t humidity) {
+    unsigned long currentTime = millis();
+
+    if (currentTime - lastSampleTime >= TREND_LOG_INTERVAL) {
+        lastSampleTime = currentTime;
+        if (fixedIsValid(temperature)) appendRecord(channels[0], temperature);
+        if (fixedIsValid(humidity)) appendRecord(channels[1], humidity);
+    }
+
+    if (currentTime - lastFlushTime >= TREND_FLUSH_INTERVAL) {
+        flush();
+    }
+}
+
+void TrendLogManager::flush() {
+    lastFlushTime = millis();
+    for (uint8_t i = 0; i < TREND_LOG_COUNT; i++) {
+        flushChannel(channels[i]);
+    }
+}
+
+void TrendLogManager::printStatus() {
+    Serial.println("Trend Log Status:");
+    Serial.printf("  Storage: %s\n", storageReady ? "LittleFS" : "Unavailable");
+    for (uint8_t i = 0; i < TREND_LOG_COUNT; i++) {
+        Serial.printf("  %s: %lu/%u records (%u pending, %lu dropped)\n", channels[i].object_name,
+                      (unsigned long)visibleCount(channels[i]), TREND_LOG_CAPACITY, channels[i].tailCount,
+                      (unsigned long)channels[i].droppedCount);
+    }
+}
+
+bool TrendLogManager::hasLog(uint32_t instance) {
+    return findChannel(instance) != nullptr;
+}
+
+const char* TrendLogManager::getObjectName(uint32_t instance) {
+    TrendLogChannel* channel = findChannel(instance);
+    return channel ? channel->object_name : "";
+}
+
+uint32_t TrendLogManager::getRecordCount(uint32_t instance) {
+    TrendLogChannel* channel = findChannel(instance);
+    return channel ? visibleCount(*channel) : 0;
+}
+
+uint32_t TrendLogManager::getTotalRecordCount(uint32_t instance) {
+    TrendLogChannel* channel = findChannel(instance);
+    return channel ? channel->nextSequence - 1 : 0;
+}
+
+uint32_t TrendLogManager::getFirstSequence(uint32_t instance) {
+    TrendLogChannel* channel = findChannel(instance);
+    if (channel == nullptr) return 0;
+    return channel->nextSequence - visibleCount(*channel);
+}
+
+uint32_t TrendLogManager::getBufferSize() {
+    return TREND_LOG_CAPACITY;
+}
+
+uint16_t TrendLogManager::readRecords(uint32_t instance, uint32_t index, TrendRecord* records, uint16_t maxCount) {
+    TrendLogChannel* channel = findChannel(instance);
+    if (channel == nullptr) return 0;
+
+    uint32_t total = visibleCount(*channel);
+    if (index >= total) return 0;
+    if (maxCount > total - index) maxCount = total - index;
+
+    uint32_t flashCount = flashVisibleCount(*channel);
+    uint16_t copied = 0;
+
+    // Records still in flash, read in contiguous runs around the ring wrap.
+    // A failed open or short read ends the batch with what was copied so far,
+    // since the RAM tail only continues after the last flash record.
+    if (index < flashCount) {
+        if (!storageReady) return 0;
+        File logFile = LittleFS.open(channel->path, "r");
+        if (!logFile) {
+            Serial.printf("Trend Log Error: Unable to open %s\n", channel->path);
+            return 0;
+        }
+        uint32_t oldest = (channel->header.head + TREND_LOG_CAPACITY - flashCount) % TREND_LOG_CAPACITY;
+        while (copied < maxCount && index + copied < flashCount) {
+            uint32_t position = (oldest + index + copied) % TREND_LOG_CAPACITY;
+            uint32_t run = TREND_LOG_CAPACITY - position;
+            if (run > flashCount - (index + copied)) run = flashCount - (index + copied);
+            if (run > (uint32_t)(maxCount - copied)) run = maxCount - copied;
+
+            int wanted = run * sizeof(TrendRecord);
+            int got = logFile.seek(sizeof(TrendLogHeader) + position * sizeof(TrendRecord), SeekSet)
+                          ? logFile.read((uint8_t*)&records[copied], wanted) : -1;
+            if (got != wanted) {
+                Serial.printf("Trend Log Error: Short read of %s at record %lu\n", channel->path, (unsigned long)position);
+                logFile.close();
+                return copied + (got > 0 ? got / sizeof(TrendRecord) : 0);
+            }
+            copied += run;
+        }
+        logFile.close();
+    }
+
+    // Remaining records come from the RAM tail
+    while (copied < maxCount) {
+        records[copied] = channel->tail[index + copied - flashCount];
+        copied++;
+    }
+
+    return copied;
+}
+
+uint32_t TrendLogManager::findIndexByTime(uint32_t instance, uint32_t timestamp) {
+    // Lower bound: first record with a timestamp at or after the requested time
+    uint32_t low = 0;
+    uint32_t high = getRecordCount(instance);
+    TrendRecord record;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (readRecords(instance, mid, &record, 1) == 1 && record.timestamp < timestamp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint32_t TrendLogManager::now() {
+    uint32_t timestamp = timeService->isSynchronized() ? timeService->epochSeconds()
+                                                       : clockOffset + timeService->uptimeSeconds();
+    // A clock step backwards holds the timestamp rather than reordering the log
+    if (timestamp < lastTimestamp) timestamp = lastTimestamp;
+    lastTimestamp = timestamp;
+    return timestamp;
+}
+
+TrendLogChannel* TrendLogManager::findChannel(uint32_t instance) {
+    for (uint8_t i = 0; i < TREND_LOG_COUNT; i++) {
+        if (channels[i].object_instance == instance) {
+            return &channels[i];
+        }
+    }
+    return nullptr;
+}
+
+bool TrendLogManager::openLog(TrendLogChannel& channel) {
+    File logFile = LittleFS.open(channel.path, "r");
+    if (!logFile) return false;
+
+    bool valid = logFile.read((uint8_t*)&channel.header, sizeof(TrendLogHeader)) == sizeof(TrendLogHeader) &&
+                 channel.header.magic == TREND_LOG_MAGIC &&
+                 channel.header.version == TREND_LOG_VERSION &&
+                 channel.header.capacity == TREND_LOG_CAPACITY &&
+                 channel.header.head < TREND_LOG_CAPACITY &&
+                 channel.header.count <= TREND_LOG_CAPACITY;
+    logFile.close();
+
+    if (!valid) {
+        Serial.printf("Trend Log Warning: Discarding incompatible log %s\n", channel.path);
+    }
+    return valid;
+}
+
+bool TrendLogManager::createLog(TrendLogChannel& channel) {
+    memset(&channel.header, 0, sizeof(TrendLogHeader));
+    channel.header.magic = TREND_LOG_MAGIC;
+    channel.header.version = TREND_LOG_VERSION;
+    channel.header.capacity = TREND_LOG_CAPACITY;
+
+    File logFile = LittleFS.open(channel.path, "w");
+    if (!logFile) {
+        Serial.printf("Trend Log Error: Unable to create %s\n", channel.path);
+        return false;
+    }
+
+    // Preallocate the whole ring once so later flushes only overwrite in place
+    bool written = logFile.write((const uint8_t*)&channel.header, sizeof(TrendLogHeader)) == sizeof(TrendLogHeader);
+    TrendRecord blank[TREND_LOG_TAIL_SIZE];
+    memset(blank, 0, sizeof(blank));
+    for (uint32_t filled = 0; written && filled < TREND_LOG_CAPACITY; filled += TREND_LOG_TAIL_SIZE) {
+        uint32_t run = TREND_LOG_CAPACITY - filled;
+        if (run > TREND_LOG_TAIL_SIZE) run = TREND_LOG_TAIL_SIZE;
+        written = logFile.write((const uint8_t*)blank, run * sizeof(TrendRecord)) == run * sizeof(TrendRecord);
+        yield();
+    }
+    logFile.close();
+    if (!written) {
+        // A truncated ring would fail every flush; leave no file so the next boot retries
+        LittleFS.remove(channel.path);
+        Serial.printf("Trend Log Error: Short write creating %s\n", channel.path);
+        return false;
+    }
+
+    Serial.printf("Trend Log Created: %s\n", channel.path);
+    return true;
+}
+
+void TrendLogManager::appendRecord(TrendLogChannel& channel, fixed_t value) {
+    // A failed flush leaves the tail full: the oldest pending sample makes
+    // room, and the ones after it take over its sequence number so the log
+    // stays contiguous for ReadRange by sequence
+    if (channel.tailCount >= TREND_LOG_TAIL_SIZE) {
+        memmove(&channel.tail[0], &channel.tail[1], sizeof(TrendRecord) * (TREND_LOG_TAIL_SIZE - 1));
+        channel.tailCount--;
+        for (uint8_t i = 0; i < channel.tailCount; i++) {
+            channel.tail[i].sequence--;
+        }
+        channel.nextSequence--;
+        channel.droppedCount++;
+    }
+
+    TrendRecord& record = channel.tail[channel.tailCount++];
+    record.sequence = channel.nextSequence++;
+    record.timestamp = now();
+    record.value = fixedToFloat(value); // Flash records keep the IEEE layout
+
+    // Coalesce writes in RAM and only touch flash once the tail is full
+    if (channel.tailCount >= TREND_LOG_TAIL_SIZE) {
+        flushChannel(channel);
+    }
+}
+
+bool TrendLogManager::flushChannel(TrendLogChannel& channel) {
+    if (channel.tailCount == 0) return true;
+    if (!storageReady) {
+        // Without flash keep the newest samples only
+        channel.tailCount = 0;
+        return false;
+    }
+
+    File logFile = LittleFS.open(channel.path, "r+");
+    if (!logFile) {
+        Serial.printf("Trend Log Error: Unable to open %s\n", channel.path);
+        return false;
+    }
+
+    // Records first, then the header that makes them visible. The header in
+    // RAM only advances once both are on flash; on failure the tail is kept
+    // and the next flush rewrites the same slots.
+    TrendLogHeader updated = channel.header;
+    bool written = true;
+    uint8_t flushed = 0;
+    while (written && flushed < channel.tailCount) {
+        uint32_t run = TREND_LOG_CAPACITY - updated.head;
+        if (run > (uint32_t)(channel.tailCount - flushed)) run = channel.tailCount - flushed;
+
+        size_t bytes = run * sizeof(TrendRecord);
+        written = logFile.seek(sizeof(TrendLogHeader) + updated.head * sizeof(TrendRecord), SeekSet) &&
+                  logFile.write((const uint8_t*)&channel.tail[flushed], bytes) == bytes;
+
+        updated.head = (updated.head + run) % TREND_LOG_CAPACITY;
+        flushed += run;
+    }
+
+    updated.count = min((uint32_t)updated.count + channel.tailCount, (uint32_t)TREND_LOG_CAPACITY);
+    updated.lastSequence = channel.tail[channel.tailCount - 1].sequence;
+    updated.lastTimestamp = channel.tail[channel.tailCount - 1].timestamp;
+    written = written && logFile.seek(0, SeekSet) &&
+              logFile.write((const uint8_t*)&updated, sizeof(TrendLogHeader)) == sizeof(TrendLogHeader);
+    logFile.close();
+
+    if (!written) {
+        Serial.printf("Trend Log Error: Short write to %s, %u records kept in RAM\n", channel.path, channel.tailCount);
+        return false;
+    }
+    channel.header = updated;
+    channel.tailCount = 0;
+    return true;
+}
+
+uint32_t TrendLogManager::visibleCount(TrendLogChannel& channel) {
+    return min((uint32_t)channel.header.count + channel.tailCount, (uint32_t)TREND_LOG_CAPACITY);
+}
+
+uint32_t TrendLogManager::flashVisibleCount(TrendLogChannel& channel) {
+    // Flash records about to be overwritten by the pending tail are hidden
+    return visibleCount(channel) - channel.tailCount;
+}
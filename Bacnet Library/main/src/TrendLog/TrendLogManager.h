@@ -0,0 +1,84 @@
+#ifndef TREND_LOG_MANAGER_H
+#define TREND_LOG_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "../config/config.h"
+#include "../Storage/Storage.h"
+#include "../System/TimeService.h"
+#include "../System/FixedPoint.h"
+
+#define TREND_LOG_COUNT 2
+#define TREND_LOG_MAGIC 0x544C4F47 // "TLOG"
+#define TREND_LOG_VERSION 1
+
+// Fixed-size log record as stored in flash (12 bytes)
+typedef struct {
+    uint32_t sequence;
+    uint32_t timestamp;
+    float value;
+} TrendRecord;
+
+// Ring buffer header stored at the start of each log file
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t capacity;
+    uint16_t head;
+    uint16_t count;
+    uint32_t lastSequence;
+    uint32_t lastTimestamp;
+} TrendLogHeader;
+
+typedef struct {
+    uint32_t object_instance;
+    const char* object_name;
+    const char* path;
+    TrendLogHeader header;
+    TrendRecord tail[TREND_LOG_TAIL_SIZE];
+    uint8_t tailCount;
+    uint32_t nextSequence;
+    uint32_t droppedCount; // Samples lost while flash could not be written
+} TrendLogChannel;
+
+class TrendLogManager {
+public:
+    void begin(TimeService* clock);
+    void handle(fixed_t temperature, fixed_t humidity);
+    void flush();
+    void printStatus();
+
+    // Accessors used by BACnet ReadRange and the HTTP trend endpoint.
+    // Record indexes are 0-based, oldest record first.
+    bool hasLog(uint32_t instance);
+    const char* getObjectName(uint32_t instance);
+    uint32_t getRecordCount(uint32_t instance);
+    uint32_t getTotalRecordCount(uint32_t instance);
+    uint32_t getFirstSequence(uint32_t instance);
+    uint32_t getBufferSize();
+    uint16_t readRecords(uint32_t instance, uint32_t index, TrendRecord* records, uint16_t maxCount);
+    uint32_t findIndexByTime(uint32_t instance, uint32_t timestamp);
+    uint32_t now();
+
+private:
+    TrendLogChannel channels[TREND_LOG_COUNT] = {
+        {TRENDLOG_TEMPERATURE_ID, "Temperature_Log", "/trend/temperature.bin"},
+        {TRENDLOG_HUMIDITY_ID, "Humidity_Log", "/trend/humidity.bin"}
+    };
+    TimeService* timeService = nullptr;
+    bool storageReady = false;
+    uint32_t clockOffset = 0;
+    uint32_t lastTimestamp = 0;
+    unsigned long lastSampleTime = 0;
+    unsigned long lastFlushTime = 0;
+
+    TrendLogChannel* findChannel(uint32_t instance);
+    bool openLog(TrendLogChannel& channel);
+    bool createLog(TrendLogChannel& channel);
+    void appendRecord(TrendLogChannel& channel, fixed_t value);
+    bool flushChannel(TrendLogChannel& channel);
+    uint32_t visibleCount(TrendLogChannel& channel);
+    uint32_t flashVisibleCount(TrendLogChannel& channel);
+};
+
+#endif
@@ -0,0 +1,428 @@
+#include <Arduino.h>
+#include "WebServerManager.h"
+#include "../System/StringGuard.h"
+
+static bool isRoute(const char* request, const char* route) {
+    return strncmp(request, route, strlen(route)) == 0;
+}
+
+// Writes text as the contents of a JSON string: quotes, backslashes and
+// control characters are escaped
+static void printJsonString(Print& output, const char* text) {
+    for (; *text != '\0'; text++) {
+        uint8_t character = *text;
+        if (character == '"' || character == '\\') {
+            output.write('\\');
+            output.write(character);
+        } else if (character < 0x20) {
+            output.printf("\\u%04x", character);
+        } else {
+            output.write(character);
+        }
+    }
+}
+
+void WebServerManager::begin() {
+    server.begin();
+    Serial.printf("HTTP API Started on Port %u\n", WEB_SERVER_PORT);
+}
+
+void WebServerManager::handleClient() {
+    WiFiClient client = server.available();
+    if (!client) return;
+    
+    // Wait briefly for the request line so the control loop is not held up
+    unsigned long requestStart = millis();
+    while (!client.available() && millis() - requestStart < HTTP_REQUEST_TIMEOUT) {
+        delay(1);
+    }
+    
+    if (!client.available()) {
+        client.stop();
+        return;
+    }
+    
+    // Later parts of the request may arrive in further TCP segments
+    client.setTimeout(HTTP_REQUEST_TIMEOUT);
+    char request[HTTP_REQUEST_LINE_MAX];
+    readLine(client, request, sizeof(request));
+    
+    Serial.printf("HTTP Request: %s\n", request);
+    
+    if (isRoute(request, "GET /api/trend")) {
+        sendTrendLog(client, request);
+    } else if (isRoute(request, "GET /api/boot")) {
+        sendBootTimings(client);
+    } else if (isRoute(request, "GET /api/time")) {
+        sendTime(client);
+    } else if (isRoute(request, "GET /api/metrics")) {
+        sendMetrics(client);
+    } else if (isRoute(request, "GET /api/config")) {
+        sendConfiguration(client);
+    } else if (isRoute(request, "POST /api/config")) {
+        updateConfiguration(client, request);
+    } else if (isRoute(request, "GET /api/thermostat")) {
+        sendThermostat(client);
+    } else if (isRoute(request, "POST /api/thermostat")) {
+        updateThermostat(client, request);
+    } else if (isRoute(request, "GET /api/rules")) {
+        sendRules(client);
+    } else if (isRoute(request, "POST /api/rules")) {
+        updateRules(client);
+    } else {
+        sendResponseHeader(client, "404 Not Found", "text/plain");
+        client.println("404 - Page Not Found");
+    }
+    
+    delay(1);
+    client.stop();
+}
+
+// GET /api/trend?object=<instance>&start=<index>&count=<n>
+// Streams one page of records, oldest first, as [sequence, timestamp, value] tuples.
+void WebServerManager::sendTrendLog(WiFiClient& client, const char* request) {
+    uint32_t instance = getQueryParameter(request, "object", TRENDLOG_TEMPERATURE_ID);
+    long start = getQueryParameter(request, "start", 0);
+    long count = getQueryParameter(request, "count", HTTP_TREND_PAGE_MAX);
+    
+    if (!trendLogManager->hasLog(instance) || start < 0 || count <= 0) {
+        sendResponseHeader(client, "400 Bad Request", "application/json");
+        client.println("{\"status\":\"error\",\"message\":\"Unknown trend log or invalid range\"}");
+        return;
+    }
+    if (count > HTTP_TREND_PAGE_MAX) count = HTTP_TREND_PAGE_MAX;
+    
+    uint32_t total = trendLogManager->getRecordCount(instance);
+    
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.printf("{\"object\":%lu,\"name\":\"", (unsigned long)instance);
+    printJsonString(client, trendLogManager->getObjectName(instance));
+    client.printf("\",\"total\":%lu,\"firstSequence\":%lu,\"start\":%ld,\"records\":[",
+                  (unsigned long)total, (unsigned long)trendLogManager->getFirstSequence(instance), start);
+    
+    TrendRecord records[16];
+    uint32_t index = start;
+    uint32_t end = min((uint32_t)(start + count), total);
+    bool first = true;
+    while (index < end) {
+        uint16_t batch = trendLogManager->readRecords(instance, index, records, min(end - index, (uint32_t)16));
+        if (batch == 0) break;
+        for (uint16_t i = 0; i < batch; i++) {
+            client.printf("%s[%lu,%lu,%.2f]", first ? "" : ",", (unsigned long)records[i].sequence,
+                          (unsigned long)records[i].timestamp, records[i].value);
+            first = false;
+        }
+        index += batch;
+        yield();
+    }
+    
+    if (index < total) {
+        client.printf("],\"next\":%lu}\n", (unsigned long)index);
+    } else {
+        client.print("],\"next\":null}\n");
+    }
+}
+
+// GET /api/boot - milliseconds since reset at which each boot phase completed
+void WebServerManager::sendBootTimings(WiFiClient& client) {
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.print("{");
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        BootPhase phase = (BootPhase)i;
+        if (bootManager->isPhaseReached(phase)) {
+            client.printf("%s\"%s\":%lu", i ? "," : "", bootManager->getPhaseName(phase), bootManager->getPhaseTime(phase));
+        } else {
+            client.printf("%s\"%s\":null", i ? "," : "", bootManager->getPhaseName(phase));
+        }
+    }
+    client.print("}\n");
+}
+
+// GET /api/time - wall clock and its synchronization state
+void WebServerManager::sendTime(WiFiClient& client) {
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.printf("{\"uptime\":%lu,\"synchronized\":%s,\"source\":\"%s\",\"server\":\"",
+                  (unsigned long)timeService->uptimeSeconds(), timeService->isSynchronized() ? "true" : "false",
+                  timeService->getSourceName(timeService->getSource()));
+    printJsonString(client, timeService->getServer());
+    client.print("\"");
+    if (timeService->isSynchronized()) {
+        client.printf(",\"epoch\":%lu,\"lastCorrection\":%lld", (unsigned long)timeService->epochSeconds(),
+                      (long long)timeService->getLastCorrection());
+    }
+    client.print("}\n");
+}
+
+// GET /api/metrics - heap health and traffic counters of the BACnet service
+void WebServerManager::sendMetrics(WiFiClient& client) {
+    BACnetAdmission& admission = bacnetProtocol->getAdmission();
+    const BACnetAdmissionStats& stats = admission.getStats();
+
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.printf("{\"bacnet\":{\"malformed\":%lu,\"admitted\":%lu,\"sources\":%u,\"evictions\":%lu,"
+                  "\"throttleEvents\":%lu,\"retriesAnswered\":%lu,\"dropped\":{",
+                  (unsigned long)bacnetProtocol->getRejectedFrames(), (unsigned long)stats.admitted,
+                  admission.getSourceCount(), (unsigned long)stats.evictions, (unsigned long)stats.throttleEvents,
+                  (unsigned long)bacnetProtocol->getRetriesAnswered());
+    for (uint8_t i = 0; i < BACNET_CLASS_COUNT; i++) {
+        client.printf("%s\"%s\":%lu", i ? "," : "", BACnetAdmission::getClassName((BACnetServiceClass)i),
+                      (unsigned long)stats.dropped[i]);
+    }
+    client.printf("}},\"heap\":{\"free\":%lu,\"largestBlock\":%lu,\"fragmentation\":%u,\"minFree\":%lu,"
+                  "\"minLargestBlock\":%lu}}\n",
+                  (unsigned long)heapMonitor->getFreeHeap(), (unsigned long)heapMonitor->getLargestFreeBlock(),
+                  heapMonitor->getFragmentation(), (unsigned long)heapMonitor->getMinFreeHeap(),
+                  (unsigned long)heapMonitor->getMinLargestFreeBlock());
+}
+
+// GET /api/config - runtime BACnet configuration held in the config store
+void WebServerManager::sendConfiguration(WiFiClient& client) {
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.printf("{\"deviceInstance\":%lu,\"fadeTime\":%lu,\"ntpServer\":\"",
+                  (unsigned long)bacnetProtocol->getDeviceInstance(), (unsigned long)deviceManager->getFadeTime());
+    printJsonString(client, timeService->getServer());
+    client.print("\",\"objects\":[");
+    for (uint8_t i = 0; i < bacnetProtocol->getObjectCount(); i++) {
+        BACnetObject* object = bacnetProtocol->getObject(i);
+        client.printf("%s{\"type\":%u,\"instance\":%lu,\"name\":\"", i ? "," : "", object->object_type,
+                      (unsigned long)object->object_id);
+        printJsonString(client, object->object_name);
+        client.print("\"");
+        if (object->object_type == OBJECT_ANALOG_INPUT || object->object_type == OBJECT_ANALOG_OUTPUT) {
+            client.printf(",\"covIncrement\":%.2f", fixedToFloat(object->cov_increment));
+        }
+        client.print("}");
+    }
+    client.print("]}\n");
+}
+
+// POST /api/config?deviceInstance=<n>&deviceName=<s>&fadeTime=<ms>&ntpServer=<host>&name<instance>=<s>&cov<instance>=<x>
+// Parameters are taken from the query string; omitted ones are left unchanged,
+// and a malformed number rejects the whole request.
+void WebServerManager::updateConfiguration(WiFiClient& client, const char* request) {
+    char text[32];
+    char key[16];
+    
+    // Numbers are checked before anything changes so a rejected request leaves the configuration as it was
+    float deviceInstance = -1;
+    if (getQueryString(request, "deviceInstance", text, sizeof(text)) &&
+        (!parseNumber(text, &deviceInstance) || deviceInstance < 0 || deviceInstance > BACNET_INSTANCE_MAX ||
+         deviceInstance != floorf(deviceInstance))) {
+        sendResponseHeader(client, "400 Bad Request", "application/json");
+        client.printf("{\"status\":\"error\",\"message\":\"Device instance must be a whole number from 0 to %u\"}\n",
+                      BACNET_INSTANCE_MAX);
+        return;
+    }
+    float increment;
+    for (uint8_t i = 1; i < bacnetProtocol->getObjectCount(); i++) {
+        snprintf(key, sizeof(key), "cov%lu", (unsigned long)bacnetProtocol->getObject(i)->object_id);
+        if (getQueryString(request, key, text, sizeof(text)) && (!parseNumber(text, &increment) || increment < 0)) {
+            sendResponseHeader(client, "400 Bad Request", "application/json");
+            client.printf("{\"status\":\"error\",\"message\":\"%s must be a number of at least 0\"}\n", key);
+            return;
+        }
+    }
+    
+    if (deviceInstance >= 0) {
+        bacnetProtocol->setDeviceInstance(deviceInstance);
+    }
+    if (getQueryString(request, "deviceName", text, sizeof(text))) {
+        bacnetProtocol->setObjectName(OBJECT_DEVICE, bacnetProtocol->getDeviceInstance(), text);
+    }
+    long fadeTime = getQueryParameter(request, "fadeTime", -1);
+    if (fadeTime >= 0) {
+        deviceManager->setFadeTime(fadeTime);
+    }
+    char server[TIME_SERVER_NAME_MAX];
+    if (getQueryString(request, "ntpServer", server, sizeof(server))) {
+        timeService->setServer(server);
+    }
+    
+    for (uint8_t i = 1; i < bacnetProtocol->getObjectCount(); i++) {
+        BACnetObject* object = bacnetProtocol->getObject(i);
+        snprintf(key, sizeof(key), "name%lu", (unsigned long)object->object_id);
+        if (getQueryString(request, key, text, sizeof(text))) {
+            bacnetProtocol->setObjectName(object->object_type, object->object_id, text);
+        }
+        snprintf(key, sizeof(key), "cov%lu", (unsigned long)object->object_id);
+        if (getQueryString(request, key, text, sizeof(text)) && parseNumber(text, &increment)) {
+            bacnetProtocol->setCOVIncrement(object->object_type, object->object_id, fixedFromFloat(increment));
+        }
+    }
+    
+    sendConfiguration(client);
+}
+
+// GET /api/thermostat - control state of the local AC loop
+void WebServerManager::sendThermostat(WiFiClient& client) {
+    sendResponseHeader(client, "200 OK", "application/json");
+    client.printf("{\"mode\":\"%s\",\"setpoint\":%.1f,\"relay\":%s,\"heating\":%s,\"demand\":%.2f}\n",
+                  thermostatManager->getModeName(thermostatManager->getMode()), fixedToFloat(thermostatManager->getSetpoint()),
+                  thermostatManager->isRelayOn() ? "true" : "false", thermostatManager->isHeating() ? "true" : "false",
+                  fixedToFloat(thermostatManager->getDemand()));
+}
+
+// POST /api/thermostat?mode=<off|cool|heat|auto>&setpoint=<C>
+void WebServerManager::updateThermostat(WiFiClient& client, const char* request) {
+    char text[16];
+    
+    // Checked before the mode changes so a rejected request leaves both unchanged
+    float setpoint = 0;
+    bool hasSetpoint = getQueryString(request, "setpoint", text, sizeof(text));
+    if (hasSetpoint && !parseNumber(text, &setpoint)) {
+        sendResponseHeader(client, "400 Bad Request", "application/json");
+        client.println("{\"status\":\"error\",\"message\":\"Setpoint must be a number\"}");
+        return;
+    }
+    
+    if (getQueryString(request, "mode", text, sizeof(text))) {
+        ThermostatMode mode = THERMOSTAT_MODE_COUNT;
+        for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) {
+            if (strcmp(text, thermostatManager->getModeName((ThermostatMode)i)) == 0) mode = (ThermostatMode)i;
+        }
+        if (!thermostatManager->setMode(mode)) {
+            sendResponseHeader(client, "400 Bad Request", "application/json");
+            client.println("{\"status\":\"error\",\"message\":\"Unknown thermostat mode\"}");
+            return;
+        }
+    }
+    if (hasSetpoint) {
+        thermostatManager->setSetpoint(fixedFromFloat(setpoint));
+    }
+    
+    sendThermostat(client);
+}
+
+// GET /api/rules - installed rule source as plain text, with status headers
+void WebServerManager::sendRules(WiFiClient& client) {
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/plain");
+    client.printf("X-Rule-Count: %u\r\n", rulesEngine->getRuleCount());
+    client.printf("X-Program-Size: %u\r\n", rulesEngine->getProgramSize());
+    client.println("Connection: close");
+    client.println();
+    rulesEngine->printSource(client);
+}
+
+// POST /api/rules - body is the rule source, one rule per line; an empty body removes all rules
+void WebServerManager::updateRules(WiFiClient& client) {
+    char* source = (char*)malloc(RULES_SOURCE_MAX + 1);
+    if (source == nullptr) {
+        sendResponseHeader(client, "503 Service Unavailable", "application/json");
+        client.println("{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return;
+    }
+    
+    int length = readRequestBody(client, source, RULES_SOURCE_MAX + 1);
+    char error[96] = "";
+    if (length == HTTP_BODY_TOO_LARGE) {
+        sendResponseHeader(client, "413 Payload Too Large", "application/json");
+        client.printf("{\"status\":\"error\",\"message\":\"Rules exceed %u bytes\"}\n", RULES_SOURCE_MAX);
+    } else if (length == HTTP_BODY_INCOMPLETE) {
+        // Only an explicit Content-Length: 0 may remove the rules
+        sendResponseHeader(client, "400 Bad Request", "application/json");
+        client.println("{\"status\":\"error\",\"message\":\"Missing Content-Length or incomplete body\"}");
+    } else if (!rulesEngine->upload(source, error, sizeof(error))) {
+        sendResponseHeader(client, "400 Bad Request", "application/json");
+        // The message quotes the offending rule text
+        client.print("{\"status\":\"error\",\"message\":\"");
+        printJsonString(client, error);
+        client.print("\"}\n");
+    } else {
+        sendResponseHeader(client, "200 OK", "application/json");
+        client.printf("{\"status\":\"ok\",\"rules\":%u,\"programSize\":%u}\n", rulesEngine->getRuleCount(),
+                      rulesEngine->getProgramSize());
+    }
+    free(source);
+}
+
+// Skips the remaining request headers and reads a Content-Length body into a
+// null-terminated buffer. Returns the body length, HTTP_BODY_TOO_LARGE if it
+// does not fit, or HTTP_BODY_INCOMPLETE if the request has no Content-Length
+// or the body ends early.
+int WebServerManager::readRequestBody(WiFiClient& client, char* buffer, size_t size) {
+    long contentLength = -1;
+    char header[HTTP_HEADER_LINE_MAX];
+    while (client.connected() || client.available()) {
+        if (readLine(client, header, sizeof(header)) == 0) break;
+        if (strncasecmp(header, "Content-Length:", 15) == 0) {
+            char* end;
+            contentLength = strtol(header + 15, &end, 10);
+            while (*end == ' ') end++;
+            if (end == header + 15 || *end != '\0') contentLength = -1;
+        }
+    }
+    if (contentLength < 0) return HTTP_BODY_INCOMPLETE;
+    if ((size_t)contentLength >= size) return HTTP_BODY_TOO_LARGE;
+    
+    size_t length = client.readBytes(buffer, contentLength);
+    if (length != (size_t)contentLength) return HTTP_BODY_INCOMPLETE;
+    buffer[length] = '\0';
+    return length;
+}
+
+// One CRLF-terminated line without its line ending; returns its length
+size_t WebServerManager::readLine(WiFiClient& client, char* buffer, size_t size) {
+    size_t length = client.readBytesUntil('\n', buffer, size - 1);
+    while (length > 0 && (buffer[length - 1] == '\r' || buffer[length - 1] == ' ')) length--;
+    buffer[length] = '\0';
+    return length;
+}
+
+void WebServerManager::sendResponseHeader(WiFiClient& client, const char* status, const char* contentType) {
+    client.print("HTTP/1.1 ");
+    client.println(status);
+    client.print("Content-Type: ");
+    client.println(contentType);
+    client.println("Connection: close");
+    client.println();
+}
+
+// Returns the value of a query parameter, or nullptr when it is absent
+const char* WebServerManager::findQueryValue(const char* request, const char* name) {
+    const char* query = strchr(request, '?');
+    if (query == nullptr) return nullptr;
+    
+    size_t nameLength = strlen(name);
+    for (const char* position = strstr(query, name); position != nullptr; position = strstr(position + 1, name)) {
+        char preceding = position[-1];
+        if ((preceding == '?' || preceding == '&') && position[nameLength] == '=') {
+            return position + nameLength + 1;
+        }
+    }
+    return nullptr;
+}
+
+long WebServerManager::getQueryParameter(const char* request, const char* name, long defaultValue) {
+    const char* value = findQueryValue(request, name);
+    return value != nullptr ? atol(value) : defaultValue;
+}
+
+// Parses a whole decimal number; trailing text, NAN and infinities are rejected
+bool WebServerManager::parseNumber(const char* text, float* value) {
+    char* end;
+    double number = strtod(text, &end);
+    if (end == text || *end != '\0' || !isfinite(number)) return false;
+    *value = number;
+    return true;
+}
+
+// Copies a URL-decoded query parameter into buffer, truncating to size - 1 characters
+bool WebServerManager::getQueryString(const char* request, const char* name, char* buffer, size_t size) {
+    const char* source = findQueryValue(request, name);
+    if (source == nullptr) return false;
+    
+    size_t length = 0;
+    while (*source && *source != '&' && *source != ' ' && length < size - 1) {
+        if (*source == '%' && isxdigit(source[1]) && isxdigit(source[2])) {
+            char hex[3] = {source[1], source[2], '\0'};
+            buffer[length++] = (char)strtol(hex, nullptr, 16);
+            source += 3;
+        } else {
+            buffer[length++] = *source == '+' ? ' ' : *source;
+            source++;
+        }
+    }
+    buffer[length] = '\0';
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef WEB_SERVER_MANAGER_H
+#define WEB_SERVER_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiServer.h>
+#include <WiFiClient.h>
+#include "../config/config.h"
+#include "../TrendLog/TrendLogManager.h"
+#include "../System/BootManager.h"
+#include "../BACnet/BACnetProtocol.h"
+#include "../DeviceControl/DeviceManager.h"
+#include "../Control/ThermostatManager.h"
+#include "../Rules/RulesEngine.h"
+#include "../System/TimeService.h"
+#include "../System/HeapMonitor.h"
+
+// readRequestBody results other than a body length
+#define HTTP_BODY_TOO_LARGE -1
+#define HTTP_BODY_INCOMPLETE -2
+
+class WebServerManager {
+public:
+    WebServerManager(TrendLogManager* logs, BootManager* boot, BACnetProtocol* bacnet, DeviceManager* devices,
+                     ThermostatManager* thermostat, RulesEngine* rules, TimeService* clock, HeapMonitor* heap)
+        : server(WEB_SERVER_PORT), trendLogManager(logs), bootManager(boot), bacnetProtocol(bacnet), deviceManager(devices),
+          thermostatManager(thermostat), rulesEngine(rules), timeService(clock), heapMonitor(heap) {}
+
+    void begin();
+    void handleClient();
+
+private:
+    WiFiServer server;
+    TrendLogManager* trendLogManager;
+    BootManager* bootManager;
+    BACnetProtocol* bacnetProtocol;
+    DeviceManager* deviceManager;
+    ThermostatManager* thermostatManager;
+    RulesEngine* rulesEngine;
+    TimeService* timeService;
+    HeapMonitor* heapMonitor;
+
+    void sendTrendLog(WiFiClient& client, const char* request);
+    void sendBootTimings(WiFiClient& client);
+    void sendTime(WiFiClient& client);
+    void sendMetrics(WiFiClient& client);
+    void sendConfiguration(WiFiClient& client);
+    void updateConfiguration(WiFiClient& client, const char* request);
+    void sendThermostat(WiFiClient& client);
+    void updateThermostat(WiFiClient& client, const char* request);
+    void sendRules(WiFiClient& client);
+    void updateRules(WiFiClient& client);
+    int readRequestBody(WiFiClient& client, char* buffer, size_t size);
+    size_t readLine(WiFiClient& client, char* buffer, size_t size);
+    void sendResponseHeader(WiFiClient& client, const char* status, const char* contentType);
+    const char* findQueryValue(const char* request, const char* name);
+    long getQueryParameter(const char* request, const char* name, long defaultValue);
+    bool getQueryString(const char* request, const char* name, char* buffer, size_t size);
+    bool parseNumber(const char* text, float* value);
+};
+
+#endif
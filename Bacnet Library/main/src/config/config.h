@@ -3,19 +3,138 @@
 
 // System
 const unsigned long DHT_UPLOAD_INTERVAL = 2000;
+#define DHT_MAX_FAILED_READS 3 // Consecutive failed reads before the readings are dropped
 const unsigned long FIREBASE_POLL_INTERVAL = 1000;
 const unsigned long STATUS_PRINT_INTERVAL = 10000;
 const unsigned long BACNET_DISCOVERY_INTERVAL = 30000;
 const unsigned long DEBOUNCE_DELAY = 50;
+const unsigned long BUTTON_LONG_PRESS_TIME = 1000;
+const unsigned long BUTTON_MULTI_CLICK_GAP = 250;
+const unsigned long CONFIG_SAVE_DELAY = 2000;
+#define CONFIG_LOG_MAX_SIZE 4096
+const unsigned long HEAP_SAMPLE_INTERVAL = 1000;
+
+// Steady-state translation units include System/StringGuard.h last; with this
+// defined any Arduino String use in them is a compile error
+#define STRING_FREE_BUILD
+
+// Dimming
+const unsigned long LED_FADE_TIME = 1000;
+#define LED_FADE_TIME_MAX 60000
+#define FADE_STEP_INTERVAL 10
+#define FADE_PWM_RANGE 1023
+
+// Thermostat
+const unsigned long THERMOSTAT_TICK_INTERVAL = 1000;
+const unsigned long THERMOSTAT_MIN_ON_TIME = 180000;
+const unsigned long THERMOSTAT_MIN_OFF_TIME = 180000;
+#define THERMOSTAT_MAX_CATCH_UP 5
+#define THERMOSTAT_DEFAULT_SETPOINT 24.0
+#define THERMOSTAT_SETPOINT_MIN 16.0
+#define THERMOSTAT_SETPOINT_MAX 30.0
+#define THERMOSTAT_KP 0.5            // Demand per degree C of error
+#define THERMOSTAT_KI 0.002          // Demand per degree C second
+#define THERMOSTAT_DEMAND_ON 0.6
+#define THERMOSTAT_DEMAND_OFF 0.2
+#define THERMOSTAT_AUTO_CHANGEOVER 1.5
+#define TEMPERATURE_FILTER_ALPHA 0.3 // Weight of each new reading in the sensor filter
+
+// Rules
+#define RULES_MAX_RULES 32
+#define RULES_PROGRAM_SIZE 512
+#define RULES_STACK_DEPTH 8
+#define RULES_SOURCE_MAX 1024
+
+// Time
+#define NTP_SERVER "pool.ntp.org"         // Point at a local server on isolated building networks
+#define TIME_ZONE "UTC0"                  // POSIX TZ rule for local time
+#define TIME_MIN_VALID_EPOCH 1600000000   // SNTP results before this are ignored
+#define TIME_STEP_THRESHOLD 1000000       // Larger corrections (us) step the clock instead of slewing
+#define TIME_SLEW_RATE 500                // Correction applied per second of elapsed time, us
+
+// Cloud
+// Transport used for cloud sync. MQTT keeps one broker connection open
+// (broker and topic root in credentials.h); Firebase polls its REST API.
+#define CLOUD_TRANSPORT_FIREBASE 0
+#define CLOUD_TRANSPORT_MQTT 1
+#define CLOUD_TRANSPORT CLOUD_TRANSPORT_FIREBASE
+// Firebase responses here are a single value or a small object (under 200 bytes),
+// so the TLS buffers stay near BearSSL's minimum; check the largest response
+// reported in the status output before raising FIREBASE_RESPONSE_SIZE
+#define FIREBASE_SSL_RX_BUFFER 1024
+#define FIREBASE_SSL_TX_BUFFER 512
+#define FIREBASE_RESPONSE_SIZE 1024
+#define FIREBASE_KEEPALIVE_IDLE 5       // Seconds idle before the first TCP keepalive probe
+#define FIREBASE_KEEPALIVE_INTERVAL 5
+#define FIREBASE_KEEPALIVE_COUNT 3
+const unsigned long CLOUD_METRICS_WINDOW = 3600000;
+const unsigned long CLOUD_WRITE_COALESCE_TIME = 500; // Quiet time before a local change is written
+const unsigned long CLOUD_WRITE_MAX_DELAY = 2000;    // Upper bound while a value keeps changing
+const unsigned long CLOUD_TELEMETRY_INTERVAL = 60000;
+const unsigned long CLOUD_JOURNAL_RETRY_INTERVAL = 5000;
+#define CLOUD_JOURNAL_RAM_ENTRIES 16
+#define CLOUD_JOURNAL_FLASH_ENTRIES 1024 // 16 KB ring, about 8 hours of readings
+#define MQTT_KEEPALIVE 30      // Seconds between pings on an idle connection
+#define MQTT_SOCKET_TIMEOUT 2  // Seconds to wait for the broker's CONNACK or a packet
+#define MQTT_BUFFER_SIZE 256   // Largest packet in either direction
+const unsigned long MQTT_CONNECT_TIMEOUT = 1000;          // Longest TCP connect to the broker, blocking the loop
+const unsigned long MQTT_RECONNECT_INTERVAL = 5000;       // First retry, doubling after each failure
+const unsigned long MQTT_RECONNECT_MAX_INTERVAL = 60000;
 
 // Network
 const unsigned long NETWORK_TIMEOUT = 15000;
 const unsigned long SYSTEM_RESTART_DELAY = 15000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 4000;
+const unsigned long WIFI_RETRY_MIN_DELAY = 500;
+const unsigned long WIFI_RETRY_MAX_DELAY = 60000;
+#define WIFI_MAX_LINK_CALLBACKS 4
+#define WIFI_REUSE_DHCP_LEASE 1 // First boot attempt only; any failure on it returns to DHCP
+
+// Optional static addressing (skips DHCP), leave undefined to use DHCP
+// #define WIFI_STATIC_IP      192, 168, 1, 50
+// #define WIFI_STATIC_GATEWAY 192, 168, 1, 1
+// #define WIFI_STATIC_SUBNET  255, 255, 255, 0
+// #define WIFI_STATIC_DNS     192, 168, 1, 1
 
 // BACnet
 #define BACNET_PORT 47808
 #define DEVICE_ID 1010
+#define BACNET_INSTANCE_MAX 0xFFFF   // Object identifiers carry a 16-bit instance in this stack
 #define VENDOR_ID 1110
 #define MAX_APDU 1476
+#define BACNET_RATE_SOURCES 8        // Source addresses metered at once, least recent is evicted
+#define BACNET_RATE_DISCOVERY 1      // Sustained requests per second and source, by service class
+#define BACNET_BURST_DISCOVERY 3
+#define BACNET_RATE_READ 20
+#define BACNET_BURST_READ 40
+#define BACNET_RATE_WRITE 5
+#define BACNET_BURST_WRITE 10
+// Only WriteProperty replies are cached (reads are safe to repeat). Sized for
+// the most writes admission lets one source make within BACNET_REPLY_CACHE_TIME:
+// a full burst plus the sustained rate, 35 replies (about 2.4 KB). All
+// BACNET_RATE_SOURCES writing at that rate together would need eight times
+// as much; they share the cache and the oldest replies are evicted first.
+const unsigned long BACNET_REPLY_CACHE_TIME = 5000; // Covers a client's APDU timeout and first retries
+#define BACNET_REPLY_CACHE_SIZE (BACNET_BURST_WRITE + BACNET_RATE_WRITE * BACNET_REPLY_CACHE_TIME / 1000)
+#define BACNET_REPLY_CACHE_BYTES 48   // A routed SimpleACK or Error fits
+#define BACNET_VIRTUAL_NETWORK 2010   // Network number behind which the virtual devices are routed
+#define BACNET_VIRTUAL_DEVICE_MAX 4
+#define BACNET_VIRTUAL_OBJECT_MAX 8
+#define BACNET_CLIMATE_DEVICE_ID 1011
+
+// Trend Logs
+const unsigned long TREND_LOG_INTERVAL = 60000;
+const unsigned long TREND_FLUSH_INTERVAL = 900000;
+#define TREND_LOG_CAPACITY 2880
+#define TREND_LOG_TAIL_SIZE 16
+#define TRENDLOG_TEMPERATURE_ID 6
+#define TRENDLOG_HUMIDITY_ID 7
+
+// Web
+#define WEB_SERVER_PORT 80
+const unsigned long HTTP_REQUEST_TIMEOUT = 1000;
+#define HTTP_TREND_PAGE_MAX 200
+#define HTTP_REQUEST_LINE_MAX 256 // Longer request lines are truncated, enough for every /api/config parameter
+#define HTTP_HEADER_LINE_MAX 128
 
 #endif
\ No newline at end of file
@@ -10,8 +10,15 @@
 #define FIREBASE_AUTH   "ABC0hJi33Fx2jDaUT0xNHHYEKDfHo1DR4gn24Oj5"
 
 // Firebase Paths
-const char *PATH_BRIGHTNESS = "/smartLight/brightness";
-const char *PATH_DIGITAL_LED = "/digitalLED/state";
-const char *PATH_SENSOR = "/sensorData";
+const char* const PATH_BRIGHTNESS = "/smartLight/brightness";
+const char* const PATH_DIGITAL_LED = "/digitalLED/state";
+const char* const PATH_SENSOR = "/sensorData";
+
+// MQTT
+#define MQTT_BROKER     "192.168.1.10"
+#define MQTT_PORT       1883
+#define MQTT_USERNAME   ""
+#define MQTT_PASSWORD   ""
+#define MQTT_TOPIC_ROOT "sbmcon"
 
 #endif
\ No newline at end of file
@@ -6,5 +6,6 @@
 #define DHT11_AI 4    // D2 - GPIO 4
 #define DIM_LED_AO 14 // D5 - GPIO 14
 #define BUTTON_BI 12  // D6 - GPIO 12
+#define AC_RELAY_BO 13 // D7 - GPIO 13
 
 #endif
\ No newline at end of file
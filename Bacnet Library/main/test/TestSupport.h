@@ -0,0 +1,33 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <stdio.h>
+
+// Minimal checks for the host tests: failures are counted and reported with
+// their location, and the test's main returns testResult() as its exit code.
+static int testFailures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++;                                                           \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                   \
+    do {                                                                                          \
+        double difference = (double)(actual) - (double)(expected);                                \
+        if (!(difference <= (tolerance) && difference >= -(tolerance))) {                         \
+            fprintf(stderr, "%s:%d: %s is %g, expected %g +/- %g\n", __FILE__, __LINE__, #actual, \
+                    (double)(actual), (double)(expected), (double)(tolerance));                   \
+            testFailures++;                                                                       \
+        }                                                                                         \
+    } while (0)
+
+static int testResult() {
+    if (testFailures > 0) fprintf(stderr, "%d check(s) failed\n", testFailures);
+    return testFailures > 0 ? 1 : 0;
+}
+
+#endif
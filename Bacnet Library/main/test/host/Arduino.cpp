@@ -0,0 +1,60 @@
+#include "Arduino.h"
+#include <chrono>
+
+uint64_t hostMicros = 0;
+uint8_t hostPinMode[HOST_PIN_COUNT];
+int hostPinLevel[HOST_PIN_COUNT];
+int hostAnalogLevel[HOST_PIN_COUNT];
+bool hostSerialEcho = false;
+bool hostRealCycleCount = false;
+int hostInternalDepth = 0;
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static void (*interruptHandler[HOST_PIN_COUNT])(void*);
+static void* interruptArgument[HOST_PIN_COUNT];
+
+void hostAdvanceMillis(unsigned long milliseconds) { hostMicros += (uint64_t)milliseconds * 1000; }
+
+void hostSetPin(uint8_t pin, int level) {
+    if (hostPinLevel[pin] == level) return;
+    hostPinLevel[pin] = level;
+    if (interruptHandler[pin] != nullptr) interruptHandler[pin](interruptArgument[pin]);
+}
+
+unsigned long millis() { return (unsigned long)(hostMicros / 1000); }
+unsigned long micros() { return (unsigned long)hostMicros; }
+uint64_t micros64() { return hostMicros; }
+void delay(unsigned long milliseconds) { hostAdvanceMillis(milliseconds); }
+void yield() {}
+void configTime(const char*, const char*, const char*, const char*) {}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    hostPinMode[pin] = mode;
+    if (mode == INPUT_PULLUP) hostPinLevel[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) { hostPinLevel[pin] = level; }
+int digitalRead(uint8_t pin) { return hostPinLevel[pin]; }
+void analogWrite(uint8_t pin, int value) { hostAnalogLevel[pin] = value; }
+void analogWriteRange(uint32_t) {}
+void analogWriteFreq(uint32_t) {}
+int digitalPinToInterrupt(int pin) { return pin; }
+
+void attachInterruptArg(int interrupt, void (*handler)(void*), void* argument, int) {
+    interruptHandler[interrupt] = handler;
+    interruptArgument[interrupt] = argument;
+}
+
+void detachInterrupt(int interrupt) { interruptHandler[interrupt] = nullptr; }
+void noInterrupts() {}
+void interrupts() {}
+uint32_t EspClass::getCycleCount() {
+    if (!hostRealCycleCount) return (uint32_t)(hostMicros * 80);
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() * 80 / 1000);
+}
+
+long random(long limit) { return limit > 0 ? rand() % limit : 0; }
+long random(long low, long high) { return high > low ? low + random(high - low) : low; }
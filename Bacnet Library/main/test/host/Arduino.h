@@ -0,0 +1,180 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the ESP8266 Arduino core, enough to build the library's
+// hardware-independent units natively. Time only moves when a test advances
+// it, pins are plain arrays and Serial goes to stdout when hostSerialEcho is
+// set. There is deliberately no String class: steady-state units must build
+// without it, as they do on the device with STRING_FREE_BUILD.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HOST_PIN_COUNT 17
+
+// Test control
+extern uint64_t hostMicros;
+extern uint8_t hostPinMode[HOST_PIN_COUNT];
+extern int hostPinLevel[HOST_PIN_COUNT];
+extern int hostAnalogLevel[HOST_PIN_COUNT];
+extern bool hostSerialEcho;
+// ESP.getCycleCount follows the host's own clock at 80 cycles per microsecond
+// instead of simulated time, for benchmarks of code the stack times itself
+extern bool hostRealCycleCount;
+void hostAdvanceMillis(unsigned long milliseconds);
+// Calls the handler attached to pin after setting its level, as an edge would
+void hostSetPin(uint8_t pin, int level);
+
+// Heap use while one of these is alive belongs to the stand-ins, not to the
+// code under test (see test_soak)
+extern int hostInternalDepth;
+struct HostInternal {
+    HostInternal() { hostInternalDepth++; }
+    ~HostInternal() { hostInternalDepth--; }
+};
+
+unsigned long millis();
+unsigned long micros();
+uint64_t micros64();
+void delay(unsigned long milliseconds);
+void yield();
+void configTime(const char* timeZone, const char* server1, const char* server2 = nullptr, const char* server3 = nullptr);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void analogWriteRange(uint32_t range);
+void analogWriteFreq(uint32_t frequency);
+int digitalPinToInterrupt(int pin);
+void attachInterruptArg(int interrupt, void (*handler)(void*), void* argument, int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+long random(long limit);
+long random(long low, long high);
+
+template <class T> T constrain(T value, T low, T high) { return value < low ? low : (value > high ? high : value); }
+using std::min;
+using std::max;
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* data, size_t size) {
+        size_t written = 0;
+        while (size-- > 0) written += write(*data++);
+        return written;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t write(const char* data, size_t size) { return write((const uint8_t*)data, size); }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(int value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = 10) { return base == 16 ? printf("%lx", value) : printf("%ld", value); }
+    size_t print(unsigned long value, int base = 10) { return base == 16 ? printf("%lx", value) : printf("%lu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T value) { return print(value) + println(); }
+    template <class T> size_t println(T value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list arguments;
+        va_start(arguments, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+        va_end(arguments);
+        if (length < 0) return 0;
+        return write((const uint8_t*)buffer, std::min((size_t)length, sizeof(buffer) - 1));
+    }
+};
+
+// No timeouts on the host: data is either there or not
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+    void setTimeout(unsigned long) {}
+
+    size_t readBytes(char* buffer, size_t size) {
+        size_t count = 0;
+        while (count < size && available()) buffer[count++] = read();
+        return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t size) { return readBytes((char*)buffer, size); }
+
+    size_t readBytesUntil(char terminator, char* buffer, size_t size) {
+        size_t count = 0;
+        while (count < size && available()) {
+            int value = read();
+            if (value == terminator) break;
+            buffer[count++] = value;
+        }
+        return count;
+    }
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    using Print::write;
+    size_t write(uint8_t value) override {
+        if (hostSerialEcho) fputc(value, stdout);
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t size) override {
+        if (hostSerialEcho) fwrite(data, 1, size, stdout);
+        return size;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+struct EspClass {
+    void restart() {}
+    uint32_t getFreeHeap() { return 40000; }
+    uint32_t getMaxFreeBlockSize() { return 30000; }
+    uint8_t getHeapFragmentation() { return 0; }
+    void getHeapStats(uint32_t* free, uint16_t* largest, uint8_t* fragmentation) {
+        *free = getFreeHeap();
+        *largest = getMaxFreeBlockSize();
+        *fragmentation = getHeapFragmentation();
+    }
+    uint32_t getCycleCount();
+    uint32_t getChipId() { return 0x00C0FFEE; }
+};
+
+extern EspClass ESP;
+
+#endif
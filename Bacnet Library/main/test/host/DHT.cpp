@@ -0,0 +1,4 @@
+#include "DHT.h"
+
+float hostDHTTemperature = NAN;
+float hostDHTHumidity = NAN;
@@ -0,0 +1,20 @@
+#ifndef HOST_DHT_H
+#define HOST_DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+
+// Returns whatever the test last set; NAN reads as a failed transfer
+extern float hostDHTTemperature;
+extern float hostDHTHumidity;
+
+class DHT {
+public:
+    DHT(uint8_t, uint8_t) {}
+    void begin() {}
+    float readTemperature() { return hostDHTTemperature; }
+    float readHumidity() { return hostDHTHumidity; }
+};
+
+#endif
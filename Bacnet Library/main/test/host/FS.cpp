@@ -0,0 +1,86 @@
+#include "FS.h"
+
+FS LittleFS;
+
+File FS::open(const char* path, const char* mode) {
+    HostInternal scope;
+    if (failOpens > 0) {
+        failOpens--;
+        return File();
+    }
+    auto entry = files.find(path);
+    if (mode[0] == 'r' && entry == files.end()) return File();
+    if (entry == files.end() || mode[0] == 'w') {
+        entry = files.insert_or_assign(path, std::make_shared<std::vector<uint8_t>>()).first;
+    }
+    size_t start = mode[0] == 'a' ? entry->second->size() : 0;
+    return File(entry->second, start, mode[0] != 'r' || mode[1] == '+');
+}
+
+bool FS::rename(const char* from, const char* to) {
+    HostInternal scope;
+    auto entry = files.find(from);
+    if (entry == files.end()) return false;
+    files[to] = entry->second;
+    files.erase(entry);
+    return true;
+}
+
+bool FS::info(FSInfo& info) {
+    HostInternal scope;
+    size_t used = 0;
+    for (auto& file : files) used += file.second->size();
+    info = {1024 * 1024, used, 8192, 256, 5, 32};
+    return true;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    HostInternal scope;
+    if (!data) return false;
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? offset : data->size();
+    if (base + position > data->size()) return false;
+    offset = base + position;
+    return true;
+}
+
+bool File::truncate(uint32_t size) {
+    HostInternal scope;
+    if (!data || !canWrite) return false;
+    data->resize(size);
+    offset = std::min(offset, (size_t)size);
+    return true;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    HostInternal scope;
+    if (!data || !canWrite) return 0;
+    if (LittleFS.freeBytes >= 0) {
+        size = std::min(size, (size_t)LittleFS.freeBytes);
+        LittleFS.freeBytes -= size;
+    }
+    if (offset + size > data->size()) data->resize(offset + size);
+    memcpy(data->data() + offset, buffer, size);
+    offset += size;
+    return size;
+}
+
+int File::read(uint8_t* buffer, size_t size) {
+    HostInternal scope;
+    if (!data) return -1;
+    size = std::min(size, data->size() - offset);
+    if (LittleFS.shortReads > 0 && size > 1) size = std::min(size, LittleFS.shortReads);
+    memcpy(buffer, data->data() + offset, size);
+    offset += size;
+    return size;
+}
+
+int File::read() {
+    HostInternal scope;
+    uint8_t value;
+    return read(&value, 1) == 1 ? value : -1;
+}
+
+int File::peek() {
+    HostInternal scope;
+    return data && offset < data->size() ? (*data)[offset] : -1;
+}
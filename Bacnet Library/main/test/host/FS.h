@@ -0,0 +1,65 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum SeekMode { SeekSet, SeekCur, SeekEnd };
+
+// A file is a shared byte vector, so copies of a File and later opens of the
+// same path see each other's writes as on LittleFS
+class File : public Stream {
+public:
+    File() {}
+    File(std::shared_ptr<std::vector<uint8_t>> contents, size_t start, bool writable)
+        : data(contents), offset(start), canWrite(writable) {}
+
+    operator bool() const { return data != nullptr; }
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const { return offset; }
+    size_t size() const { return data ? data->size() : 0; }
+    void close() { data.reset(); }
+    bool truncate(uint32_t size);
+
+    using Print::write;
+    size_t write(uint8_t value) override { return write(&value, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int read(uint8_t* buffer, size_t size);
+    int read() override;
+    int peek() override;
+    int available() override { return data ? (int)(data->size() - offset) : 0; }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> data;
+    size_t offset = 0;
+    bool canWrite = false;
+};
+
+struct FSInfo {
+    size_t totalBytes, usedBytes, blockSize, pageSize, maxOpenFiles, maxPathLength;
+};
+
+class FS {
+public:
+    bool begin() { return mountResult; }
+    void end() {}
+    bool format() { files.clear(); return true; }
+    File open(const char* path, const char* mode);
+    bool exists(const char* path) { return files.count(path) > 0; }
+    bool remove(const char* path) { return files.erase(path) > 0; }
+    bool rename(const char* from, const char* to);
+    bool mkdir(const char*) { return true; }
+    bool info(FSInfo& info);
+
+    // Test control
+    bool mountResult = true;
+    int failOpens = 0;      // The next opens that fail, as on a full or damaged file system
+    size_t shortReads = 0;  // The next multi-byte reads return at most this many bytes, 0 for off
+    long freeBytes = -1;    // Bytes writes may still store, cut short beyond that as on a full flash; -1 for no limit
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+};
+
+#endif
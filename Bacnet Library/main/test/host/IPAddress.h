@@ -0,0 +1,27 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+    explicit IPAddress(uint32_t address) { memcpy(bytes, &address, sizeof(bytes)); }
+
+    operator uint32_t() const { return v4(); }
+    uint32_t v4() const {
+        uint32_t address;
+        memcpy(&address, bytes, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int index) const { return bytes[index]; }
+    uint8_t& operator[](int index) { return bytes[index]; }
+    bool operator==(const IPAddress& other) const { return v4() == other.v4(); }
+    bool isSet() const { return v4() != 0; }
+
+private:
+    uint8_t bytes[4] = {0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "WiFiUdp.h"
+
+std::deque<HostDatagram> hostUdpReceived;
+std::vector<HostDatagram> hostUdpSent;
+
+int WiFiUDP::parsePacket() {
+    HostInternal scope;
+    position = 0;
+    if (hostUdpReceived.empty()) {
+        current.data.clear();
+        return 0;
+    }
+    current = std::move(hostUdpReceived.front());
+    hostUdpReceived.pop_front();
+    return current.data.size();
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t size) {
+    HostInternal scope;
+    size = std::min(size, current.data.size() - position);
+    memcpy(buffer, current.data.data() + position, size);
+    position += size;
+    return size;
+}
+
+int WiFiUDP::read() {
+    HostInternal scope;
+    return position < current.data.size() ? current.data[position++] : -1;
+}
+
+int WiFiUDP::peek() {
+    HostInternal scope;
+    return position < current.data.size() ? current.data[position] : -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port) {
+    HostInternal scope;
+    outgoing.data.clear();
+    outgoing.address = address;
+    outgoing.port = port;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* data, size_t size) {
+    HostInternal scope;
+    outgoing.data.insert(outgoing.data.end(), data, data + size);
+    return size;
+}
+
+int WiFiUDP::endPacket() {
+    HostInternal scope;
+    hostUdpSent.push_back(outgoing);
+    return 1;
+}
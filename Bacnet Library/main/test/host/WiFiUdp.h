@@ -0,0 +1,43 @@
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <deque>
+#include <vector>
+
+struct HostDatagram {
+    std::vector<uint8_t> data;
+    IPAddress address;
+    uint16_t port;
+};
+
+// Datagrams a test queues in hostUdpReceived are returned by parsePacket in
+// order; everything sent lands in hostUdpSent
+extern std::deque<HostDatagram> hostUdpReceived;
+extern std::vector<HostDatagram> hostUdpSent;
+
+class WiFiUDP : public Stream {
+public:
+    uint8_t begin(uint16_t) { return 1; }
+    void stop() {}
+    int parsePacket();
+    int read(uint8_t* buffer, size_t size);
+    int read() override;
+    int peek() override;
+    int available() override { return current.data.size() - position; }
+    IPAddress remoteIP() { return current.address; }
+    uint16_t remotePort() { return current.port; }
+    int beginPacket(IPAddress address, uint16_t port);
+    int endPacket();
+    using Print::write;
+    size_t write(uint8_t value) override { return write(&value, 1); }
+    size_t write(const uint8_t* data, size_t size) override;
+
+private:
+    HostDatagram current;
+    size_t position = 0;
+    HostDatagram outgoing;
+};
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef HOST_COREDECLS_H
+#define HOST_COREDECLS_H
+
+#include <functional>
+
+// The host never runs SNTP, so the callback is stored and never called
+inline void settimeofday_cb(const std::function<void(bool)>&) {}
+
+#endif
@@ -0,0 +1,127 @@
+// Debounce and gesture decoding of ButtonInput, driven through the pin's
+// interrupt handler with contact bounce on every press and release
+#include <Arduino.h>
+#include "TestSupport.h"
+#include "../src/DeviceControl/ButtonInput.h"
+
+static const uint8_t BUTTON_PIN = 0;
+
+// Gestures seen while handle() runs once per millisecond
+struct Gestures {
+    int clicks = 0;
+    int lastClickCount = 0;
+    int longPresses = 0;
+};
+
+static void run(ButtonInput& button, Gestures& seen, unsigned long milliseconds) {
+    for (unsigned long i = 0; i < milliseconds; i++) {
+        hostAdvanceMillis(1);
+        ButtonGesture gesture = button.handle();
+        if (gesture == BUTTON_GESTURE_CLICK) {
+            seen.clicks++;
+            seen.lastClickCount = button.getClickCount();
+        } else if (gesture == BUTTON_GESTURE_LONG_PRESS) {
+            seen.longPresses++;
+        }
+    }
+}
+
+// Settles at level after a few contact bounces 1-3 ms apart; without a
+// button, time only moves here, as when loop() is busy elsewhere
+static void bounceTo(int level, ButtonInput* button = nullptr, Gestures* seen = nullptr) {
+    static const unsigned long gaps[] = {1, 3, 2, 1};
+    for (unsigned long gap : gaps) {
+        hostSetPin(BUTTON_PIN, level);
+        if (button) run(*button, *seen, gap); else hostAdvanceMillis(gap);
+        hostSetPin(BUTTON_PIN, !level);
+        if (button) run(*button, *seen, gap); else hostAdvanceMillis(gap);
+    }
+    hostSetPin(BUTTON_PIN, level);
+}
+
+static void press(ButtonInput& button, Gestures& seen, unsigned long holdTime) {
+    bounceTo(LOW, &button, &seen);
+    run(button, seen, holdTime);
+    bounceTo(HIGH, &button, &seen);
+}
+
+static void testBouncyClick(ButtonInput& button) {
+    Gestures seen;
+    press(button, seen, 120);
+    run(button, seen, BUTTON_MULTI_CLICK_GAP + 50);
+    CHECK(seen.clicks == 1);
+    CHECK(seen.lastClickCount == 1);
+    CHECK(seen.longPresses == 0);
+    CHECK(!button.isPressed());
+}
+
+static void testBouncyDoubleClick(ButtonInput& button) {
+    Gestures seen;
+    press(button, seen, 80);
+    run(button, seen, 100);
+    press(button, seen, 80);
+    run(button, seen, BUTTON_MULTI_CLICK_GAP + 50);
+    CHECK(seen.clicks == 1);
+    CHECK(seen.lastClickCount == 2);
+}
+
+static void testBouncyLongPress(ButtonInput& button) {
+    Gestures seen;
+    bounceTo(LOW, &button, &seen);
+    run(button, seen, BUTTON_LONG_PRESS_TIME + 100);
+    CHECK(seen.longPresses == 1);
+    CHECK(button.isPressed());
+    bounceTo(HIGH, &button, &seen);
+    run(button, seen, BUTTON_MULTI_CLICK_GAP + 50);
+    CHECK(seen.longPresses == 1);
+    CHECK(seen.clicks == 0); // The release of a long press is not a click
+}
+
+static void testGlitchIgnored(ButtonInput& button) {
+    Gestures seen;
+    hostSetPin(BUTTON_PIN, LOW);
+    run(button, seen, DEBOUNCE_DELAY / 2);
+    hostSetPin(BUTTON_PIN, HIGH);
+    run(button, seen, BUTTON_LONG_PRESS_TIME + 100);
+    CHECK(seen.clicks == 0);
+    CHECK(seen.longPresses == 0);
+}
+
+// A whole click made while handle() was not called is replayed at the
+// edges' capture times
+static void testClickWhileBusy(ButtonInput& button) {
+    Gestures seen;
+    bounceTo(LOW);
+    hostAdvanceMillis(100);
+    bounceTo(HIGH);
+    hostAdvanceMillis(BUTTON_MULTI_CLICK_GAP + 50);
+    run(button, seen, 1);
+    CHECK(seen.clicks == 1);
+    CHECK(seen.lastClickCount == 1);
+}
+
+static void testQueueOverflowCounted(ButtonInput& button) {
+    Gestures seen;
+    for (int i = 0; i < BUTTON_QUEUE_SIZE; i++) {
+        hostSetPin(BUTTON_PIN, i % 2 == 0 ? LOW : HIGH);
+    }
+    hostSetPin(BUTTON_PIN, HIGH);
+    CHECK(button.getDroppedEdges() > 0);
+    run(button, seen, BUTTON_LONG_PRESS_TIME);
+    CHECK(seen.longPresses == 0);
+}
+
+int main() {
+    ButtonInput button;
+    button.begin(BUTTON_PIN);
+    CHECK(hostPinMode[BUTTON_PIN] == INPUT_PULLUP);
+    hostAdvanceMillis(1000);
+
+    testBouncyClick(button);
+    testBouncyDoubleClick(button);
+    testBouncyLongPress(button);
+    testGlitchIgnored(button);
+    testClickWhileBusy(button);
+    testQueueOverflowCounted(button);
+    return testResult();
+}
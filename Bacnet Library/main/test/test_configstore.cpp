@@ -0,0 +1,64 @@
+// ConfigStore on a flash that fills up: values that did not reach the log
+// stay pending and are retried, and neither a torn append nor a failed
+// compaction loses what was saved before
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "TestSupport.h"
+#include "../src/Storage/ConfigStore.h"
+
+static ConfigStore configStore;
+
+// What a reboot would restore for key
+static uint32_t restored(uint16_t key) {
+    ConfigStore rebooted;
+    rebooted.begin();
+    return rebooted.getUInt32(key, 0);
+}
+
+static void testTornAppend() {
+    configStore.setUInt32(CONFIG_KEY_DEVICE_INSTANCE, 1);
+    configStore.flush();
+    CHECK(restored(CONFIG_KEY_DEVICE_INSTANCE) == 1);
+
+    // Room for part of a record only
+    LittleFS.freeBytes = 4;
+    configStore.setUInt32(CONFIG_KEY_DEVICE_INSTANCE, 2);
+    configStore.setUInt32(CONFIG_KEY_FADE_TIME, 3);
+    configStore.flush();
+    LittleFS.freeBytes = -1;
+    CHECK(restored(CONFIG_KEY_DEVICE_INSTANCE) == 1);
+    CHECK(restored(CONFIG_KEY_FADE_TIME) == 0);
+
+    // Retried once writes have been quiet again, not on the next pass
+    configStore.handle();
+    CHECK(restored(CONFIG_KEY_FADE_TIME) == 0);
+    hostAdvanceMillis(CONFIG_SAVE_DELAY);
+    configStore.handle();
+    CHECK(restored(CONFIG_KEY_DEVICE_INSTANCE) == 2);
+    CHECK(restored(CONFIG_KEY_FADE_TIME) == 3);
+}
+
+static void testFailedCompaction() {
+    // A torn append makes the next save a compaction, which fails too
+    LittleFS.freeBytes = 4;
+    configStore.setUInt32(CONFIG_KEY_DEVICE_INSTANCE, 4);
+    configStore.flush();
+    LittleFS.freeBytes = 8;
+    configStore.flush();
+    LittleFS.freeBytes = -1;
+    CHECK(LittleFS.files.count(CONFIG_STORE_TEMP_PATH) == 0);
+    CHECK(restored(CONFIG_KEY_DEVICE_INSTANCE) == 2);
+    CHECK(restored(CONFIG_KEY_FADE_TIME) == 3);
+
+    configStore.flush();
+    CHECK(restored(CONFIG_KEY_DEVICE_INSTANCE) == 4);
+    CHECK(restored(CONFIG_KEY_FADE_TIME) == 3);
+}
+
+int main() {
+    configStore.begin();
+
+    testTornAppend();
+    testFailedCompaction();
+    return testResult();
+}
@@ -0,0 +1,119 @@
+// The accuracy bounds stated in FixedPoint.h, checked against a double
+// reference, and a microbenchmark of the filter step in fixed and float
+#include <Arduino.h>
+#include <DHT.h>
+#include <chrono>
+#include <random>
+#include "TestSupport.h"
+#include "../src/Sensors/SensorManager.h"
+
+static const double STEP = 1.0 / FIXED_ONE;
+
+static double exact(fixed_t value) { return (double)value / FIXED_ONE; }
+
+static void testConversion(std::mt19937& random) {
+    std::uniform_real_distribution<float> values(-32766.0f, 32766.0f);
+    double worst = 0;
+    for (int i = 0; i < 1000000; i++) {
+        float value = i < 1000 ? values(random) / 1000 : values(random);
+        worst = std::max(worst, fabs(exact(fixedFromFloat(value)) - value));
+    }
+    CHECK(worst <= STEP);
+
+    CHECK(fixedFromFloat(NAN) == FIXED_INVALID);
+    CHECK(fixedFromFloat(1e9f) == FIXED_MAX);
+    CHECK(fixedFromFloat(-1e9f) == FIXED_MIN);
+    CHECK(fixedFromFloat(INFINITY) == FIXED_MAX);
+    CHECK(fixedToInt(fixedFromFloat(21.5f)) == 22);
+    CHECK(fixedToInt(fixedFromFloat(-21.4f)) == -21);
+}
+
+static void testMultiply(std::mt19937& random) {
+    // Operands up to 180 in magnitude, so every product stays in range
+    std::uniform_int_distribution<fixed_t> operands(-180 * FIXED_ONE, 180 * FIXED_ONE);
+    double worst = 0;
+    for (int i = 0; i < 1000000; i++) {
+        fixed_t a = operands(random);
+        fixed_t b = operands(random);
+        worst = std::max(worst, fabs(exact(fixedMul(a, b)) - exact(a) * exact(b)));
+    }
+    CHECK(worst <= STEP / 2);
+    CHECK(fixedMul(FIXED_ONE, fixedFromInt(-7)) == fixedFromInt(-7));
+}
+
+// The filter as SensorManager runs it, against the exact filter in double
+// with TEMPERATURE_FILTER_ALPHA, over DHT11-like integer readings and noisy
+// fractional ones
+static void testFilter(std::mt19937& random) {
+    static ConfigStore configStore;
+    static TimeService timeService;
+    configStore.begin();
+    timeService.begin(&configStore);
+    SensorManager sensor;
+    sensor.begin(&timeService);
+
+    std::uniform_int_distribution<int> steps(-1, 1);
+    std::normal_distribution<float> noise(0, 0.3f);
+    double bound = 1.5 * STEP / TEMPERATURE_FILTER_ALPHA;
+    double reference = 0;
+    double worst = 0;
+    float room = 22;
+    hostDHTHumidity = 50;
+    for (int i = 0; i < 100000; i++) {
+        room = constrain(room + steps(random) * 0.05f, 10.0f, 35.0f);
+        hostDHTTemperature = i < 50000 ? roundf(room) : room + noise(random);
+        hostAdvanceMillis(DHT_UPLOAD_INTERVAL);
+        sensor.readAndUploadData();
+
+        reference = i == 0 ? hostDHTTemperature
+                           : reference + TEMPERATURE_FILTER_ALPHA * (hostDHTTemperature - reference);
+        worst = std::max(worst, fabs(exact(sensor.getFilteredTemperature()) - reference));
+    }
+    printf("Filter: worst deviation %.7f C, bound %.7f C\n", worst, bound);
+    CHECK(worst <= bound);
+}
+
+// One filter step per reading in each representation. On the host both are
+// a few hardware instructions; on the ESP8266 the float step is soft-float
+// library calls, so only the shape of the comparison carries over.
+static void benchmark() {
+    const int count = 1000;
+    const int rounds = 20000;
+    static volatile float readings[count];
+    static fixed_t fixedReadings[count];
+    for (int i = 0; i < count; i++) {
+        readings[i] = 20 + (i % 13) * 0.5f;
+        fixedReadings[i] = fixedFromFloat(readings[i]);
+    }
+    static constexpr fixed_t alpha = fixedFromFloat(TEMPERATURE_FILTER_ALPHA);
+
+    auto start = std::chrono::steady_clock::now();
+    volatile fixed_t fixedState = fixedReadings[0];
+    for (int round = 0; round < rounds; round++) {
+        fixed_t state = fixedState;
+        for (int i = 0; i < count; i++) state += fixedMul(alpha, fixedReadings[i] - state);
+        fixedState = state;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    volatile float floatState = readings[0];
+    for (int round = 0; round < rounds; round++) {
+        float state = floatState;
+        for (int i = 0; i < count; i++) state += (float)TEMPERATURE_FILTER_ALPHA * (readings[i] - state);
+        floatState = state;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double steps = (double)count * rounds;
+    printf("Filter step: %.2f ns fixed point, %.2f ns float (host)\n",
+           std::chrono::duration<double, std::nano>(middle - start).count() / steps,
+           std::chrono::duration<double, std::nano>(end - middle).count() / steps);
+}
+
+int main() {
+    std::mt19937 random(45);
+    testConversion(random);
+    testMultiply(random);
+    testFilter(random);
+    benchmark();
+    return testResult();
+}
@@ -0,0 +1,68 @@
+// CloudJournal replay: compact() returns the newest entry per field from the
+// RAM tail and the flash ring, across ring wrap, reboot and a full flash
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "TestSupport.h"
+#include "../src/Firebase/CloudJournal.h"
+
+static void checkLatest(CloudJournal& journal, uint8_t expectedPresent, float temperature, float humidity) {
+    JournalEntry latest[JOURNAL_FIELD_COUNT];
+    uint8_t present = journal.compact(latest);
+    CHECK(present == expectedPresent);
+    if (present & (1 << JOURNAL_FIELD_TEMPERATURE)) CHECK(latest[JOURNAL_FIELD_TEMPERATURE].value == temperature);
+    if (present & (1 << JOURNAL_FIELD_HUMIDITY)) CHECK(latest[JOURNAL_FIELD_HUMIDITY].value == humidity);
+}
+
+int main() {
+    CloudJournal journal;
+    journal.begin();
+    checkLatest(journal, 0, 0, 0);
+
+    // A humidity reading, then enough temperatures to push it out of RAM and
+    // far back in the flash ring
+    journal.append(JOURNAL_FIELD_HUMIDITY, 40, 1000);
+    for (int i = 0; i < 600; i++) journal.append(JOURNAL_FIELD_TEMPERATURE, 20 + i * 0.01f, 1001 + i);
+    checkLatest(journal, 3, 20 + 599 * 0.01f, 40);
+
+    // Past the ring's capacity the humidity reading is overwritten
+    for (int i = 0; i < CLOUD_JOURNAL_FLASH_ENTRIES; i++) journal.append(JOURNAL_FIELD_TEMPERATURE, 30, 2000 + i);
+    checkLatest(journal, 1 << JOURNAL_FIELD_TEMPERATURE, 30, 0);
+
+    // Both fields in the RAM tail: the flash ring is not opened at all
+    journal.append(JOURNAL_FIELD_HUMIDITY, 55, 4000);
+    journal.append(JOURNAL_FIELD_TEMPERATURE, 21.5f, 4001);
+    LittleFS.failOpens = 1;
+    checkLatest(journal, 3, 21.5f, 55);
+    CHECK(LittleFS.failOpens == 1);
+    LittleFS.failOpens = 0;
+
+    // After a reboot only the flash ring remains; its newest entries win
+    for (int i = 0; i < CLOUD_JOURNAL_RAM_ENTRIES; i++) journal.append(JOURNAL_FIELD_TEMPERATURE, 22, 5000 + i);
+    CloudJournal restarted;
+    restarted.begin();
+    checkLatest(restarted, 3, 22, 55);
+
+    restarted.clear();
+    CHECK(restarted.isEmpty());
+    checkLatest(restarted, 0, 0, 0);
+
+    // A spill that comes up short keeps the RAM tail, less the oldest entry,
+    // and flash still holds only what its header describes
+    LittleFS.freeBytes = 2 * sizeof(JournalEntry);
+    for (int i = 0; i <= CLOUD_JOURNAL_RAM_ENTRIES; i++) restarted.append(JOURNAL_FIELD_HUMIDITY, i, 6000 + i);
+    LittleFS.freeBytes = -1;
+    CHECK(restarted.getCount() == CLOUD_JOURNAL_RAM_ENTRIES);
+    checkLatest(restarted, 1 << JOURNAL_FIELD_HUMIDITY, 0, CLOUD_JOURNAL_RAM_ENTRIES);
+    CloudJournal rebooted;
+    rebooted.begin();
+    CHECK(rebooted.isEmpty());
+
+    // The next spill puts the kept tail on flash
+    restarted.append(JOURNAL_FIELD_HUMIDITY, CLOUD_JOURNAL_RAM_ENTRIES + 1, 7000);
+    CHECK(restarted.getCount() == CLOUD_JOURNAL_RAM_ENTRIES + 1);
+    CloudJournal recovered;
+    recovered.begin();
+    CHECK(recovered.getCount() == CLOUD_JOURNAL_RAM_ENTRIES);
+    checkLatest(recovered, 1 << JOURNAL_FIELD_HUMIDITY, 0, CLOUD_JOURNAL_RAM_ENTRIES);
+    return testResult();
+}
@@ -0,0 +1,129 @@
+// Requests to the virtual devices behind BACNET_VIRTUAL_NETWORK, sent as
+// standard frames with an NPDU: range checks on writes, and the routing of
+// I-Am replies back to a Who-Is from a remote network
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "TestSupport.h"
+#include "../src/BACnet/BACnetProtocol.h"
+
+static const uint16_t REMOTE_NETWORK = 5;
+static const uint8_t REMOTE_ADDRESS = 7;
+
+static ConfigStore configStore;
+static TimeService timeService;
+static HeapMonitor heapMonitor;
+static TrendLogManager trendLogManager;
+static BACnetProtocol bacnetProtocol;
+static fixed_t lastWrite = FIXED_INVALID;
+
+static void recordWrite(uint32_t, uint16_t, uint32_t, fixed_t value) { lastWrite = value; }
+
+// NPDU for the first virtual device, or for all of them when broadcast,
+// optionally from a device on a remote network
+static std::vector<uint8_t> npdu(bool broadcast, bool remote) {
+    std::vector<uint8_t> header = {0x81, (uint8_t)(broadcast ? 0x0B : 0x0A), 0, 0, 0x01,
+                                   (uint8_t)(0x20 | (remote ? 0x08 : 0)), BACNET_VIRTUAL_NETWORK >> 8,
+                                   BACNET_VIRTUAL_NETWORK & 0xFF};
+    if (broadcast) {
+        header.push_back(0);
+    } else {
+        header.insert(header.end(), {1, 1});
+    }
+    if (remote) header.insert(header.end(), {REMOTE_NETWORK >> 8, REMOTE_NETWORK & 0xFF, 1, REMOTE_ADDRESS});
+    header.push_back(0xFF); // Hop count
+    return header;
+}
+
+static std::vector<HostDatagram> send(std::vector<uint8_t> frame) {
+    {
+        HostInternal scope;
+        frame[2] = frame.size() >> 8;
+        frame[3] = frame.size() & 0xFF;
+        hostUdpReceived.push_back({frame, IPAddress(192, 168, 1, 100), 47808});
+    }
+    hostAdvanceMillis(100);
+    bacnetProtocol.handle();
+    HostInternal scope;
+    std::vector<HostDatagram> sent = hostUdpSent;
+    hostUdpSent.clear();
+    return sent;
+}
+
+// WriteProperty of a REAL to the setpoint, AV 1; returns the error code, 0 for a Simple ACK
+static int writeSetpoint(float value) {
+    static uint8_t invokeId = 0;
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    std::vector<uint8_t> frame = npdu(false, false);
+    frame.insert(frame.end(), {0x00, 0x05, ++invokeId, 0x0F, 0, OBJECT_ANALOG_VALUE, 0, 1, 0x19, PROP_PRESENT_VALUE,
+                               0x3E, 0x44, (uint8_t)(raw >> 24), (uint8_t)(raw >> 16), (uint8_t)(raw >> 8),
+                               (uint8_t)raw, 0x3F});
+    std::vector<HostDatagram> sent = send(frame);
+    if (sent.size() != 1) return -1;
+    const std::vector<uint8_t>& reply = sent[0].data;
+    if (reply.size() >= 3 && reply[reply.size() - 3] == 0x20) return 0;
+    if (reply.size() >= 5 && reply[reply.size() - 5] == 0x05) return reply.back();
+    return -1;
+}
+
+static void testWriteRange() {
+    CHECK(writeSetpoint(22.5f) == 0);
+    CHECK(lastWrite == fixedFromFloat(22.5f));
+    CHECK(writeSetpoint(THERMOSTAT_SETPOINT_MAX) == 0);
+
+    lastWrite = FIXED_INVALID;
+    CHECK(writeSetpoint(40) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeSetpoint(THERMOSTAT_SETPOINT_MIN - 0.5f) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeSetpoint(NAN) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeSetpoint(INFINITY) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(lastWrite == FIXED_INVALID);
+}
+
+// The I-Am leaves as a broadcast from the virtual device; for a remote
+// asker it also carries DNET 0xFFFF so its router passes it on
+static void testWhoIs(bool remote) {
+    std::vector<uint8_t> frame = npdu(true, remote);
+    frame.insert(frame.end(), {0x10, 0x08});
+    std::vector<HostDatagram> sent = send(frame);
+    CHECK(sent.size() == 1);
+    if (sent.size() != 1) return;
+
+    std::vector<uint8_t> expected = {0x81, 0x0B, 0, (uint8_t)sent[0].data.size(), 0x01};
+    if (remote) {
+        expected.insert(expected.end(), {0x28, 0xFF, 0xFF, 0});
+    } else {
+        expected.push_back(0x08);
+    }
+    expected.insert(expected.end(), {BACNET_VIRTUAL_NETWORK >> 8, BACNET_VIRTUAL_NETWORK & 0xFF, 1, 1});
+    if (remote) expected.push_back(0xFF);
+    expected.insert(expected.end(), {0x10, 0x00});
+    CHECK(sent[0].data.size() > expected.size());
+    CHECK(std::equal(expected.begin(), expected.end(), sent[0].data.begin()));
+}
+
+int main() {
+    configStore.begin();
+    timeService.begin(&configStore);
+    trendLogManager.begin(&timeService);
+    bacnetProtocol.setTrendLogManager(&trendLogManager);
+    bacnetProtocol.setConfigStore(&configStore);
+    bacnetProtocol.setTimeService(&timeService);
+    bacnetProtocol.setHeapMonitor(&heapMonitor);
+
+    // The climate zone as main.ino registers it
+    BACnetRouter& router = bacnetProtocol.getRouter();
+    uint8_t zone = router.addDevice(BACNET_CLIMATE_DEVICE_ID, "SBMCon_Climate");
+    router.addObject(zone, OBJECT_ANALOG_VALUE, 1, "Zone_Setpoint", true, fixedFromFloat(THERMOSTAT_SETPOINT_MIN),
+                     fixedFromFloat(THERMOSTAT_SETPOINT_MAX));
+    router.onWrite(recordWrite);
+    bacnetProtocol.begin();
+    {
+        HostInternal scope;
+        hostUdpSent.clear();
+    }
+
+    testWriteRange();
+    testWhoIs(false);
+    testWhoIs(true);
+    return testResult();
+}
@@ -0,0 +1,79 @@
+// Rule upload: compiler errors, actions on condition changes, and that a
+// program is only activated once it is in flash
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "TestSupport.h"
+#include "../src/Rules/RulesEngine.h"
+
+static int actionCount = 0;
+static RulePoint lastPoint;
+static float lastValue;
+
+static void recordAction(RulePoint point, float value) {
+    actionCount++;
+    lastPoint = point;
+    lastValue = value;
+}
+
+static void setTemperature(RulesEngine& rules, float value) {
+    rules.setInput(RULE_POINT_TEMPERATURE, value);
+    rules.handle();
+}
+
+static void testErrors(RulesEngine& rules) {
+    char error[96];
+    CHECK(!rules.upload("when temperature > 26 then led=on", error, sizeof(error)));
+    CHECK(strcmp(error, "Rule 1: expected 'if', found 'when'") == 0);
+    CHECK(!rules.upload("if humidity > 60 then led=on\nif \"warmth\\\" > 26 then led=on", error, sizeof(error)));
+    CHECK(strcmp(error, "Rule 2: unknown point '\"warmth\\\"'") == 0);
+    CHECK(!rules.upload("if temperature > 26 then temperature=20", error, sizeof(error)));
+    CHECK(rules.getRuleCount() == 0);
+}
+
+static void testActions(RulesEngine& rules) {
+    char error[96];
+    CHECK(rules.upload("if temperature > 26 then setpoint=23 else setpoint=24", error, sizeof(error)));
+    CHECK(rules.getRuleCount() == 1);
+
+    actionCount = 0;
+    setTemperature(rules, 25);
+    CHECK(actionCount == 1 && lastPoint == RULE_POINT_SETPOINT && lastValue == 24);
+    setTemperature(rules, 25.5f);
+    CHECK(actionCount == 1);
+    setTemperature(rules, 27);
+    CHECK(actionCount == 2 && lastValue == 23);
+}
+
+// A program that cannot be saved is not run, and the previous one stays both
+// active and in flash
+static void testFailedSave(RulesEngine& rules) {
+    char error[96];
+    LittleFS.failOpens = 1;
+    CHECK(!rules.upload("if temperature > 30 then led=on", error, sizeof(error)));
+    CHECK(strcmp(error, "Rules not saved to flash, previous rules kept") == 0);
+
+    actionCount = 0;
+    setTemperature(rules, 31);
+    setTemperature(rules, 25);
+    CHECK(actionCount == 1 && lastPoint == RULE_POINT_SETPOINT && lastValue == 24);
+
+    RulesEngine restarted;
+    restarted.onAction(recordAction);
+    restarted.begin();
+    CHECK(restarted.getRuleCount() == 1);
+    actionCount = 0;
+    setTemperature(restarted, 31);
+    CHECK(actionCount == 1 && lastPoint == RULE_POINT_SETPOINT && lastValue == 23);
+}
+
+int main() {
+    RulesEngine rules;
+    rules.onAction(recordAction);
+    rules.begin();
+    CHECK(rules.getRuleCount() == 0);
+
+    testErrors(rules);
+    testActions(rules);
+    testFailedSave(rules);
+    return testResult();
+}
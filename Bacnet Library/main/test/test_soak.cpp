@@ -0,0 +1,183 @@
+// Soak of the steady-state paths: several simulated days of BACnet traffic,
+// sensor reads, control, trend logging, rules and journal appends. After
+// warm-up the code under test must not allocate at all, and its live heap
+// must stay exactly flat.
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <new>
+#include "TestSupport.h"
+#include "../src/BACnet/BACnetProtocol.h"
+#include "../src/Control/ThermostatManager.h"
+#include "../src/Firebase/CloudJournal.h"
+#include "../src/Rules/RulesEngine.h"
+#include "../src/Sensors/SensorManager.h"
+
+// Heap use of the code under test; blocks the host stand-ins allocate (the
+// in-memory files and datagram queues) are tagged and left out
+struct alignas(16) BlockHeader {
+    size_t size;
+    bool counted;
+};
+
+static size_t liveBytes = 0;
+static size_t allocationCount = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    BlockHeader* block = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+    if (block == nullptr) throw std::bad_alloc();
+    block->size = size;
+    block->counted = hostInternalDepth == 0;
+    if (block->counted) {
+        liveBytes += size;
+        allocationCount++;
+    }
+    return block + 1;
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) return;
+    BlockHeader* block = (BlockHeader*)pointer - 1;
+    if (block->counted) liveBytes -= block->size;
+    free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+static const unsigned long SOAK_DAYS = 5;
+static const unsigned long WARM_UP_HOURS = 60; // Trend logs fill their 2880-record rings after 48 h
+
+static ConfigStore configStore;
+static TimeService timeService;
+static HeapMonitor heapMonitor;
+static TrendLogManager trendLogManager;
+static BACnetProtocol bacnetProtocol;
+static SensorManager sensorManager;
+static ThermostatManager thermostatManager;
+static RulesEngine rulesEngine;
+static CloudJournal cloudJournal;
+
+static void applyRuleAction(RulePoint point, float value) {
+    if (point == RULE_POINT_SETPOINT) thermostatManager.setSetpoint(fixedFromFloat(value));
+}
+
+// Frames in this stack's layout: BVLC, one NPDU byte pair and the APDU,
+// with 16-bit object types and instances
+static void receive(const uint8_t* frame, size_t length, uint8_t client) {
+    HostInternal scope;
+    HostDatagram datagram = {std::vector<uint8_t>(frame, frame + length), IPAddress(192, 168, 1, 100 + client), 47808};
+    datagram.data[2] = length >> 8;
+    datagram.data[3] = length;
+    hostUdpReceived.push_back(datagram);
+}
+
+static void readProperty(uint8_t invokeId, uint16_t objectType, uint16_t instance, uint8_t property, uint8_t client) {
+    uint8_t frame[] = {0x81, 0x10, 0, 0, 0x01, invokeId, 0x0C, (uint8_t)(objectType >> 8), (uint8_t)objectType,
+                       (uint8_t)(instance >> 8), (uint8_t)instance, 0x19, property};
+    receive(frame, sizeof(frame), client);
+}
+
+static void writeBrightness(uint8_t invokeId, float value, uint8_t client) {
+    uint8_t bits[4];
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    for (int i = 0; i < 4; i++) bits[i] = raw >> (24 - 8 * i);
+    uint8_t frame[] = {0x81, 0x10, 0, 0, 0x01, invokeId, 0x0F, 0, OBJECT_ANALOG_OUTPUT, 0, 2, 0x19, PROP_PRESENT_VALUE,
+                       0x3E, 0x44, bits[0], bits[1], bits[2], bits[3], 0x3F, 0x49, 8};
+    receive(frame, sizeof(frame), client);
+}
+
+static void readRange(uint8_t invokeId, uint8_t client) {
+    // By position: the oldest 20 records of the temperature log
+    uint8_t frame[] = {0x81, 0x10, 0, 0, 0x01, invokeId, 0x1A, 0, OBJECT_TRENDLOG, 0, TRENDLOG_TEMPERATURE_ID, 0x19,
+                       PROP_LOG_BUFFER, 0x3E, 0x21, 0x01, 0x31, 0x14, 0x3F};
+    receive(frame, sizeof(frame), client);
+}
+
+static void whoIs(uint8_t client) {
+    uint8_t frame[] = {0x81, 0x00, 0, 0, 0x08};
+    receive(frame, sizeof(frame), client);
+}
+
+static void runSecond(unsigned long second) {
+    static const uint8_t properties[] = {PROP_PRESENT_VALUE, PROP_OBJECT_NAME, PROP_PRIORITY_ARRAY, PROP_OBJECT_TYPE};
+    uint8_t invokeId = second;
+    uint8_t client = second % 3;
+
+    // Room temperature drifts slowly; the DHT11 fails now and then
+    hostDHTTemperature = second % 997 == 0 ? NAN : 22 + (second / 600) % 6;
+    hostDHTHumidity = 45 + (second / 900) % 10;
+
+    readProperty(invokeId, OBJECT_ANALOG_INPUT, 3, properties[second % 4], client);
+    if (second % 10 == 0) writeBrightness(invokeId + 1, (second / 10) % 100, client);
+    if (second % 60 == 0) whoIs(client);
+    if (second % 300 == 0) readRange(invokeId + 2, client);
+    // Every other write is retried a second later and answered from the reply cache
+    if (second % 20 == 1) writeBrightness(invokeId, ((second - 1) / 10) % 100, (second - 1) % 3);
+
+    for (int pass = 0; pass < 10; pass++) {
+        hostAdvanceMillis(100);
+        timeService.handle();
+        configStore.handle();
+        bacnetProtocol.handle();
+        heapMonitor.handle();
+        sensorManager.readAndUploadData();
+        thermostatManager.handle(sensorManager.getFilteredTemperature());
+        trendLogManager.handle(sensorManager.getTemperature(), sensorManager.getHumidity());
+        bacnetProtocol.updateAnalogInput(3, sensorManager.getTemperature());
+        bacnetProtocol.updateAnalogInput(4, sensorManager.getHumidity());
+        bacnetProtocol.broadcastPresence();
+        rulesEngine.setInput(RULE_POINT_TEMPERATURE, fixedToFloat(sensorManager.getFilteredTemperature()));
+        rulesEngine.handle();
+    }
+    if (second % 60 == 0) {
+        cloudJournal.append(JOURNAL_FIELD_TEMPERATURE, hostDHTTemperature, timeService.epochSeconds());
+        cloudJournal.append(JOURNAL_FIELD_HUMIDITY, hostDHTHumidity, timeService.epochSeconds());
+    }
+    HostInternal scope;
+    hostUdpSent.clear();
+}
+
+int main() {
+    configStore.begin();
+    thermostatManager.begin(&configStore);
+    timeService.begin(&configStore);
+    bacnetProtocol.setTrendLogManager(&trendLogManager);
+    bacnetProtocol.setConfigStore(&configStore);
+    bacnetProtocol.setTimeService(&timeService);
+    bacnetProtocol.setHeapMonitor(&heapMonitor);
+    bacnetProtocol.begin();
+    sensorManager.begin(&timeService);
+    trendLogManager.begin(&timeService);
+    cloudJournal.begin();
+    rulesEngine.onAction(applyRuleAction);
+    rulesEngine.begin();
+    char error[64];
+    CHECK(rulesEngine.upload("if temperature > 26 then setpoint=23 else setpoint=24", error, sizeof(error)));
+    thermostatManager.setMode(THERMOSTAT_MODE_COOL);
+
+    const unsigned long totalSeconds = SOAK_DAYS * 86400;
+    size_t baselineBytes = 0;
+    size_t baselineAllocations = 0;
+    for (unsigned long second = 1; second <= totalSeconds; second++) {
+        runSecond(second);
+
+        if (second == WARM_UP_HOURS * 3600) {
+            baselineBytes = liveBytes;
+            baselineAllocations = allocationCount;
+        }
+        if (second > WARM_UP_HOURS * 3600 && second % 3600 == 0) {
+            CHECK(liveBytes == baselineBytes);
+            CHECK(allocationCount == baselineAllocations);
+        }
+    }
+
+    size_t soakAllocations = allocationCount - baselineAllocations;
+    printf("Soak: %lu simulated hours, %zu live heap bytes after warm-up, %zu at the end, "
+           "%zu allocations in between\n", SOAK_DAYS * 24, baselineBytes, liveBytes, soakAllocations);
+    CHECK(bacnetProtocol.getRetriesAnswered() > 0);
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == TREND_LOG_CAPACITY);
+    return testResult();
+}
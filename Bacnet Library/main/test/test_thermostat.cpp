@@ -0,0 +1,151 @@
+// Closed-loop check of the thermostat against a first-order room model, and
+// of the sensor fault path that takes the relay off a stale temperature
+#include <Arduino.h>
+#include "TestSupport.h"
+#include "../src/Control/ThermostatManager.h"
+#include "../src/Sensors/SensorManager.h"
+
+// Room heat balance per second: leakage towards the outdoor temperature plus
+// the AC's cooling or heating while the relay is on
+struct Room {
+    float temperature;
+    float outdoor;
+    float leakage = 0.0005;    // Fraction of the indoor-outdoor difference per second
+    float acPower = 0.01;      // C per second with the relay on
+};
+
+static ConfigStore configStore;
+static TimeService timeService;
+
+static void stepRoom(Room& room, bool relayOn, bool heating) {
+    room.temperature += (room.outdoor - room.temperature) * room.leakage;
+    if (relayOn) room.temperature += heating ? room.acPower : -room.acPower;
+}
+
+// Runs the sensor, filter and controller once per simulated second and
+// returns the number of relay switches; band receives the settled range
+static int simulate(ThermostatManager& thermostat, SensorManager& sensor, Room& room, unsigned long seconds,
+                    float* low, float* high) {
+    int switches = 0;
+    bool wasOn = thermostat.isRelayOn();
+    unsigned long lastSwitch = millis();
+    *low = 1000;
+    *high = -1000;
+    for (unsigned long second = 0; second < seconds; second++) {
+        hostAdvanceMillis(1000);
+        hostDHTTemperature = roundf(room.temperature); // DHT11 resolution is 1 C
+        sensor.readAndUploadData();
+        thermostat.handle(sensor.getFilteredTemperature());
+        stepRoom(room, thermostat.isRelayOn(), thermostat.isHeating());
+
+        if (thermostat.isRelayOn() != wasOn) {
+            // Compressor protection: no state lasts less than its minimum time
+            CHECK(millis() - lastSwitch >= (wasOn ? THERMOSTAT_MIN_ON_TIME : THERMOSTAT_MIN_OFF_TIME));
+            CHECK(hostPinLevel[AC_RELAY_BO] == (thermostat.isRelayOn() ? HIGH : LOW));
+            wasOn = thermostat.isRelayOn();
+            lastSwitch = millis();
+            switches++;
+        }
+        // Judge the band only once the initial pull-down is over
+        if (second > seconds / 2) {
+            *low = min(*low, room.temperature);
+            *high = max(*high, room.temperature);
+        }
+    }
+    return switches;
+}
+
+static void testCoolingHoldsSetpoint() {
+    ThermostatManager thermostat;
+    SensorManager sensor;
+    thermostat.begin(&configStore);
+    sensor.begin(&timeService);
+    thermostat.setSetpoint(fixedFromFloat(24));
+    thermostat.setMode(THERMOSTAT_MODE_COOL);
+
+    Room room = {30, 32};
+    hostDHTHumidity = 50;
+    float low, high;
+    int switches = simulate(thermostat, sensor, room, 6 * 3600, &low, &high);
+
+    CHECK(!thermostat.isHeating());
+    CHECK(switches > 2);
+    // Held around the setpoint within the DHT11 step and the minimum on/off times
+    CHECK(low > 22.0f);
+    CHECK(high < 26.0f);
+    // At most one cycle per minimum on plus off time
+    CHECK(switches <= (int)(6 * 3600000UL / THERMOSTAT_MIN_ON_TIME));
+}
+
+static void testAutoChangesOverToHeating() {
+    ThermostatManager thermostat;
+    SensorManager sensor;
+    thermostat.begin(&configStore);
+    sensor.begin(&timeService);
+    thermostat.setSetpoint(fixedFromFloat(21));
+    thermostat.setMode(THERMOSTAT_MODE_AUTO);
+
+    Room room = {15, 5};
+    float low, high;
+    simulate(thermostat, sensor, room, 6 * 3600, &low, &high);
+
+    CHECK(thermostat.isHeating());
+    CHECK(low > 19.0f);
+    CHECK(high < 23.0f);
+}
+
+static void testSensorFaultStopsRelay() {
+    ThermostatManager thermostat;
+    SensorManager sensor;
+    thermostat.begin(&configStore);
+    sensor.begin(&timeService);
+    thermostat.setSetpoint(fixedFromFloat(20));
+    thermostat.setMode(THERMOSTAT_MODE_COOL);
+
+    // Far above setpoint: the relay comes on once the minimum off time has passed
+    hostDHTTemperature = 30;
+    hostDHTHumidity = 50;
+    for (unsigned long second = 0; second < THERMOSTAT_MIN_OFF_TIME / 1000 + 10; second++) {
+        hostAdvanceMillis(1000);
+        sensor.readAndUploadData();
+        thermostat.handle(sensor.getFilteredTemperature());
+    }
+    CHECK(thermostat.isRelayOn());
+    CHECK(fixedIsValid(sensor.getFilteredTemperature()));
+
+    // A short dropout keeps the last reading
+    hostDHTTemperature = NAN;
+    for (int read = 1; read < DHT_MAX_FAILED_READS; read++) {
+        hostAdvanceMillis(DHT_UPLOAD_INTERVAL);
+        sensor.readAndUploadData();
+    }
+    CHECK(fixedIsValid(sensor.getFilteredTemperature()));
+
+    // A lasting one invalidates it, and the relay goes off after its minimum on time
+    hostAdvanceMillis(DHT_UPLOAD_INTERVAL);
+    sensor.readAndUploadData();
+    CHECK(!fixedIsValid(sensor.getTemperature()));
+    CHECK(!fixedIsValid(sensor.getFilteredTemperature()));
+    CHECK(!fixedIsValid(sensor.getHumidity()));
+    for (unsigned long second = 0; second < THERMOSTAT_MIN_ON_TIME / 1000; second++) {
+        hostAdvanceMillis(1000);
+        sensor.readAndUploadData();
+        thermostat.handle(sensor.getFilteredTemperature());
+    }
+    CHECK(!thermostat.isRelayOn());
+    CHECK(hostPinLevel[AC_RELAY_BO] == LOW);
+
+    // The first good reading restarts the filter from that value
+    hostDHTTemperature = 25;
+    hostAdvanceMillis(DHT_UPLOAD_INTERVAL);
+    sensor.readAndUploadData();
+    CHECK(sensor.getFilteredTemperature() == fixedFromFloat(25));
+}
+
+int main() {
+    configStore.begin();
+    testCoolingHoldsSetpoint();
+    testAutoChangesOverToHeating();
+    testSensorFaultStopsRelay();
+    return testResult();
+}
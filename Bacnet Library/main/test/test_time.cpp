@@ -0,0 +1,37 @@
+// TimeService corrections: small offsets are slewed, large ones step the
+// clock, and the reported correction keeps its full 64-bit size
+#include <Arduino.h>
+#include "TestSupport.h"
+#include "../src/System/TimeService.h"
+
+static const uint64_t EPOCH = 1790000000ULL * 1000000;
+static const uint64_t HOUR = 3600ULL * 1000000;
+
+int main() {
+    ConfigStore configStore;
+    TimeService timeService;
+    configStore.begin();
+    timeService.begin(&configStore);
+
+    timeService.synchronize(EPOCH, TIME_SOURCE_SNTP);
+    CHECK(timeService.isSynchronized());
+    CHECK(timeService.getLastCorrection() == 0);
+
+    // 0.5 s fast: slewed, so the clock does not jump
+    hostAdvanceMillis(1000);
+    timeService.synchronize(EPOCH + 1500000, TIME_SOURCE_SNTP);
+    CHECK(timeService.getLastCorrection() == 500000);
+    CHECK(timeService.epochMicros() < EPOCH + 1500000);
+
+    // An hour off, as from a server on the wrong time zone: over 2^31 us
+    hostAdvanceMillis(1000);
+    uint64_t expected = timeService.epochMicros() + HOUR;
+    timeService.synchronize(expected, TIME_SOURCE_SNTP);
+    CHECK(timeService.getLastCorrection() > INT32_MAX);
+    CHECK_NEAR(timeService.getLastCorrection(), (double)HOUR, 1000);
+    CHECK(timeService.epochMicros() == expected);
+
+    timeService.synchronize(expected - 2 * HOUR, TIME_SOURCE_SNTP);
+    CHECK(timeService.getLastCorrection() == -(int64_t)(2 * HOUR));
+    return testResult();
+}
@@ -0,0 +1,131 @@
+// Trend log reads across the flash ring and the RAM tail, including a file
+// system that fails to open the log, returns short reads or fills up mid-flush
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "TestSupport.h"
+#include "../src/TrendLog/TrendLogManager.h"
+
+static ConfigStore configStore;
+static TimeService timeService;
+static TrendLogManager trendLogManager;
+
+static uint32_t nextValue = 0;
+
+// One sample per TREND_LOG_INTERVAL, counting up so a record's value is its
+// index for as long as no sample is dropped
+static void logSamples(int count) {
+    for (int i = 0; i < count; i++, nextValue++) {
+        hostAdvanceMillis(TREND_LOG_INTERVAL);
+        trendLogManager.handle(fixedFromFloat(nextValue), fixedFromFloat(50));
+    }
+}
+
+static bool recordsInOrder(const TrendRecord* records, uint16_t count, uint32_t firstIndex) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (records[i].value != (float)(firstIndex + i)) return false;
+    }
+    return true;
+}
+
+static void testReadsFlashAndTail() {
+    TrendRecord records[40];
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == 40);
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 40) == 40);
+    CHECK(recordsInOrder(records, 40, 0));
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 30, records, 40) == 10);
+    CHECK(recordsInOrder(records, 10, 30));
+}
+
+static void testOpenFailure() {
+    TrendRecord records[40];
+    // Flash records are unavailable, and the tail must not be read in their place
+    LittleFS.failOpens = 1;
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 40) == 0);
+    // The tail alone needs no file
+    LittleFS.failOpens = 1;
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 2 * TREND_LOG_TAIL_SIZE, records, 40) == 8);
+    CHECK(recordsInOrder(records, 8, 2 * TREND_LOG_TAIL_SIZE));
+    LittleFS.failOpens = 0;
+}
+
+static void testShortRead() {
+    TrendRecord records[40];
+    // Two and a half records per read: the whole ones are kept, the batch ends there
+    LittleFS.shortReads = 5 * sizeof(TrendRecord) / 2;
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 40) == 2);
+    CHECK(recordsInOrder(records, 2, 0));
+    LittleFS.shortReads = 0;
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 40) == 40);
+}
+
+static bool sequencesContiguous(const TrendRecord* records, uint16_t count, uint32_t firstSequence) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (records[i].sequence != firstSequence + i) return false;
+    }
+    return true;
+}
+
+static void testFailedFlush() {
+    TrendRecord records[128];
+    trendLogManager.flush();
+    uint32_t first = trendLogManager.getFirstSequence(TRENDLOG_TEMPERATURE_ID);
+    uint32_t stored = trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID);
+    uint32_t value = nextValue;
+    // Twenty samples while the log cannot be opened: the tail fills and then
+    // keeps only the newest TREND_LOG_TAIL_SIZE of them
+    LittleFS.failOpens = 1000;
+    logSamples(20);
+    LittleFS.failOpens = 0;
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == stored + TREND_LOG_TAIL_SIZE);
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, stored, records, 128) == TREND_LOG_TAIL_SIZE);
+    CHECK(recordsInOrder(records, TREND_LOG_TAIL_SIZE, value + 20 - TREND_LOG_TAIL_SIZE));
+    CHECK(sequencesContiguous(records, TREND_LOG_TAIL_SIZE, first + stored));
+
+    // The next sample drops the oldest again and the retried flush puts the tail on flash
+    logSamples(1);
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == stored + TREND_LOG_TAIL_SIZE);
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 128) == stored + TREND_LOG_TAIL_SIZE);
+    CHECK(recordsInOrder(records + stored, TREND_LOG_TAIL_SIZE, value + 21 - TREND_LOG_TAIL_SIZE));
+    CHECK(sequencesContiguous(records, stored + TREND_LOG_TAIL_SIZE, first));
+    CHECK(trendLogManager.getFirstSequence(TRENDLOG_TEMPERATURE_ID) == first);
+}
+
+static void testShortWrite() {
+    TrendRecord records[128];
+    trendLogManager.flush();
+    uint32_t first = trendLogManager.getFirstSequence(TRENDLOG_TEMPERATURE_ID);
+    uint32_t stored = trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID);
+    uint32_t value = nextValue;
+    // Room for three records: the flush stops there and the header on flash
+    // must not claim the rest
+    LittleFS.freeBytes = 3 * sizeof(TrendRecord);
+    logSamples(TREND_LOG_TAIL_SIZE);
+    LittleFS.freeBytes = -1;
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == stored + TREND_LOG_TAIL_SIZE);
+
+    // A fresh manager sees only what the last good header described
+    TrendLogManager restarted;
+    restarted.begin(&timeService);
+    CHECK(restarted.getRecordCount(TRENDLOG_TEMPERATURE_ID) == stored);
+
+    logSamples(1);
+    CHECK(trendLogManager.getRecordCount(TRENDLOG_TEMPERATURE_ID) == stored + TREND_LOG_TAIL_SIZE);
+    CHECK(trendLogManager.readRecords(TRENDLOG_TEMPERATURE_ID, 0, records, 128) == stored + TREND_LOG_TAIL_SIZE);
+    CHECK(recordsInOrder(records + stored, TREND_LOG_TAIL_SIZE, value + 1));
+    CHECK(sequencesContiguous(records, stored + TREND_LOG_TAIL_SIZE, first));
+}
+
+int main() {
+    configStore.begin();
+    timeService.begin(&configStore);
+    trendLogManager.begin(&timeService);
+    // Two tails flushed to flash, eight records still pending in RAM
+    logSamples(2 * TREND_LOG_TAIL_SIZE + 8);
+
+    testReadsFlashAndTail();
+    testOpenFailure();
+    testShortRead();
+    testFailedFlush();
+    testShortWrite();
+    return testResult();
+}
@@ -0,0 +1,88 @@
+// WriteProperty to the physical outputs: values the LED and dimmer cannot
+// take are rejected before they reach the priority array or the hardware
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "TestSupport.h"
+#include "../src/BACnet/BACnetProtocol.h"
+
+static ConfigStore configStore;
+static TimeService timeService;
+static HeapMonitor heapMonitor;
+static TrendLogManager trendLogManager;
+static BACnetProtocol bacnetProtocol;
+static int outputWrites = 0;
+
+static void recordOutput(uint32_t, fixed_t) { outputWrites++; }
+
+// WriteProperty of a REAL to an output's Present_Value; returns the error code, 0 for a Simple ACK
+static int writeOutput(uint16_t objectType, uint16_t instance, float value) {
+    static uint8_t invokeId = 0;
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    {
+        HostInternal scope;
+        std::vector<uint8_t> frame = {0x81, 0x10, 0, 20, 0x01, ++invokeId, 0x0F, (uint8_t)(objectType >> 8),
+                                      (uint8_t)objectType, (uint8_t)(instance >> 8), (uint8_t)instance, 0x19,
+                                      PROP_PRESENT_VALUE, 0x3E, 0x44, (uint8_t)(raw >> 24), (uint8_t)(raw >> 16),
+                                      (uint8_t)(raw >> 8), (uint8_t)raw, 0x3F};
+        hostUdpReceived.push_back({frame, IPAddress(192, 168, 1, 100), 47808});
+    }
+    hostAdvanceMillis(100);
+    bacnetProtocol.handle();
+
+    HostInternal scope;
+    std::vector<HostDatagram> sent = hostUdpSent;
+    hostUdpSent.clear();
+    if (sent.size() != 1) return -1;
+    const std::vector<uint8_t>& reply = sent[0].data;
+    if (reply.size() >= 3 && reply[reply.size() - 3] == 0x20) return 0;
+    if (reply.size() >= 5 && reply[reply.size() - 5] == 0x05) return reply.back();
+    return -1;
+}
+
+static void testDimmer() {
+    outputWrites = 0;
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, 128) == 0);
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, 255) == 0);
+    CHECK(outputWrites == 2);
+
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, 256) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, -1) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, NAN) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeOutput(OBJECT_ANALOG_OUTPUT, 2, INFINITY) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(outputWrites == 2);
+    CHECK(bacnetProtocol.getObject(2)->present_value == fixedFromFloat(255));
+}
+
+static void testLed() {
+    outputWrites = 0;
+    CHECK(writeOutput(OBJECT_BINARY_OUTPUT, 1, 1) == 0);
+    CHECK(writeOutput(OBJECT_BINARY_OUTPUT, 1, 0) == 0);
+    CHECK(outputWrites == 2);
+
+    // NaN compares unequal to zero and used to switch the LED on
+    CHECK(writeOutput(OBJECT_BINARY_OUTPUT, 1, NAN) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(writeOutput(OBJECT_BINARY_OUTPUT, 1, 0.5f) == ERROR_CODE_VALUE_OUT_OF_RANGE);
+    CHECK(outputWrites == 2);
+    CHECK(bacnetProtocol.getObject(1)->present_value == 0);
+}
+
+int main() {
+    configStore.begin();
+    timeService.begin(&configStore);
+    trendLogManager.begin(&timeService);
+    bacnetProtocol.setTrendLogManager(&trendLogManager);
+    bacnetProtocol.setConfigStore(&configStore);
+    bacnetProtocol.setTimeService(&timeService);
+    bacnetProtocol.setHeapMonitor(&heapMonitor);
+    bacnetProtocol.onOutputWrite(recordOutput);
+    bacnetProtocol.begin();
+    {
+        HostInternal scope;
+        hostUdpSent.clear();
+    }
+
+    testDimmer();
+    testLed();
+    return testResult();
+}
@@ -0,0 +1,114 @@
+#ifndef FADE_ENGINE_H
+#define FADE_ENGINE_H
+
+#include <Arduino.h>
+#include <Ticker.h>
+
+// Shared by the library sketch and the demo. Header-only, so it is compiled
+// with the including sketch's configuration, which must define these first.
+#if !defined(FADE_PWM_RANGE) || !defined(FADE_STEP_INTERVAL)
+#error "Include the sketch configuration (FADE_PWM_RANGE, FADE_STEP_INTERVAL) before FadeEngine.h"
+#endif
+
+#define FADE_LEVELS 256
+
+// Duty cycle for each brightness level (0-255), in PWM counts of FADE_PWM_RANGE
+typedef struct {
+    uint16_t duty[FADE_LEVELS];
+} FadeCurve;
+
+// CIE 1931 lightness: equal level steps look like equal brightness steps.
+// Evaluated by the compiler, so the table costs no start-up time.
+constexpr uint16_t perceptualDuty(int level) {
+    double lightness = level * 100.0 / (FADE_LEVELS - 1);
+    double luminance = lightness <= 8.0 ? lightness / 903.3
+                                        : ((lightness + 16.0) / 116.0) * ((lightness + 16.0) / 116.0) * ((lightness + 16.0) / 116.0);
+    return (uint16_t)(luminance * FADE_PWM_RANGE + 0.5);
+}
+
+constexpr FadeCurve buildPerceptualCurve() {
+    FadeCurve curve = {};
+    for (int level = 0; level < FADE_LEVELS; level++) {
+        curve.duty[level] = perceptualDuty(level);
+    }
+    return curve;
+}
+
+// Ramps one PWM pin towards a target level from a software timer, so
+// loop() does no per-step work. A new target preempts the fade in progress
+// and continues from the level currently on the pin.
+class FadeEngine {
+public:
+    void begin(uint8_t outputPin, uint8_t level) {
+        pin = outputPin;
+        analogWriteRange(FADE_PWM_RANGE);
+        currentLevel = targetLevel = (int32_t)level << 16;
+        writeLevel();
+    }
+
+    void fadeTo(uint8_t level, uint32_t duration) {
+        // Re-sending the current target leaves a fade in progress untouched
+        if (((int32_t)level << 16) == targetLevel) return;
+
+        uint32_t steps = duration / FADE_STEP_INTERVAL;
+        if (steps > 0xFFFF) steps = 0xFFFF;
+
+        noInterrupts();
+        targetLevel = (int32_t)level << 16;
+        if (steps == 0) {
+            currentLevel = targetLevel;
+            remainingSteps = 0;
+        } else {
+            stepSize = (targetLevel - currentLevel) / (int32_t)steps;
+            remainingSteps = steps;
+        }
+        interrupts();
+
+        if (remainingSteps == 0) {
+            ticker.detach();
+            writeLevel();
+        } else if (!ticker.active()) {
+            ticker.attach_ms(FADE_STEP_INTERVAL, onTick, this);
+        }
+    }
+
+    uint8_t getLevel() { return (currentLevel + 0x8000) >> 16; }
+    uint8_t getTarget() { return targetLevel >> 16; }
+    bool isFading() { return remainingSteps > 0; }
+
+private:
+    static constexpr FadeCurve curve PROGMEM = buildPerceptualCurve();
+
+    Ticker ticker;
+    uint8_t pin = 0;
+    uint16_t lastDuty = 0xFFFF;
+    // Levels in 16.16 fixed point so short fades over large spans stay exact
+    volatile int32_t currentLevel = 0;
+    volatile int32_t targetLevel = 0;
+    volatile int32_t stepSize = 0;
+    volatile uint16_t remainingSteps = 0;
+
+    static void onTick(FadeEngine* engine) { engine->step(); }
+
+    void step() {
+        if (remainingSteps > 0) {
+            remainingSteps--;
+            // Land exactly on the target whatever the rounding of stepSize
+            currentLevel = remainingSteps == 0 ? targetLevel : currentLevel + stepSize;
+        }
+        writeLevel();
+        if (remainingSteps == 0) {
+            ticker.detach();
+        }
+    }
+
+    void writeLevel() {
+        uint16_t duty = pgm_read_word(&curve.duty[getLevel()]);
+        if (duty != lastDuty) {
+            lastDuty = duty;
+            analogWrite(pin, duty);
+        }
+    }
+};
+
+#endif
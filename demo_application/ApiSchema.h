@@ -0,0 +1,51 @@
+#ifndef API_SCHEMA_H
+#define API_SCHEMA_H
+
+#include <Arduino.h>
+#include "Channels.h"
+
+// Body encodings of the HTTP API, chosen per request from Accept and Content-Type
+enum ApiFormat : uint8_t {
+    API_FORMAT_JSON,
+    API_FORMAT_CBOR
+};
+
+// Fields of /api/status and /api/channels. JSON uses the names, CBOR the
+// integer keys: a channel's key is its ChannelId, followed by these fields.
+// Multi-state channels are state names in JSON and state indexes in CBOR,
+// and the IP address is a 4-byte string in CBOR. Keys are never reused.
+// A delta status (?since=<version>&boot=<bootId>) holds the channels changed
+// after that version plus the delta fields below; the other status fields
+// are full-only. Versions restart with the device, so a request from another
+// boot (bootId differs) gets the full status.
+enum StatusField : uint8_t {
+    STATUS_FIELD_IP_ADDRESS = 32,
+    STATUS_FIELD_BACNET_DEVICE_ID,
+    STATUS_FIELD_BACNET_REJECTED,
+    STATUS_FIELD_UPTIME,
+    STATUS_FIELD_FREE_HEAP,
+    STATUS_FIELD_LARGEST_FREE_BLOCK,
+    STATUS_FIELD_HEAP_FRAGMENTATION,
+    STATUS_FIELD_VERSION,
+    STATUS_FIELD_BOOT_ID,
+    STATUS_FIELD_END
+};
+
+#define STATUS_FIELD_FIRST STATUS_FIELD_IP_ADDRESS
+#define STATUS_FIELD_COUNT (STATUS_FIELD_END - STATUS_FIELD_FIRST)
+
+static_assert((int)CHANNEL_COUNT <= (int)STATUS_FIELD_FIRST, "Channel keys run into the status field keys");
+
+// JSON names, indexed by StatusField - STATUS_FIELD_FIRST
+static const char* const STATUS_FIELD_KEYS[STATUS_FIELD_COUNT] = {
+    "ipAddress", "bacnetDeviceId", "bacnetRejected", "uptime", "freeHeap", "largestFreeBlock", "heapFragmentation", "version", "bootId"
+};
+
+// Fields sent in every status, delta or full
+static inline bool isDeltaField(uint8_t field) {
+    return field == STATUS_FIELD_UPTIME || field == STATUS_FIELD_VERSION || field == STATUS_FIELD_BOOT_ID;
+}
+
+#define STATUS_DELTA_FIELD_COUNT 3
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "Config.h"
+
+// CBOR (RFC 8949) major types
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_NULL 0xF6
+#define CBOR_HALF 0xF9
+#define CBOR_SINGLE 0xFA
+#define CBOR_DOUBLE 0xFB
+
+// Streams definite-length CBOR to a Print through a small buffer, so a
+// response goes out in a few TCP writes without being built in memory.
+// Whole numbers are sent as integers and the rest as single floats.
+class CborWriter {
+private:
+    Print& out;
+    uint8_t buffer[CBOR_WRITE_BUFFER];
+    size_t length = 0;
+    size_t total = 0;
+
+    void put(uint8_t value) {
+        if (length == sizeof(buffer)) flush();
+        buffer[length++] = value;
+    }
+
+    void put(const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++) put(data[i]);
+    }
+
+    // Initial byte and argument in the shortest form
+    void putHead(uint8_t major, uint32_t value) {
+        major <<= 5;
+        if (value < 24) {
+            put(major | value);
+        } else if (value <= 0xFF) {
+            put(major | 24);
+            put(value);
+        } else if (value <= 0xFFFF) {
+            put(major | 25);
+            put(value >> 8);
+            put(value);
+        } else {
+            put(major | 26);
+            put(value >> 24);
+            put(value >> 16);
+            put(value >> 8);
+            put(value);
+        }
+    }
+
+public:
+    explicit CborWriter(Print& output) : out(output) {}
+
+    void beginMap(uint32_t pairs) { putHead(CBOR_MAP, pairs); }
+    void writeUnsigned(uint32_t value) { putHead(CBOR_UNSIGNED, value); }
+    void writeBool(bool value) { put(value ? CBOR_TRUE : CBOR_FALSE); }
+    void writeNull() { put(CBOR_NULL); }
+
+    void writeInt(int32_t value) {
+        if (value < 0) {
+            putHead(CBOR_NEGATIVE, (uint32_t)(-1 - value));
+        } else {
+            putHead(CBOR_UNSIGNED, value);
+        }
+    }
+
+    void writeNumber(float value) {
+        // Range first: converting NAN, infinities or out-of-range floats to int32_t is undefined
+        if (isfinite(value) && value >= -2147483648.0f && value < 2147483648.0f && value == (float)(int32_t)value) {
+            writeInt((int32_t)value);
+            return;
+        }
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put(CBOR_SINGLE);
+        put(bits >> 24);
+        put(bits >> 16);
+        put(bits >> 8);
+        put(bits);
+    }
+
+    void writeText(const char* text) {
+        size_t size = strlen(text);
+        putHead(CBOR_TEXT, size);
+        put((const uint8_t*)text, size);
+    }
+
+    void writeBytes(const uint8_t* data, size_t size) {
+        putHead(CBOR_BYTES, size);
+        put(data, size);
+    }
+
+    // Sends what is still buffered; returns the bytes written so far
+    size_t flush() {
+        if (length > 0) {
+            out.write(buffer, length);
+            total += length;
+            length = 0;
+        }
+        return total;
+    }
+};
+
+// Reads definite-length CBOR from a buffer. Any malformed or unsupported
+// item (indefinite lengths, reserved values) fails the read, after which
+// every further read fails too.
+class CborReader {
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t position = 0;
+    bool failed = false;
+
+    bool fail() {
+        failed = true;
+        return false;
+    }
+
+    bool readHead(uint8_t* major, uint32_t* value) {
+        if (failed || position >= length) return fail();
+        uint8_t initial = data[position++];
+        *major = initial >> 5;
+        uint8_t info = initial & 0x1F;
+
+        if (info < 24) {
+            *value = info;
+            return true;
+        }
+        if (info > 27) return fail(); // Indefinite lengths are not used by this API
+        uint8_t size = 1 << (info - 24);
+        if (position + size > length) return fail();
+        uint64_t argument = 0;
+        for (uint8_t i = 0; i < size; i++) {
+            argument = (argument << 8) | data[position++];
+        }
+        // Only a double float has a 64-bit argument here
+        if (argument > 0xFFFFFFFF && *major != CBOR_SIMPLE) return fail();
+        *value = argument;
+        return true;
+    }
+
+    static float halfToFloat(uint16_t half) {
+        int exponent = (half >> 10) & 0x1F;
+        int mantissa = half & 0x3FF;
+        float value;
+        if (exponent == 0) {
+            value = ldexpf(mantissa, -24);
+        } else if (exponent == 31) {
+            value = mantissa == 0 ? INFINITY : NAN;
+        } else {
+            value = ldexpf(mantissa + 1024, exponent - 25);
+        }
+        return (half & 0x8000) ? -value : value;
+    }
+
+public:
+    CborReader(const uint8_t* buffer, size_t size) : data(buffer), length(size) {}
+
+    bool isFailed() { return failed; }
+    bool atEnd() { return !failed && position == length; }
+
+    // Major type of the next item, or 0xFF when there is none
+    uint8_t peekType() {
+        return failed || position >= length ? 0xFF : data[position] >> 5;
+    }
+
+    bool readMap(uint32_t* pairs) {
+        uint8_t major;
+        return readHead(&major, pairs) && (major == CBOR_MAP || fail());
+    }
+
+    bool readArray(uint32_t* items) {
+        uint8_t major;
+        return readHead(&major, items) && (major == CBOR_ARRAY || fail());
+    }
+
+    bool readUnsigned(uint32_t* value) {
+        uint8_t major;
+        return readHead(&major, value) && (major == CBOR_UNSIGNED || fail());
+    }
+
+    // Integers, half, single and double floats, and booleans as 0 or 1
+    bool readNumber(float* value) {
+        if (failed || position >= length) return fail();
+        uint8_t initial = data[position];
+
+        if (initial == CBOR_FALSE || initial == CBOR_TRUE) {
+            position++;
+            *value = initial == CBOR_TRUE ? 1 : 0;
+            return true;
+        }
+        if (initial == CBOR_HALF || initial == CBOR_SINGLE || initial == CBOR_DOUBLE) {
+            uint8_t size = initial == CBOR_HALF ? 2 : initial == CBOR_SINGLE ? 4 : 8;
+            if (position + 1 + size > length) return fail();
+            const uint8_t* bytes = &data[position + 1];
+            position += 1 + size;
+
+            if (size == 2) {
+                *value = halfToFloat((bytes[0] << 8) | bytes[1]);
+            } else if (size == 4) {
+                uint32_t bits = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+                memcpy(value, &bits, sizeof(bits));
+            } else {
+                uint64_t bits = 0;
+                for (uint8_t i = 0; i < 8; i++) bits = (bits << 8) | bytes[i];
+                double wide;
+                memcpy(&wide, &bits, sizeof(bits));
+                *value = wide;
+            }
+            return true;
+        }
+
+        uint8_t major;
+        uint32_t argument;
+        if (!readHead(&major, &argument)) return false;
+        if (major == CBOR_UNSIGNED) {
+            *value = argument;
+        } else if (major == CBOR_NEGATIVE) {
+            *value = -1.0f - argument;
+        } else {
+            return fail();
+        }
+        return true;
+    }
+
+    // Copies a text string into text, failing if it does not fit
+    bool readText(char* text, size_t size) {
+        uint8_t major;
+        uint32_t textLength;
+        if (!readHead(&major, &textLength)) return false;
+        if (major != CBOR_TEXT || textLength >= size || position + textLength > length) return fail();
+        memcpy(text, &data[position], textLength);
+        text[textLength] = '\0';
+        position += textLength;
+        return true;
+    }
+
+    // Skips one item, including the contents of nested arrays and maps
+    bool skip(uint8_t depth = 0) {
+        if (depth > CBOR_MAX_DEPTH) return fail();
+        uint8_t major;
+        uint32_t argument;
+        if (!readHead(&major, &argument)) return false;
+
+        switch (major) {
+            case CBOR_BYTES:
+            case CBOR_TEXT:
+                if (position + argument > length) return fail();
+                position += argument;
+                return true;
+            case CBOR_ARRAY:
+            case CBOR_MAP: {
+                uint32_t items = major == CBOR_MAP ? argument * 2 : argument;
+                for (uint32_t i = 0; i < items; i++) {
+                    if (!skip(depth + 1)) return false;
+                }
+                return true;
+            }
+            case 6: // Tag, followed by the tagged item
+                return skip(depth + 1);
+            default:
+                return true;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "BACnet_ESP8266.h"
+
+enum ChannelKind : uint8_t {
+    CHANNEL_BINARY,
+    CHANNEL_ANALOG,
+    CHANNEL_MULTISTATE
+};
+
+// How a channel reaches the hardware
+enum ChannelDriver : uint8_t {
+    DRIVER_NONE,
+    DRIVER_DIGITAL, // Pin follows the binary value
+    DRIVER_DIMMER   // Pin fades to the value scaled over min..max while the gate channel is on
+};
+
+enum ACMode : uint8_t {
+    AC_MODE_COOL,
+    AC_MODE_HEAT,
+    AC_MODE_AUTO,
+    AC_MODE_COUNT
+};
+
+enum FanSpeed : uint8_t {
+    FAN_SPEED_AUTO,
+    FAN_SPEED_LOW,
+    FAN_SPEED_MEDIUM,
+    FAN_SPEED_HIGH,
+    FAN_SPEED_COUNT
+};
+
+// State names, indexed by the enums above. Also served as the BACnet
+// State_Text of the matching multi-state object, where state N is enum N - 1.
+static const char* const AC_MODE_TEXT[AC_MODE_COUNT] = {"cool", "heat", "auto"};
+static const char* const FAN_SPEED_TEXT[FAN_SPEED_COUNT] = {"auto", "low", "medium", "high"};
+
+#define NO_PIN -1
+
+// Every point of the board, declared once. Each row generates the channel id,
+// GPIO binding, BACnet object and HTTP JSON field.
+//   X(id, JSON key, BACnet name, kind, BACnet type, BACnet instance, pin, driver, gate, min, max, default, state text)
+#define DEVICE_CHANNELS(X) \
+    X(LIGHT_STATE,      "lightState",      "Light_Switch",     CHANNEL_BINARY,     BACNET_OBJECT_BINARY_OUTPUT,      1001, NO_PIN,    DRIVER_NONE,    CHANNEL_NONE,        0,  1,   0,  nullptr) \
+    X(LIGHT_BRIGHTNESS, "lightBrightness", "Light_Brightness", CHANNEL_ANALOG,     BACNET_OBJECT_ANALOG_OUTPUT,      1002, LIGHT_PIN, DRIVER_DIMMER,  CHANNEL_LIGHT_STATE, 0,  100, 0,  nullptr) \
+    X(TEMPERATURE,      "temperature",     "Room_Temperature", CHANNEL_ANALOG,     BACNET_OBJECT_ANALOG_INPUT,       2001, NO_PIN,    DRIVER_NONE,    CHANNEL_NONE,        16, 30,  22, nullptr) \
+    X(AC_STATE,         "acState",         "AC_State",         CHANNEL_BINARY,     BACNET_OBJECT_BINARY_OUTPUT,      3001, RELAY_PIN, DRIVER_DIGITAL, CHANNEL_NONE,        0,  1,   0,  nullptr) \
+    X(AC_MODE,          "acMode",          "AC_Mode",          CHANNEL_MULTISTATE, BACNET_OBJECT_MULTI_STATE_VALUE,  3002, NO_PIN,    DRIVER_NONE,    CHANNEL_NONE,        0,  AC_MODE_COUNT - 1,   AC_MODE_COOL,     AC_MODE_TEXT) \
+    X(FAN_SPEED,        "fanSpeed",        "Fan_Speed",        CHANNEL_MULTISTATE, BACNET_OBJECT_MULTI_STATE_OUTPUT, 3003, NO_PIN,    DRIVER_NONE,    CHANNEL_NONE,        0,  FAN_SPEED_COUNT - 1, FAN_SPEED_MEDIUM, FAN_SPEED_TEXT)
+
+#define CHANNEL_ID(id, ...) CHANNEL_##id,
+enum ChannelId : uint8_t {
+    DEVICE_CHANNELS(CHANNEL_ID)
+    CHANNEL_COUNT,
+    CHANNEL_NONE = 0xFF
+};
+#undef CHANNEL_ID
+
+static_assert(CHANNEL_COUNT <= 32, "Channel change tracking uses a 32-bit mask");
+
+struct ChannelDefinition {
+    const char* key;
+    const char* objectName;
+    ChannelKind kind;
+    uint8_t objectType;
+    uint32_t objectId;
+    int8_t pin;
+    ChannelDriver driver;
+    ChannelId gate;
+    float minValue;
+    float maxValue;
+    float defaultValue;
+    const char* const* stateText;
+};
+
+#define CHANNEL_DEFINITION(id, key, name, kind, type, instance, pin, driver, gate, minValue, maxValue, defaultValue, stateText) \
+    {key, name, kind, type, instance, pin, driver, gate, minValue, maxValue, defaultValue, stateText},
+static const ChannelDefinition CHANNELS[CHANNEL_COUNT] = {
+    DEVICE_CHANNELS(CHANNEL_DEFINITION)
+};
+#undef CHANNEL_DEFINITION
+
+#define CHANNEL_DIMMER_SLOT(id, key, name, kind, type, instance, pin, driver, ...) + (driver == DRIVER_DIMMER ? 1 : 0)
+const uint8_t DIMMER_COUNT = 0 DEVICE_CHANNELS(CHANNEL_DIMMER_SLOT);
+#undef CHANNEL_DIMMER_SLOT
+
+#endif
@@ -5,28 +5,42 @@
 const char* WIFI_SSID = "Sachithra_4G";
 const char* WIFI_PASSWORD = "Sachi@4G";
 
+// WiFi Connection Management
+const unsigned long WIFI_CONNECT_TIMEOUT = 20000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 4000;
+const unsigned long WIFI_RETRY_MIN_DELAY = 500;
+const unsigned long WIFI_RETRY_MAX_DELAY = 60000;
+#define WIFI_MAX_LINK_CALLBACKS 4
+
 // Server Configuration
 const int WEB_SERVER_PORT = 80;
+#define HTTP_REQUEST_LINE_MAX 128
+#define HTTP_HEADER_LINE_MAX 128
+#define HTTP_BODY_MAX 512
+const unsigned long HTTP_REQUEST_TIMEOUT = 1000; // Longest wait for each further part of a request
+#define BATCH_WRITE_MAX 16 // Channel writes accepted by one POST /api/batch
+#define LONG_POLL_MAX_CLIENTS 2     // Status requests held open at once; more get 503 Service Unavailable
+const unsigned long LONG_POLL_MAX_WAIT = 30000;
+#define LONG_POLL_RETRY_AFTER 5     // Seconds a turned-away long-poll is told to wait
+#define CBOR_WRITE_BUFFER 64 // Bytes per TCP write when streaming a CBOR response
+#define CBOR_MAX_DEPTH 4     // Nesting skipped in request bodies before the body is rejected
+
+// Application code includes StringGuard.h; with this defined any Arduino
+// String use there is a compile error
+#define STRING_FREE_BUILD
 
 // BACnet Configuration
 const uint32_t BACNET_DEVICE_INSTANCE = 12345;
 
-// BACnet Object IDs
-const uint32_t LIGHT_OBJECT_ID = 1001;
-const uint32_t LIGHT_BRIGHTNESS_OBJECT_ID = 1002;
-const uint32_t TEMPERATURE_OBJECT_ID = 2001;
-const uint32_t AC_STATE_OBJECT_ID = 3001;
-const uint32_t AC_MODE_OBJECT_ID = 3002;
-const uint32_t FAN_SPEED_OBJECT_ID = 3003;
-
 // GPIO Pin Configuration
 const int LIGHT_PIN = 5;   // D1 on NodeMCU
 const int RELAY_PIN = 4;   // D2 on NodeMCU
 
-// Device Default Values
-const float DEFAULT_TEMPERATURE = 22.0;
-const float DEFAULT_LIGHT_BRIGHTNESS = 0.0;
-const String DEFAULT_AC_MODE = "cool";
-const int DEFAULT_FAN_SPEED = 2;
+// Light Dimming
+const unsigned long LIGHT_FADE_TIME = 800;
+#define FADE_STEP_INTERVAL 10
+#define FADE_PWM_RANGE 1023
+
+// Channel objects, pins and defaults are declared in Channels.h
 
 #endif
\ No newline at end of file
@@ -3,88 +3,214 @@
 
 #include <Arduino.h>
 #include "Config.h"
+#include "Channels.h"
+#include "FadeEngine.h"
 
-struct DeviceState {
-    bool lightState = false;
-    float lightBrightness = DEFAULT_LIGHT_BRIGHTNESS;
-    float temperature = DEFAULT_TEMPERATURE;
-    bool acState = false;
-    String acMode = DEFAULT_AC_MODE;
-    int fanSpeed = DEFAULT_FAN_SPEED;
+// One entry of a batch; multi-state values are state indexes
+struct ChannelWrite {
+    ChannelId id;
+    float value;
 };
 
 class DeviceManager {
 private:
-    DeviceState state;
+    // Channel state as parallel arrays indexed by ChannelId
+    float values[CHANNEL_COUNT];
+    uint8_t dimmerSlot[CHANNEL_COUNT];
+    ChannelId gatedChannel[CHANNEL_COUNT];
+    uint32_t changedMask = 0;
+    // Bumped once per state change; each channel keeps the version that last changed it
+    uint32_t version = 1;
+    uint32_t channelVersion[CHANNEL_COUNT];
+    FadeEngine dimmers[DIMMER_COUNT > 0 ? DIMMER_COUNT : 1];
 
 public:
+    // Channel state only: the instance is global, so the pins are left to begin()
     DeviceManager() {
-        // Initialize GPIO pins
-        pinMode(LIGHT_PIN, OUTPUT);
-        pinMode(RELAY_PIN, OUTPUT);
-        digitalWrite(LIGHT_PIN, LOW);
-        digitalWrite(RELAY_PIN, LOW);
+        uint8_t dimmerCount = 0;
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            gatedChannel[i] = CHANNEL_NONE;
+        }
+        
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            const ChannelDefinition& channel = CHANNELS[i];
+            values[i] = channel.defaultValue;
+            channelVersion[i] = version;
+            dimmerSlot[i] = 0xFF;
+            if (channel.gate != CHANNEL_NONE) {
+                gatedChannel[channel.gate] = (ChannelId)i;
+            }
+            if (channel.pin != NO_PIN && channel.driver == DRIVER_DIMMER) {
+                dimmerSlot[i] = dimmerCount++;
+            }
+        }
+        changedMask = (CHANNEL_COUNT == 32) ? 0xFFFFFFFF : (1UL << CHANNEL_COUNT) - 1;
     }
     
-    // Light control methods
-    void setLightState(bool state) {
-        this->state.lightState = state;
-        updatePhysicalDevices();
-        Serial.println(" Light " + String(state ? "turned ON" : "turned OFF"));
+    // Initializes the GPIO pins from the channel table and drives the default values
+    void begin() {
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            const ChannelDefinition& channel = CHANNELS[i];
+            if (channel.pin == NO_PIN) continue;
+            
+            pinMode(channel.pin, OUTPUT);
+            if (channel.driver == DRIVER_DIMMER) {
+                dimmers[dimmerSlot[i]].begin(channel.pin, 0);
+            }
+            updatePhysicalDevice((ChannelId)i);
+        }
     }
     
-    void setLightBrightness(float brightness) {
-        this->state.lightBrightness = brightness;
-        updatePhysicalDevices();
-        Serial.println(" Brightness set to: " + String(brightness) + "%");
+    // Returns false if the value is out of range for the channel
+    bool setValue(ChannelId id, float value) {
+        if (!normalizeValue(id, &value)) return false;
+        const ChannelDefinition& channel = CHANNELS[id];
+        
+        if (values[id] == value) return true;
+        values[id] = value;
+        changedMask |= 1UL << id;
+        channelVersion[id] = ++version;
+        updatePhysicalDevice(id);
+        if (gatedChannel[id] != CHANNEL_NONE) {
+            updatePhysicalDevice(gatedChannel[id]);
+        }
+        
+        if (channel.kind == CHANNEL_MULTISTATE) {
+            Serial.printf(" %s set to: %s\n", channel.key, channel.stateText[(int)value]);
+        } else {
+            Serial.printf(" %s set to: %.2f\n", channel.key, value);
+        }
+        return true;
     }
     
-    // AC control methods
-    void setACState(bool state) {
-        this->state.acState = state;
-        updatePhysicalDevices();
-        Serial.println(" AC " + String(state ? "turned ON" : "turned OFF"));
+    // Multi-state channels also accept their state name
+    bool setState(ChannelId id, const char* stateName) {
+        int state = findState(id, stateName);
+        return state >= 0 && setValue(id, state);
+    }
+    
+    // Applies the writes in order as one change: every write is validated
+    // before any is applied, and each affected output is driven once. On an
+    // invalid write nothing changes and failedIndex is set to its position.
+    bool applyBatch(const ChannelWrite* writes, uint8_t count, uint8_t* failedIndex) {
+        float staged[CHANNEL_COUNT];
+        memcpy(staged, values, sizeof(staged));
+        for (uint8_t i = 0; i < count; i++) {
+            float value = writes[i].value;
+            if (!normalizeValue(writes[i].id, &value)) {
+                *failedIndex = i;
+                return false;
+            }
+            staged[writes[i].id] = value;
+        }
+        
+        uint32_t changed = 0;
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (staged[i] != values[i]) changed |= 1UL << i;
+        }
+        if (changed == 0) return true;
+        
+        memcpy(values, staged, sizeof(values));
+        changedMask |= changed;
+        version++;
+        uint32_t outputs = changed;
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if ((changed & (1UL << i)) && gatedChannel[i] != CHANNEL_NONE) {
+                outputs |= 1UL << gatedChannel[i];
+            }
+        }
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (changed & (1UL << i)) channelVersion[i] = version;
+            if (outputs & (1UL << i)) updatePhysicalDevice((ChannelId)i);
+        }
+        
+        Serial.printf(" Batch applied: %u writes, %u channels changed\n", count, __builtin_popcount(changed));
+        return true;
     }
     
-    void setTemperature(float temperature) {
-        this->state.temperature = temperature;
-        Serial.println(" Temperature set to: " + String(temperature) + "°C");
+    // State index of a multi-state channel's state name, or -1
+    int findState(ChannelId id, const char* stateName) {
+        if (id >= CHANNEL_COUNT || CHANNELS[id].kind != CHANNEL_MULTISTATE) return -1;
+        const ChannelDefinition& channel = CHANNELS[id];
+        for (int state = 0; state <= channel.maxValue; state++) {
+            if (strcmp(channel.stateText[state], stateName) == 0) return state;
+        }
+        return -1;
     }
     
-    void setACMode(const String& mode) {
-        this->state.acMode = mode;
-        Serial.println(" AC mode set to: " + mode);
+    // BACnet numbers multi-state values from 1, the channel enums from 0
+    float getBACnetValue(ChannelId id) {
+        return CHANNELS[id].kind == CHANNEL_MULTISTATE ? values[id] + 1 : values[id];
     }
     
-    void setFanSpeed(int speed) {
-        this->state.fanSpeed = speed;
-        Serial.println(" Fan speed set to: " + String(speed));
+    bool setBACnetValue(ChannelId id, float value) {
+        return setValue(id, CHANNELS[id].kind == CHANNEL_MULTISTATE ? value - 1 : value);
     }
     
     // Getters
-    DeviceState getState() {
-        return state;
+    float getValue(ChannelId id) { return values[id]; }
+    bool getBool(ChannelId id) { return values[id] != 0; }
+    uint8_t getState(ChannelId id) { return (uint8_t)values[id]; }
+    
+    const char* getStateText(ChannelId id) {
+        const ChannelDefinition& channel = CHANNELS[id];
+        return channel.stateText != nullptr ? channel.stateText[(int)values[id]] : "";
     }
     
-    bool getLightState() { return state.lightState; }
-    float getLightBrightness() { return state.lightBrightness; }
-    float getTemperature() { return state.temperature; }
-    bool getACState() { return state.acState; }
-    String getACMode() { return state.acMode; }
-    int getFanSpeed() { return state.fanSpeed; }
+    // State version, starting at 1; a batch is one version
+    uint32_t getVersion() { return version; }
+    
+    bool changedSince(ChannelId id, uint32_t since) { return channelVersion[id] > since; }
+    
+    // Channels changed since the last call, one bit per ChannelId
+    uint32_t takeChanges() {
+        uint32_t changes = changedMask;
+        changedMask = 0;
+        return changes;
+    }
+    
+    static ChannelId findChannel(const char* key) {
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (strcmp(CHANNELS[i].key, key) == 0) return (ChannelId)i;
+        }
+        return CHANNEL_NONE;
+    }
+    
+    static ChannelId findChannelByObject(uint32_t objectId) {
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (CHANNELS[i].objectId == objectId) return (ChannelId)i;
+        }
+        return CHANNEL_NONE;
+    }
 
 private:
-    void updatePhysicalDevices() {
-        // Control LED based on light state and brightness
-        if (state.lightState && state.lightBrightness > 0) {
-            analogWrite(LIGHT_PIN, map(state.lightBrightness, 0, 100, 0, 1023));
+    // Checks a value against the channel, snapping binaries to 0/1 and clamping analogs
+    bool normalizeValue(ChannelId id, float* value) {
+        // NAN and infinities would pass the range checks below unchanged
+        if (id >= CHANNEL_COUNT || !isfinite(*value)) return false;
+        const ChannelDefinition& channel = CHANNELS[id];
+        
+        if (channel.kind == CHANNEL_BINARY) {
+            *value = *value != 0 ? 1.0 : 0.0;
+        } else if (channel.kind == CHANNEL_MULTISTATE) {
+            if (*value != (int)*value || *value < channel.minValue || *value > channel.maxValue) return false;
         } else {
-            digitalWrite(LIGHT_PIN, LOW);
+            *value = constrain(*value, channel.minValue, channel.maxValue);
+        }
+        return true;
+    }
+    
+    void updatePhysicalDevice(ChannelId id) {
+        const ChannelDefinition& channel = CHANNELS[id];
+        if (channel.driver == DRIVER_DIGITAL) {
+            digitalWrite(channel.pin, values[id] != 0 ? HIGH : LOW);
+        } else if (channel.driver == DRIVER_DIMMER) {
+            // Ramp towards the new level, or to dark while the gate channel is off
+            bool enabled = channel.gate == CHANNEL_NONE || values[channel.gate] != 0;
+            float level = enabled ? (values[id] - channel.minValue) / (channel.maxValue - channel.minValue) : 0.0f;
+            dimmers[dimmerSlot[id]].fadeTo(level * 255, LIGHT_FADE_TIME);
         }
-        
-        // Control relay based on AC state
-        digitalWrite(RELAY_PIN, state.acState ? HIGH : LOW);
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,18 @@
+#ifndef STRING_GUARD_H
+#define STRING_GUARD_H
+
+// Included after the core and library headers, before any of the
+// application's own code. With STRING_FREE_BUILD defined in Config.h any
+// use of the Arduino String class after this point fails to compile, so
+// loop, packet and HTTP paths cannot fragment the heap with temporaries.
+
+#include "Config.h"
+
+#define IP_FORMAT "%u.%u.%u.%u"
+#define IP_ARGS(ip) (ip)[0], (ip)[1], (ip)[2], (ip)[3]
+
+#ifdef STRING_FREE_BUILD
+#pragma GCC poison String
+#endif
+
+#endif
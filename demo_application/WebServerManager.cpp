@@ -1,181 +1,8 @@
 #include "WebServerManager.h"
+#include "StringGuard.h"
 
-void WebServerManager::begin() {
-    server.begin();
-    Serial.println(" HTTP server started on port " + String(WEB_SERVER_PORT));
-}
-
-void WebServerManager::handleClient() {
-    WiFiClient client = server.available();
-    if (!client) return;
-    
-    // Wait for client to send data
-    unsigned long timeout = millis() + 5000;
-    while (!client.available() && millis() < timeout) {
-        delay(10);
-    }
-    
-    if (!client.available()) {
-        client.stop();
-        return;
-    }
-    
-    String request = client.readStringUntil('\r');
-    client.flush();
-    
-    Serial.println("HTTP Request: " + request);
-    
-    // Read request body for POST requests
-    String body;
-    if (request.startsWith("POST")) {
-        while (client.available()) {
-            body += client.readString();
-        }
-    }
-    
-    // Route handling
-    if (request.indexOf("GET / ") != -1 || request.indexOf("GET /index") != -1) {
-        sendMainPage(client);
-    }
-    else if (request.indexOf("GET /api/status") != -1) {
-        sendJSONStatus(client);
-    }
-    else if (request.indexOf("POST /api/light") != -1) {
-        handleLightControl(client, body);
-    }
-    else if (request.indexOf("POST /api/ac") != -1) {
-        handleACControl(client, body);
-    }
-    else if (request.indexOf("POST /api/temperature") != -1) {
-        handleTemperatureControl(client, body);
-    }
-    else {
-        // Send 404 for unknown routes
-        client.println("HTTP/1.1 404 Not Found");
-        client.println("Content-Type: text/plain");
-        client.println("Connection: close");
-        client.println();
-        client.println("404 - Page Not Found");
-    }
-    
-    delay(10);
-    client.stop();
-}
-
-void WebServerManager::sendMainPage(WiFiClient& client) {
-    String html = getHTMLContent();
-    
-    client.println("HTTP/1.1 200 OK");
-    client.println("Content-Type: text/html");
-    client.println("Connection: close");
-    client.println();
-    client.println(html);
-}
-
-void WebServerManager::sendJSONStatus(WiFiClient& client) {
-    DeviceState state = deviceManager->getState();
-    StaticJsonDocument<512> doc;
-    
-    doc["lightState"] = state.lightState;
-    doc["lightBrightness"] = state.lightBrightness;
-    doc["temperature"] = state.temperature;
-    doc["acState"] = state.acState;
-    doc["acMode"] = state.acMode;
-    doc["fanSpeed"] = state.fanSpeed;
-    doc["ipAddress"] = WiFi.localIP().toString();
-    doc["bacnetDeviceId"] = bacnetController->getDeviceInstance();
-    doc["uptime"] = millis() / 1000;
-    
-    String response;
-    serializeJson(doc, response);
-    
-    client.println("HTTP/1.1 200 OK");
-    client.println("Content-Type: application/json");
-    client.println("Connection: close");
-    client.println();
-    client.println(response);
-}
-
-void WebServerManager::handleLightControl(WiFiClient& client, const String& body) {
-    StaticJsonDocument<200> doc;
-    DeserializationError error = deserializeJson(doc, body);
-    
-    if (!error) {
-        if (doc.containsKey("state")) {
-            deviceManager->setLightState(doc["state"]);
-        }
-        if (doc.containsKey("brightness")) {
-            deviceManager->setLightBrightness(doc["brightness"]);
-        }
-        
-        client.println("HTTP/1.1 200 OK");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"success\",\"message\":\"Light control updated\"}");
-    } else {
-        client.println("HTTP/1.1 400 Bad Request");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
-    }
-}
-
-void WebServerManager::handleACControl(WiFiClient& client, const String& body) {
-    StaticJsonDocument<200> doc;
-    DeserializationError error = deserializeJson(doc, body);
-    
-    if (!error) {
-        if (doc.containsKey("state")) {
-            deviceManager->setACState(doc["state"]);
-        }
-        if (doc.containsKey("mode")) {
-            deviceManager->setACMode(doc["mode"].as<String>());
-        }
-        if (doc.containsKey("fanSpeed")) {
-            deviceManager->setFanSpeed(doc["fanSpeed"]);
-        }
-        
-        client.println("HTTP/1.1 200 OK");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"success\",\"message\":\"AC control updated\"}");
-    } else {
-        client.println("HTTP/1.1 400 Bad Request");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
-    }
-}
-
-void WebServerManager::handleTemperatureControl(WiFiClient& client, const String& body) {
-    StaticJsonDocument<200> doc;
-    DeserializationError error = deserializeJson(doc, body);
-    
-    if (!error) {
-        if (doc.containsKey("temperature")) {
-            deviceManager->setTemperature(doc["temperature"]);
-        }
-        
-        client.println("HTTP/1.1 200 OK");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"success\",\"message\":\"Temperature updated\"}");
-    } else {
-        client.println("HTTP/1.1 400 Bad Request");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.println();
-        client.println("{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
-    }
-}
-
-String WebServerManager::getHTMLContent() {
-    return R"=====(
+// Served straight from flash so the page never occupies heap
+static const char MAIN_PAGE[] PROGMEM = R"=====(
 <!DOCTYPE html>
 <html>
 <head>
@@ -262,10 +89,10 @@ String WebServerManager::getHTMLContent() {
             </div>
             <div class="control-group">
                 <label class="control-label">Fan Speed:</label>
-                <button id="btnFanLow" onclick="setFanSpeed(1)">Low</button>
-                <button id="btnFanMed" onclick="setFanSpeed(2)" class="active">Medium</button>
-                <button id="btnFanHigh" onclick="setFanSpeed(3)">High</button>
-                <button id="btnFanAuto" onclick="setFanSpeed(0)">Auto</button>
+                <button id="btnFanLow" onclick="setFanSpeed('low')">Low</button>
+                <button id="btnFanMedium" onclick="setFanSpeed('medium')" class="active">Medium</button>
+                <button id="btnFanHigh" onclick="setFanSpeed('high')">High</button>
+                <button id="btnFanAuto" onclick="setFanSpeed('auto')">Auto</button>
             </div>
         </div>
         
@@ -279,13 +106,31 @@ String WebServerManager::getHTMLContent() {
 
     <script>
         // JavaScript from previous implementation
+        // Long-polls for changes: each reply carries only the fields that moved since our version
+        let data = {};
+        let version = 0;
+        let boot = 0;
+        let retryDelay = 1000;
         function updateStatus() {
-            fetch('/api/status')
+            fetch(`/api/status?since=${version}&boot=${boot}&wait=25`)
                 .then(response => {
+                    if (response.status === 503) {
+                        // Every long-poll slot is taken; come back when the device asks
+                        const retryAfter = parseInt(response.headers.get('Retry-After')) || 5;
+                        setTimeout(updateStatus, retryAfter * 1000);
+                        return null;
+                    }
                     if (!response.ok) throw new Error('Network response was not ok');
                     return response.json();
                 })
-                .then(data => {
+                .then(delta => {
+                    if (delta === null) return;
+                    // A new boot sends the full status, which replaces what we had
+                    if (delta.bootId !== boot) data = {};
+                    Object.assign(data, delta);
+                    version = delta.version;
+                    boot = delta.bootId;
+                    retryDelay = 1000;
                     document.getElementById('lightStatus').textContent = 
                         ` Light: ${data.lightState ? 'ON' : 'OFF'} | Brightness: ${data.lightBrightness}%`;
                     document.getElementById('acStatus').textContent = 
@@ -293,10 +138,13 @@ String WebServerManager::getHTMLContent() {
                     document.getElementById('systemInfo').innerHTML = 
                         ` IP Address: <strong>${data.ipAddress}</strong><br> BACnet Device ID: <strong>${data.bacnetDeviceId}</strong><br>⏰ System Uptime: <strong>${formatUptime(data.uptime)}</strong>`;
                     updateUIControls(data);
+                    updateStatus();
                 })
                 .catch(error => {
                     console.error('Error fetching status:', error);
                     document.getElementById('systemInfo').innerHTML = ' Error connecting to device. Please check if ESP8266 is running.';
+                    setTimeout(updateStatus, retryDelay);
+                    retryDelay = Math.min(retryDelay * 2, 30000);
                 });
         }
         
@@ -321,9 +169,7 @@ String WebServerManager::getHTMLContent() {
         }
         
         function getFanSpeedText(speed) {
-            switch(parseInt(speed)) {
-                case 0: return 'Auto'; case 1: return 'Low'; case 2: return 'Med'; case 3: return 'High'; default: return 'Unknown';
-            }
+            return speed ? speed.charAt(0).toUpperCase() + speed.slice(1) : 'Unknown';
         }
         
         function formatUptime(seconds) {
@@ -333,26 +179,528 @@ String WebServerManager::getHTMLContent() {
             return `${hours.toString().padStart(2, '0')}:${minutes.toString().padStart(2, '0')}:${secs.toString().padStart(2, '0')}`;
         }
         
-        function toggleLight() { sendCommand('/api/light', {state: document.getElementById('lightSwitch').checked}); }
+        function toggleLight() { sendCommand('/api/channels', {lightState: document.getElementById('lightSwitch').checked}); }
         function updateBrightnessDisplay(value) { document.getElementById('brightnessValue').textContent = value + '%'; }
-        function setBrightness(value) { sendCommand('/api/light', {brightness: parseInt(value)}); }
-        function toggleAC() { sendCommand('/api/ac', {state: document.getElementById('acSwitch').checked}); }
+        function setBrightness(value) { sendCommand('/api/channels', {lightBrightness: parseInt(value)}); }
+        function toggleAC() { sendCommand('/api/channels', {acState: document.getElementById('acSwitch').checked}); }
         function updateTempDisplay(value) { document.getElementById('tempValue').textContent = value + '°C'; }
-        function setTemperature(value) { sendCommand('/api/temperature', {temperature: parseFloat(value)}); }
-        function setACMode(mode) { sendCommand('/api/ac', {mode: mode}); }
-        function setFanSpeed(speed) { sendCommand('/api/ac', {fanSpeed: speed}); }
+        function setTemperature(value) { sendCommand('/api/channels', {temperature: parseFloat(value)}); }
+        function setACMode(mode) { sendCommand('/api/channels', {acMode: mode}); }
+        function setFanSpeed(speed) { sendCommand('/api/channels', {fanSpeed: speed}); }
         
         function sendCommand(endpoint, data) {
             fetch(endpoint, { method: 'POST', headers: {'Content-Type': 'application/json'}, body: JSON.stringify(data) })
             .then(response => { if (!response.ok) throw new Error('Command failed'); return response.json(); })
-            .then(result => { console.log('Command successful:', result); updateStatus(); })
+            .then(result => { console.log('Command successful:', result); })
             .catch(error => { console.error('Error sending command:', error); alert('Error sending command. Please check connection.'); });
         }
         
-        setInterval(updateStatus, 3000);
         updateStatus();
     </script>
 </body>
 </html>
 )=====";
-}
\ No newline at end of file
+
+static bool isRoute(const char* request, const char* route) {
+    return strncmp(request, route, strlen(route)) == 0;
+}
+
+// Compares the media type of a header value ("type/subtype; parameters")
+// with type, ignoring case and parameters
+static bool isMediaType(const char* start, const char* end, const char* type) {
+    while (start < end && *start == ' ') start++;
+    const char* typeEnd = start;
+    while (typeEnd < end && *typeEnd != ';' && *typeEnd != ' ') typeEnd++;
+    size_t length = strlen(type);
+    return (size_t)(typeEnd - start) == length && strncasecmp(start, type, length) == 0;
+}
+
+// Picks the response encoding from an Accept value. Each API type takes the
+// q-value of the most specific range that matches it (RFC 9110 12.5.1); CBOR
+// wins when it is preferred, or equally preferred but named more exactly.
+static ApiFormat negotiateFormat(const char* accept) {
+    static const char* const cborRanges[] = {"application/cbor", "application/*", "*/*"};
+    static const char* const jsonRanges[] = {"application/json", "application/*", "*/*"};
+    float cborQuality = 0, jsonQuality = 0;
+    uint8_t cborMatch = 0, jsonMatch = 0; // 3 exact, 2 type/*, 1 */*, 0 none
+    
+    while (*accept) {
+        const char* end = strchr(accept, ',');
+        if (end == nullptr) end = accept + strlen(accept);
+        
+        float quality = 1;
+        for (const char* parameter = (const char*)memchr(accept, ';', end - accept); parameter != nullptr;
+             parameter = (const char*)memchr(parameter + 1, ';', end - parameter - 1)) {
+            const char* name = parameter + 1;
+            while (name < end && *name == ' ') name++;
+            if (end - name > 2 && (name[0] == 'q' || name[0] == 'Q') && name[1] == '=') quality = strtod(name + 2, nullptr);
+        }
+        for (uint8_t i = 0; i < 3; i++) {
+            if (3 - i > cborMatch && isMediaType(accept, end, cborRanges[i])) {
+                cborMatch = 3 - i;
+                cborQuality = quality;
+            }
+            if (3 - i > jsonMatch && isMediaType(accept, end, jsonRanges[i])) {
+                jsonMatch = 3 - i;
+                jsonQuality = quality;
+            }
+        }
+        accept = *end ? end + 1 : end;
+    }
+    
+    bool preferCBOR = cborQuality > jsonQuality || (cborQuality == jsonQuality && cborMatch > jsonMatch);
+    return cborQuality > 0 && preferCBOR ? API_FORMAT_CBOR : API_FORMAT_JSON;
+}
+
+// Reads a numeric query parameter from the request line
+static bool getQueryNumber(const char* request, const char* name, uint32_t* value) {
+    const char* query = strchr(request, '?');
+    const char* end = strchr(request + 4, ' ');
+    size_t nameLength = strlen(name);
+    for (const char* p = query; p != nullptr && (end == nullptr || p < end); p = strchr(p + 1, '&')) {
+        if (strncmp(p + 1, name, nameLength) == 0 && p[1 + nameLength] == '=') {
+            char* numberEnd;
+            *value = strtoul(p + 2 + nameLength, &numberEnd, 10);
+            return numberEnd != p + 2 + nameLength;
+        }
+    }
+    return false;
+}
+
+void WebServerManager::begin() {
+    // Never 0, which is what a client sends before its first status
+    bootId = ESP.random() | 1;
+    server.begin();
+    Serial.printf(" HTTP server started on port %d\n", WEB_SERVER_PORT);
+}
+
+void WebServerManager::handleClient() {
+    servicePendingPolls();
+    
+    WiFiClient client = server.available();
+    if (!client) return;
+    
+    // Wait for client to send data
+    unsigned long timeout = millis() + 5000;
+    while (!client.available() && millis() < timeout) {
+        delay(10);
+    }
+    
+    if (!client.available()) {
+        client.stop();
+        return;
+    }
+    
+    // Later parts of the request may arrive in further TCP segments
+    client.setTimeout(HTTP_REQUEST_TIMEOUT);
+    char request[HTTP_REQUEST_LINE_MAX];
+    readLine(client, request, sizeof(request));
+    
+    Serial.printf("HTTP Request: %s\n", request);
+    RequestFormat format = readRequestHeaders(client);
+    
+    // Route handling
+    if (isRoute(request, "GET / ") || isRoute(request, "GET /index")) {
+        sendMainPage(client);
+    }
+    else if (isRoute(request, "GET /api/status")) {
+        // ?since=<version>&boot=<bootId> asks for a delta; adding &wait=<seconds>
+        // holds it until there is one
+        uint32_t since = 0;
+        uint32_t boot = 0;
+        uint32_t wait = 0;
+        getQueryNumber(request, "since", &since);
+        getQueryNumber(request, "boot", &boot);
+        getQueryNumber(request, "wait", &wait);
+        if (boot != bootId) since = 0;
+        unsigned long waitTime = wait >= LONG_POLL_MAX_WAIT / 1000 ? LONG_POLL_MAX_WAIT : wait * 1000UL;
+        if (since != 0 && since == deviceManager->getVersion() && wait > 0) {
+            if (holdStatusRequest(client, format.accept, since, waitTime)) return;
+            sendPollBusy(client);
+        } else {
+            sendStatus(client, format.accept, since);
+        }
+    }
+    else if (isRoute(request, "POST /api/channels")) {
+        char body[HTTP_BODY_MAX];
+        size_t bodyLength = readRequestBody(client, body, sizeof(body), format.contentLength);
+        handleChannelControl(client, body, bodyLength, format);
+    }
+    else if (isRoute(request, "POST /api/batch")) {
+        char body[HTTP_BODY_MAX];
+        size_t bodyLength = readRequestBody(client, body, sizeof(body), format.contentLength);
+        handleBatch(client, body, bodyLength, format);
+    }
+    else {
+        // Send 404 for unknown routes
+        client.println("HTTP/1.1 404 Not Found");
+        client.println("Content-Type: text/plain");
+        client.println("Connection: close");
+        client.println();
+        client.println("404 - Page Not Found");
+    }
+    
+    delay(10);
+    client.stop();
+}
+
+void WebServerManager::sendMainPage(WiFiClient& client) {
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/html");
+    client.println("Connection: close");
+    client.println();
+    client.write_P(MAIN_PAGE, strlen_P(MAIN_PAGE));
+}
+
+// A since of 0, or one ahead of the device (it restarted), gets the full status
+void WebServerManager::sendStatus(WiFiClient& client, ApiFormat format, uint32_t since) {
+    if (since > deviceManager->getVersion()) since = 0;
+    if (format == API_FORMAT_CBOR) {
+        sendCBORStatus(client, since);
+    } else {
+        sendJSONStatus(client, since);
+    }
+}
+
+void WebServerManager::sendJSONStatus(WiFiClient& client, uint32_t since) {
+    StaticJsonDocument<1024> doc;
+    
+    // One field per channel; multi-state channels report their state name
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        ChannelId id = (ChannelId)i;
+        const ChannelDefinition& channel = CHANNELS[i];
+        if (!deviceManager->changedSince(id, since)) continue;
+        if (channel.kind == CHANNEL_BINARY) {
+            doc[channel.key] = deviceManager->getBool(id);
+        } else if (channel.kind == CHANNEL_MULTISTATE) {
+            doc[channel.key] = deviceManager->getStateText(id);
+        } else {
+            doc[channel.key] = deviceManager->getValue(id);
+        }
+    }
+    if (since == 0) {
+        char ipAddress[16];
+        IPAddress localIP = WiFi.localIP();
+        snprintf(ipAddress, sizeof(ipAddress), IP_FORMAT, IP_ARGS(localIP));
+        doc[STATUS_FIELD_KEYS[STATUS_FIELD_IP_ADDRESS - STATUS_FIELD_FIRST]] = ipAddress;
+    }
+    for (uint8_t field = STATUS_FIELD_IP_ADDRESS + 1; field < STATUS_FIELD_END; field++) {
+        if (since != 0 && !isDeltaField(field)) continue;
+        doc[STATUS_FIELD_KEYS[field - STATUS_FIELD_FIRST]] = getStatusField((StatusField)field);
+    }
+    
+    sendResponseHeaders(client, "200 OK", "application/json");
+    serializeJson(doc, client);
+    client.println();
+}
+
+// Same fields as the JSON status under integer keys, streamed without a document
+void WebServerManager::sendCBORStatus(WiFiClient& client, uint32_t since) {
+    sendResponseHeaders(client, "200 OK", "application/cbor");
+    
+    uint8_t channelCount = 0;
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        if (deviceManager->changedSince((ChannelId)i, since)) channelCount++;
+    }
+    
+    CborWriter writer(client);
+    writer.beginMap(channelCount + (since == 0 ? STATUS_FIELD_COUNT : STATUS_DELTA_FIELD_COUNT));
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        ChannelId id = (ChannelId)i;
+        if (!deviceManager->changedSince(id, since)) continue;
+        writer.writeUnsigned(i);
+        if (CHANNELS[i].kind == CHANNEL_BINARY) {
+            writer.writeBool(deviceManager->getBool(id));
+        } else if (CHANNELS[i].kind == CHANNEL_MULTISTATE) {
+            writer.writeUnsigned((uint32_t)deviceManager->getValue(id));
+        } else {
+            writer.writeNumber(deviceManager->getValue(id));
+        }
+    }
+    if (since == 0) {
+        IPAddress localIP = WiFi.localIP();
+        uint8_t ipAddress[4] = {IP_ARGS(localIP)};
+        writer.writeUnsigned(STATUS_FIELD_IP_ADDRESS);
+        writer.writeBytes(ipAddress, sizeof(ipAddress));
+    }
+    for (uint8_t field = STATUS_FIELD_IP_ADDRESS + 1; field < STATUS_FIELD_END; field++) {
+        if (since != 0 && !isDeltaField(field)) continue;
+        writer.writeUnsigned(field);
+        writer.writeUnsigned(getStatusField((StatusField)field));
+    }
+    writer.flush();
+}
+
+// Parks the connection instead of answering; false when every slot is taken
+bool WebServerManager::holdStatusRequest(WiFiClient& client, ApiFormat format, uint32_t since, unsigned long wait) {
+    for (uint8_t i = 0; i < LONG_POLL_MAX_CLIENTS; i++) {
+        if (polls[i].active) continue;
+        polls[i] = {true, client, since, format, millis(), wait};
+        return true;
+    }
+    return false;
+}
+
+// Every long-poll slot is taken: the client is asked to come back rather
+// than sent an empty delta it would re-request straight away
+void WebServerManager::sendPollBusy(WiFiClient& client) {
+    client.println("HTTP/1.1 503 Service Unavailable");
+    client.printf("Retry-After: %u\r\n", LONG_POLL_RETRY_AFTER);
+    client.println("Connection: close");
+    client.println();
+}
+
+// Answers held requests once the state moves on or their wait runs out.
+// A timed-out request gets an empty delta with the unchanged version.
+void WebServerManager::servicePendingPolls() {
+    for (uint8_t i = 0; i < LONG_POLL_MAX_CLIENTS; i++) {
+        PendingPoll& poll = polls[i];
+        if (!poll.active) continue;
+        
+        if (!poll.client.connected()) {
+            poll.active = false;
+            poll.client = WiFiClient();
+            continue;
+        }
+        if (deviceManager->getVersion() == poll.since && millis() - poll.started < poll.wait) continue;
+        
+        sendStatus(poll.client, poll.format, poll.since);
+        poll.client.stop();
+        poll.client = WiFiClient();
+        poll.active = false;
+    }
+}
+
+// Numeric status fields, shared by both encodings
+uint32_t WebServerManager::getStatusField(StatusField field) {
+    switch (field) {
+        case STATUS_FIELD_BACNET_DEVICE_ID:
+            return bacnetController->getDeviceInstance();
+        case STATUS_FIELD_BACNET_REJECTED:
+            return bacnetController->getRejectedFrames();
+        case STATUS_FIELD_UPTIME:
+            return (uint32_t)(micros64() / 1000000); // millis() wraps after 49 days
+        case STATUS_FIELD_FREE_HEAP:
+            return ESP.getFreeHeap();
+        case STATUS_FIELD_LARGEST_FREE_BLOCK:
+            return ESP.getMaxFreeBlockSize();
+        case STATUS_FIELD_HEAP_FRAGMENTATION:
+            return ESP.getHeapFragmentation();
+        case STATUS_FIELD_VERSION:
+            return deviceManager->getVersion();
+        case STATUS_FIELD_BOOT_ID:
+            return bootId;
+        default:
+            return 0;
+    }
+}
+
+// POST /api/channels with {"<channel key>": value, ...} as JSON, or the same
+// map under integer keys as CBOR; multi-state values may be names or indexes.
+// The whole body is read and checked first, then applied as one batch, so an
+// invalid value leaves every channel unchanged.
+void WebServerManager::handleChannelControl(WiFiClient& client, const char* body, size_t length, const RequestFormat& format) {
+    ChannelWrite writes[BATCH_WRITE_MAX];
+    uint8_t count = 0;
+    bool parsed = format.contentType == API_FORMAT_CBOR ? parseCBORChannels((const uint8_t*)body, length, writes, &count)
+                                                        : parseJSONChannels(body, length, writes, &count);
+    uint8_t failedIndex;
+    bool valid = parsed && deviceManager->applyBatch(writes, count, &failedIndex);
+    
+    // CBOR clients get the status code alone
+    if (format.accept == API_FORMAT_CBOR) {
+        sendResponseHeaders(client, valid ? "204 No Content" : "400 Bad Request", nullptr);
+    } else if (valid) {
+        sendResponseHeaders(client, "200 OK", "application/json");
+        client.println("{\"status\":\"success\",\"message\":\"Channels updated\"}");
+    } else {
+        sendResponseHeaders(client, "400 Bad Request", "application/json");
+        client.println("{\"status\":\"error\",\"message\":\"Invalid body or channel value\"}");
+    }
+}
+
+static_assert(CHANNEL_COUNT <= BATCH_WRITE_MAX, "A channel map write must fit in one batch");
+
+bool WebServerManager::parseJSONChannels(const char* body, size_t length, ChannelWrite* writes, uint8_t* count) {
+    StaticJsonDocument<512> doc;
+    if (deserializeJson(doc, body, length)) return false;
+    
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        ChannelId id = (ChannelId)i;
+        const ChannelDefinition& channel = CHANNELS[i];
+        if (!doc.containsKey(channel.key)) continue;
+        
+        float number;
+        if (!parseJSONValue(id, doc[channel.key], &number)) return false;
+        writes[(*count)++] = {id, number};
+    }
+    return true;
+}
+
+// A channel value as the CBOR decoder takes it: a number or a boolean, or a
+// state name for multi-state channels. Anything else is rejected rather than
+// read as 0, as as<float>() would for a string, an array or an object.
+bool WebServerManager::parseJSONValue(ChannelId id, JsonVariant value, float* number) {
+    if (value.is<const char*>()) {
+        int state = deviceManager->findState(id, value.as<const char*>());
+        if (state < 0) return false;
+        *number = state;
+    } else if (value.is<bool>()) {
+        *number = value.as<bool>() ? 1 : 0;
+    } else if (value.is<float>()) {
+        *number = value.as<float>();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Unknown keys are skipped, as the JSON decoder ignores unknown names
+bool WebServerManager::parseCBORChannels(const uint8_t* body, size_t length, ChannelWrite* writes, uint8_t* count) {
+    CborReader reader(body, length);
+    uint32_t pairs;
+    if (!reader.readMap(&pairs)) return false;
+    
+    for (uint32_t i = 0; i < pairs; i++) {
+        uint32_t key;
+        if (!reader.readUnsigned(&key)) return false;
+        if (key >= CHANNEL_COUNT) {
+            if (!reader.skip()) return false;
+            continue;
+        }
+        if (*count == BATCH_WRITE_MAX) return false;
+        
+        ChannelId id = (ChannelId)key;
+        float number;
+        if (CHANNELS[id].kind == CHANNEL_MULTISTATE && reader.peekType() == CBOR_TEXT) {
+            char stateName[16];
+            int state = reader.readText(stateName, sizeof(stateName)) ? deviceManager->findState(id, stateName) : -1;
+            if (state < 0) return false;
+            number = state;
+        } else if (!reader.readNumber(&number)) {
+            return false;
+        }
+        writes[(*count)++] = {id, number};
+    }
+    return reader.atEnd();
+}
+
+// POST /api/batch with an ordered list of writes, applied all or nothing:
+//   JSON [{"channel": "<channel key>", "value": value}, ...]
+//   CBOR [[<channel key>, value], ...] with the integer keys of ApiSchema.h
+// Multi-state values may be names or indexes; a later write to the same channel wins.
+void WebServerManager::handleBatch(WiFiClient& client, const char* body, size_t length, const RequestFormat& format) {
+    ChannelWrite writes[BATCH_WRITE_MAX];
+    uint8_t count = 0;
+    bool parsed = format.contentType == API_FORMAT_CBOR ? parseCBORBatch((const uint8_t*)body, length, writes, &count)
+                                                        : parseJSONBatch(body, length, writes, &count);
+    uint8_t failedIndex = count; // Parsing stops at the first write it cannot read
+    bool valid = parsed && deviceManager->applyBatch(writes, count, &failedIndex);
+    
+    if (format.accept == API_FORMAT_CBOR) {
+        sendResponseHeaders(client, valid ? "204 No Content" : "400 Bad Request", nullptr);
+    } else if (valid) {
+        sendResponseHeaders(client, "200 OK", "application/json");
+        client.printf("{\"status\":\"success\",\"applied\":%u}\r\n", count);
+    } else {
+        sendResponseHeaders(client, "400 Bad Request", "application/json");
+        client.printf("{\"status\":\"error\",\"message\":\"Invalid write, nothing applied\",\"index\":%u}\r\n", failedIndex);
+    }
+}
+
+bool WebServerManager::parseJSONBatch(const char* body, size_t length, ChannelWrite* writes, uint8_t* count) {
+    StaticJsonDocument<1024> doc;
+    if (deserializeJson(doc, body, length) || !doc.is<JsonArray>()) return false;
+    
+    for (JsonVariant write : doc.as<JsonArray>()) {
+        if (*count == BATCH_WRITE_MAX) return false;
+        ChannelId id = DeviceManager::findChannel(write["channel"] | "");
+        JsonVariant value = write["value"];
+        if (id == CHANNEL_NONE || value.isNull()) return false;
+        
+        float number;
+        if (!parseJSONValue(id, value, &number)) return false;
+        writes[(*count)++] = {id, number};
+    }
+    return true;
+}
+
+bool WebServerManager::parseCBORBatch(const uint8_t* body, size_t length, ChannelWrite* writes, uint8_t* count) {
+    CborReader reader(body, length);
+    uint32_t items;
+    if (!reader.readArray(&items)) return false;
+    
+    for (uint32_t i = 0; i < items; i++) {
+        uint32_t pairLength;
+        uint32_t key;
+        if (*count == BATCH_WRITE_MAX || !reader.readArray(&pairLength) || pairLength != 2 ||
+            !reader.readUnsigned(&key) || key >= CHANNEL_COUNT) return false;
+        
+        ChannelId id = (ChannelId)key;
+        float number;
+        if (reader.peekType() == CBOR_TEXT) {
+            char stateName[16];
+            int state = reader.readText(stateName, sizeof(stateName)) ? deviceManager->findState(id, stateName) : -1;
+            if (state < 0) return false;
+            number = state;
+        } else if (!reader.readNumber(&number)) {
+            return false;
+        }
+        writes[(*count)++] = {id, number};
+    }
+    return reader.atEnd();
+}
+
+// No Content-Type line when contentType is null
+void WebServerManager::sendResponseHeaders(WiFiClient& client, const char* status, const char* contentType) {
+    client.printf("HTTP/1.1 %s\r\n", status);
+    if (contentType != nullptr) {
+        client.printf("Content-Type: %s\r\n", contentType);
+    }
+    client.println("Connection: close");
+    client.println();
+}
+
+// Consumes the remaining request headers, picking out the body and response encodings
+RequestFormat WebServerManager::readRequestHeaders(WiFiClient& client) {
+    RequestFormat format = {API_FORMAT_JSON, API_FORMAT_JSON, -1};
+    char header[HTTP_HEADER_LINE_MAX];
+    while (client.connected() || client.available()) {
+        if (readLine(client, header, sizeof(header)) == 0) break;
+        if (strncasecmp(header, "Content-Length:", 15) == 0) {
+            format.contentLength = atol(header + 15);
+            continue;
+        }
+        
+        if (strncasecmp(header, "Accept:", 7) == 0) {
+            format.accept = negotiateFormat(header + 7);
+        } else if (strncasecmp(header, "Content-Type:", 13) == 0) {
+            const char* value = header + 13;
+            format.contentType = isMediaType(value, value + strlen(value), "application/cbor") ? API_FORMAT_CBOR
+                                                                                                 : API_FORMAT_JSON;
+        }
+    }
+    return format;
+}
+
+// Reads a Content-Length body, waiting up to HTTP_REQUEST_TIMEOUT for each
+// segment. Returns the body length; a missing, negative or oversized
+// Content-Length reads nothing, so the body fails to parse.
+size_t WebServerManager::readRequestBody(WiFiClient& client, char* buffer, size_t size, long contentLength) {
+    if (contentLength <= 0 || (size_t)contentLength > size) return 0;
+    return client.readBytes(buffer, contentLength);
+}
+
+// One CRLF-terminated line without its line ending, truncated to size - 1
+// characters; returns its length
+size_t WebServerManager::readLine(WiFiClient& client, char* buffer, size_t size) {
+    size_t length = client.readBytesUntil('\n', buffer, size - 1);
+    if (length == size - 1) {
+        // The rest of a long line is dropped rather than read as further lines
+        char discarded;
+        while (client.readBytes(&discarded, 1) == 1 && discarded != '\n') {}
+    }
+    if (length > 0 && buffer[length - 1] == '\r') length--;
+    buffer[length] = '\0';
+    return length;
+}
@@ -8,12 +8,33 @@
 #include "Config.h"
 #include "DeviceManager.h"
 #include "BACnet_ESP8266.h"
+#include "ApiSchema.h"
+#include "Cbor.h"
+
+// A status request held open until the state moves past since or the wait ends
+struct PendingPoll {
+    bool active;
+    WiFiClient client;
+    uint32_t since;
+    ApiFormat format;
+    unsigned long started;
+    unsigned long wait;
+};
+
+// What the request headers say about the body and the wanted response
+struct RequestFormat {
+    ApiFormat accept;      // application/cbor when listed in Accept, JSON otherwise
+    ApiFormat contentType;
+    long contentLength;    // -1 when the request has no Content-Length
+};
 
 class WebServerManager {
 private:
     WiFiServer server;
     DeviceManager* deviceManager;
     BACnet_ESP8266* bacnetController;
+    PendingPoll polls[LONG_POLL_MAX_CLIENTS] = {};
+    uint32_t bootId = 0; // Random per boot, so clients can tell a restart from an old version
     
 public:
     WebServerManager(DeviceManager* dm, BACnet_ESP8266* bacnet) 
@@ -24,11 +45,24 @@ public:
     
 private:
     void sendMainPage(WiFiClient& client);
-    void sendJSONStatus(WiFiClient& client);
-    void handleLightControl(WiFiClient& client, const String& body);
-    void handleACControl(WiFiClient& client, const String& body);
-    void handleTemperatureControl(WiFiClient& client, const String& body);
-    String getHTMLContent();
+    void sendStatus(WiFiClient& client, ApiFormat format, uint32_t since);
+    void sendJSONStatus(WiFiClient& client, uint32_t since);
+    void sendCBORStatus(WiFiClient& client, uint32_t since);
+    bool holdStatusRequest(WiFiClient& client, ApiFormat format, uint32_t since, unsigned long wait);
+    void servicePendingPolls();
+    void sendPollBusy(WiFiClient& client);
+    uint32_t getStatusField(StatusField field);
+    void handleChannelControl(WiFiClient& client, const char* body, size_t length, const RequestFormat& format);
+    bool parseJSONValue(ChannelId id, JsonVariant value, float* number);
+    bool parseJSONChannels(const char* body, size_t length, ChannelWrite* writes, uint8_t* count);
+    bool parseCBORChannels(const uint8_t* body, size_t length, ChannelWrite* writes, uint8_t* count);
+    void handleBatch(WiFiClient& client, const char* body, size_t length, const RequestFormat& format);
+    bool parseJSONBatch(const char* body, size_t length, ChannelWrite* writes, uint8_t* count);
+    bool parseCBORBatch(const uint8_t* body, size_t length, ChannelWrite* writes, uint8_t* count);
+    void sendResponseHeaders(WiFiClient& client, const char* status, const char* contentType);
+    RequestFormat readRequestHeaders(WiFiClient& client);
+    size_t readRequestBody(WiFiClient& client, char* buffer, size_t size, long contentLength);
+    size_t readLine(WiFiClient& client, char* buffer, size_t size);
 };
 
 #endif
\ No newline at end of file
@@ -3,38 +3,137 @@
 
 #include <ESP8266WiFi.h>
 #include "Config.h"
+#include "StringGuard.h"
+
+enum WiFiConnectionState {
+    WIFI_STATE_IDLE,
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_BACKOFF
+};
+
+typedef void (*WiFiLinkCallback)(bool connected);
 
 class WiFiManager {
+private:
+    WiFiConnectionState state = WIFI_STATE_IDLE;
+    unsigned long attemptStartTime = 0;
+    unsigned long backoffStartTime = 0;
+    unsigned long retryDelay = WIFI_RETRY_MIN_DELAY;
+    
+    // Last good access point, reused to skip the channel scan
+    uint8_t cachedBssid[6] = {0};
+    int32_t cachedChannel = 0;
+    bool hasCachedAccessPoint = false;
+    bool fastAttempt = false;
+    
+    volatile bool gotIpEvent = false;
+    volatile bool disconnectedEvent = false;
+    WiFiEventHandler gotIpHandler;
+    WiFiEventHandler disconnectedHandler;
+    
+    WiFiLinkCallback linkCallbacks[WIFI_MAX_LINK_CALLBACKS];
+    uint8_t linkCallbackCount = 0;
+
 public:
-    bool connect() {
-        Serial.println("\n Connecting to WiFi: " + String(WIFI_SSID));
+    // Starts connecting in the background; progress is driven by handle()
+    void begin() {
+        Serial.printf("\n Connecting to WiFi: %s\n", WIFI_SSID);
         
-        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        WiFi.persistent(false);
+        WiFi.setAutoReconnect(false);
+        WiFi.mode(WIFI_STA);
         
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(1000);
-            Serial.print(".");
-            attempts++;
-        }
+        gotIpHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& event) {
+            gotIpEvent = true;
+        });
+        disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& event) {
+            disconnectedEvent = true;
+        });
         
-        if (WiFi.status() == WL_CONNECTED) {
-            Serial.println("\n WiFi connected!");
-            Serial.println(" IP address: " + WiFi.localIP().toString());
-            return true;
-        } else {
-            Serial.println("\n WiFi connection failed!");
-            return false;
+        startAttempt();
+    }
+    
+    void handle() {
+        bool gotIp = gotIpEvent;
+        bool disconnected = disconnectedEvent;
+        gotIpEvent = false;
+        disconnectedEvent = false;
+        
+        switch (state) {
+            case WIFI_STATE_CONNECTING:
+                if (gotIp || WiFi.status() == WL_CONNECTED) {
+                    state = WIFI_STATE_CONNECTED;
+                    retryDelay = WIFI_RETRY_MIN_DELAY;
+                    memcpy(cachedBssid, WiFi.BSSID(), sizeof(cachedBssid));
+                    cachedChannel = WiFi.channel();
+                    hasCachedAccessPoint = true;
+                    
+                    Serial.printf("\n WiFi connected in %lu ms%s\n", millis() - attemptStartTime,
+                                  fastAttempt ? " (fast reconnect)" : "");
+                    Serial.printf(" IP address: " IP_FORMAT "\n", IP_ARGS(WiFi.localIP()));
+                    notifyLinkState(true);
+                } else if (millis() - attemptStartTime > (fastAttempt ? WIFI_FAST_CONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT)) {
+                    Serial.println("\n WiFi connection attempt timed out");
+                    if (fastAttempt) hasCachedAccessPoint = false;
+                    WiFi.disconnect();
+                    state = WIFI_STATE_BACKOFF;
+                    backoffStartTime = millis() - random(retryDelay / 4 + 1);
+                }
+                break;
+                
+            case WIFI_STATE_CONNECTED:
+                if (disconnected || WiFi.status() != WL_CONNECTED) {
+                    Serial.println(" WiFi link lost, reconnecting (local control stays active)");
+                    notifyLinkState(false);
+                    startAttempt();
+                }
+                break;
+                
+            case WIFI_STATE_BACKOFF:
+                if (millis() - backoffStartTime >= retryDelay) {
+                    retryDelay = min(retryDelay * 2, WIFI_RETRY_MAX_DELAY);
+                    startAttempt();
+                }
+                break;
+                
+            case WIFI_STATE_IDLE:
+                break;
         }
     }
     
-    String getIPAddress() {
-        return WiFi.localIP().toString();
+    void onLinkStateChange(WiFiLinkCallback callback) {
+        if (linkCallbackCount < WIFI_MAX_LINK_CALLBACKS) {
+            linkCallbacks[linkCallbackCount++] = callback;
+        }
+    }
+    
+    IPAddress getIPAddress() {
+        return WiFi.localIP();
     }
     
     bool isConnected() {
-        return WiFi.status() == WL_CONNECTED;
+        return state == WIFI_STATE_CONNECTED;
+    }
+
+private:
+    void startAttempt() {
+        state = WIFI_STATE_CONNECTING;
+        attemptStartTime = millis();
+        fastAttempt = hasCachedAccessPoint;
+        
+        if (fastAttempt) {
+            WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cachedChannel, cachedBssid);
+        } else {
+            WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        }
+    }
+    
+    void notifyLinkState(bool connected) {
+        for (uint8_t i = 0; i < linkCallbackCount; i++) {
+            linkCallbacks[i](connected);
+        }
     }
 };
 
-#endif
\ No newline at end of file
+#endif
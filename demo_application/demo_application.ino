@@ -1,3 +1,10 @@
+#include <ESP8266WiFi.h>
+#include <WiFiServer.h>
+#include <WiFiClient.h>
+#include <WiFiUdp.h>
+#include <ArduinoJson.h>
+#include <Ticker.h>
+#include "StringGuard.h"
 #include "Config.h"
 #include "WiFiManager.h"
 #include "DeviceManager.h"
@@ -16,23 +23,28 @@ void setup() {
     
     Serial.println("\n Starting BACnet ESP8266 Building Controller...");
     
-    // Connect to WiFi
-    if (!wifiManager.connect()) {
-        Serial.println(" Failed to connect to WiFi. System halted.");
-        while(1) delay(1000);
-    }
+    // Outputs first, so they hold their defaults while the network comes up
+    deviceManager.begin();
+    
+    // Connect to WiFi in the background; control keeps running while the link is down
+    wifiManager.onLinkStateChange(onNetworkLinkChange);
+    wifiManager.begin();
     
     // Initialize BACnet controller
     if (bacnetController.begin(BACNET_DEVICE_INSTANCE)) {
         Serial.println(" BACnet controller initialized");
         
-        // Create BACnet objects for building automation
-        bacnetController.addObject(BACNET_OBJECT_BINARY_OUTPUT, LIGHT_OBJECT_ID, "Light_Switch", 0.0);
-        bacnetController.addObject(BACNET_OBJECT_ANALOG_OUTPUT, LIGHT_BRIGHTNESS_OBJECT_ID, "Light_Brightness", 0.0);
-        bacnetController.addObject(BACNET_OBJECT_ANALOG_INPUT, TEMPERATURE_OBJECT_ID, "Room_Temperature", 22.0);
-        bacnetController.addObject(BACNET_OBJECT_BINARY_OUTPUT, AC_STATE_OBJECT_ID, "AC_State", 0.0);
-        bacnetController.addObject(BACNET_OBJECT_ANALOG_OUTPUT, AC_MODE_OBJECT_ID, "AC_Mode", 1.0);
-        bacnetController.addObject(BACNET_OBJECT_ANALOG_OUTPUT, FAN_SPEED_OBJECT_ID, "Fan_Speed", 2.0);
+        // Create one BACnet object per device channel
+        for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+            const ChannelDefinition& channel = CHANNELS[i];
+            if (channel.kind == CHANNEL_MULTISTATE) {
+                bacnetController.addMultiStateObject(channel.objectType, channel.objectId, channel.objectName,
+                                                     channel.stateText, channel.maxValue + 1, channel.defaultValue + 1);
+            } else {
+                bacnetController.addObject(channel.objectType, channel.objectId, channel.objectName, channel.defaultValue);
+            }
+        }
+        bacnetController.onWrite(onBACnetWrite);
         
         Serial.println(" BACnet objects created");
     } else {
@@ -41,28 +53,42 @@ void setup() {
     
     // Start web server
     webServer.begin();
-    Serial.println(" Web interface ready: http://" + WiFi.localIP().toString());
-    Serial.println(" BACnet Device ID: " + String(BACNET_DEVICE_INSTANCE));
+    Serial.printf(" BACnet Device ID: %lu\n", (unsigned long)BACNET_DEVICE_INSTANCE);
     Serial.println(" System fully initialized and ready!");
 }
 
 void loop() {
+    // Keep the network link up
+    wifiManager.handle();
+    
     // Handle BACnet communications
     bacnetController.update();
     
-    // Update BACnet objects with current device states
-    DeviceState currentState = deviceManager.getState();
-    bacnetController.updateBuildingObjects(
-        currentState.lightState,
-        currentState.lightBrightness,
-        currentState.temperature,
-        currentState.acState,
-        currentState.acMode,
-        currentState.fanSpeed
-    );
+    // Push only the channels that changed to their BACnet objects
+    uint32_t changes = deviceManager.takeChanges();
+    for (uint8_t i = 0; changes != 0; i++, changes >>= 1) {
+        if (changes & 1) {
+            bacnetController.setPresentValue(CHANNELS[i].objectId, deviceManager.getBACnetValue((ChannelId)i));
+        }
+    }
     
     // Handle web clients
     webServer.handleClient();
     
     delay(100);
+}
+
+void onBACnetWrite(uint32_t objectId, float value) {
+    ChannelId id = DeviceManager::findChannelByObject(objectId);
+    if (id != CHANNEL_NONE) {
+        deviceManager.setBACnetValue(id, value);
+    }
+}
+
+void onNetworkLinkChange(bool connected) {
+    if (connected) {
+        Serial.printf(" Web interface ready: http://" IP_FORMAT "\n", IP_ARGS(wifiManager.getIPAddress()));
+    } else {
+        Serial.println(" Network down - web interface unavailable until reconnect");
+    }
 }
\ No newline at end of file